@@ -37,6 +37,7 @@
 #include "stdio_base.h"
 #include "cli.h"
 #include "vfs.h"
+#include "vfs_aio.h"
 #include "sdcard_monitor.h"
 #include "usb_host_monitor.h"
 #include "cwd.h"
@@ -72,6 +73,7 @@ void vApplicationDaemonTaskStartupHook(void)
     rtc_init();
     vfs_init();
     vfs_bind_stdio();
+    vfs_aio_init();
     setvbuf(stdin, NULL, _IONBF, 0);
     sdcard_monitor_init();
     usb_host_monitor_init();
@@ -0,0 +1,129 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     simulator
+ * @{
+ * @file        commands.c
+ * @brief       Host variants of the CLI commands that depend on the MCU
+ *
+ * sysinfo.c and memstat.c read the STM32 device registers and linker
+ * symbols, they are replaced by these implementations in the simulator.
+ */
+#include "embedded_cli.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+extern uint32_t uxTaskGetStackSize(TaskHandle_t xTask);
+
+/**
+ * @brief Function that is executed when the sysinfo command is entered.
+ *        Displays information about the host running the simulator.
+ *
+ * @param cli     Pointer to the EmbeddedCli instance (unused).
+ * @param args    Pointer to the command arguments (unused).
+ * @param context Pointer to the context (unused).
+ */
+void cli_command_sysinfo(EmbeddedCli *cli, char *args, void *context)
+{
+    (void)cli;
+    (void)args;
+    (void)context;
+
+    struct utsname host;
+
+    if (0 != uname(&host))
+    {
+        printf("  Host information is not available.\r\n");
+        return;
+    }
+
+    printf("\r\n  F469Platform host simulator\r\n\r\n");
+    printf("    System     : %s %s\r\n", host.sysname, host.release);
+    printf("    Machine    : %s\r\n", host.machine);
+    printf("    Node       : %s\r\n", host.nodename);
+    printf("    PID        : %ld\r\n", (long)getpid());
+    printf("    Tick rate  : %lu Hz\r\n", (unsigned long)configTICK_RATE_HZ);
+}
+
+/**
+ * @brief Function that is executed when the memstat command is entered.
+ *        Displays the state of the FreeRTOS heap and the task stacks.
+ *
+ * @param cli     Pointer to the EmbeddedCli instance (unused).
+ * @param args    Pointer to the command arguments (unused).
+ * @param context Pointer to the context (unused).
+ */
+void cli_command_memstat(EmbeddedCli *cli, char *args, void *context)
+{
+    (void)cli;
+    (void)args;
+    (void)context;
+
+    const size_t size = configTOTAL_HEAP_SIZE;
+    HeapStats_t stats;
+    vPortGetHeapStats(&stats);
+
+    printf("\r\n  System (FreeRTOS) Heap statistics:\r\n\r\n");
+    printf("       Size     |     Used     |     Free     |    Used  %% |    Free  %% \r\n");
+    printf("  --------------+--------------+--------------+------------+------------\r\n");
+    printf("   %10zu B | %10zu B | %10zu B | %8.4f %% | %8.4f %%\r\n",
+           size,
+           size - stats.xAvailableHeapSpaceInBytes,
+           stats.xAvailableHeapSpaceInBytes,
+           100.0f * ((float)(size - stats.xAvailableHeapSpaceInBytes) / (float)size),
+           100.0f * ((float)stats.xAvailableHeapSpaceInBytes / (float)size));
+
+    const UBaseType_t number_of_tasks = uxTaskGetNumberOfTasks();
+    TaskStatus_t *tasks = pvPortMalloc(number_of_tasks * sizeof(TaskStatus_t));
+
+    if (NULL == tasks)
+    {
+        printf("  Not enough memory.\r\n");
+        return;
+    }
+
+    printf("\r\n\r\n  FreeRTOS tasks stack usage statistics:\r\n\r\n");
+    printf("  ID |      Name       | Stack size |    Free    |   Used %% \r\n");
+    printf("  ---+-----------------+------------+------------+----------\r\n");
+
+    uxTaskGetSystemState(tasks, number_of_tasks, NULL);
+
+    for (UBaseType_t i = 0; i < number_of_tasks; i++)
+    {
+        const uint32_t stack_size = uxTaskGetStackSize(tasks[i].xHandle);
+        const uint32_t free = tasks[i].usStackHighWaterMark * sizeof(StackType_t);
+        const float stack_usage = 100.0f * ((float)(stack_size - free) / (float)stack_size);
+        printf("  %2lu | %-15s | %8lu B | %8lu B | %6.2f %%\r\n",
+               (unsigned long)tasks[i].xTaskNumber, tasks[i].pcTaskName,
+               (unsigned long)stack_size, (unsigned long)free, stack_usage);
+    }
+
+    vPortFree(tasks);
+}
+/** @} */
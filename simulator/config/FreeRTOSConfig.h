@@ -0,0 +1,108 @@
+/**
+ * @ingroup    simulator
+ * @{
+ * @file       FreeRTOSConfig.h
+ * @brief      FreeRTOS configuration options for the POSIX/Linux port
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+/*-----------------------------------------------------------
+ * Application specific definitions.
+ *
+ * This file mirrors core/config/FreeRTOSConfig.h for the host simulator.
+ * The differences are the ones required by the POSIX port: every task is
+ * backed by a pthread, so stacks must be at least PTHREAD_STACK_MIN bytes,
+ * there are no interrupt priorities and the run time counter is taken from
+ * the host monotonic clock.
+ *
+ * See http://www.freertos.org/a00110.html
+ *----------------------------------------------------------*/
+
+#include <stdint.h>
+
+#define configUSE_PREEMPTION                          ( 1 )
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION       ( 0 )
+#define configUSE_TICKLESS_IDLE                       ( 0 )
+#define configTICK_RATE_HZ                            ( (TickType_t)1000 )
+#define configMAX_PRIORITIES                          ( 10 )
+#define configMINIMAL_STACK_SIZE                      ( (uint16_t)2048 )
+#define configMAX_TASK_NAME_LEN                       ( 16 )
+#define configUSE_16_BIT_TICKS                        ( 0 )
+#define configIDLE_SHOULD_YIELD                       ( 1 )
+#define configUSE_TASK_NOTIFICATIONS                  ( 1 )
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES         ( 4 )
+#define configUSE_MUTEXES                             ( 1 )
+#define configUSE_RECURSIVE_MUTEXES                   ( 1 )
+#define configUSE_COUNTING_SEMAPHORES                 ( 1 )
+#define configUSE_ALTERNATIVE_API                     ( 0 )
+#define configQUEUE_REGISTRY_SIZE                     ( 8 )
+#define configUSE_QUEUE_SETS                          ( 0 )
+#define configUSE_TIME_SLICING                        ( 1 )
+#define configUSE_NEWLIB_REENTRANT                    ( 0 )
+#define configENABLE_BACKWARD_COMPATIBILITY           ( 0 )
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS       ( 5 )
+#define configSTACK_DEPTH_TYPE                        uint32_t
+#define configMESSAGE_BUFFER_LENGTH_TYPE              size_t
+#define configRECORD_STACK_HIGH_ADDRESS               ( 1 )
+#define configINCLUDE_FREERTOS_TASK_C_ADDITIONS_H     ( 1 )
+
+/* Memory allocation related definitions. */
+#define configSUPPORT_STATIC_ALLOCATION               ( 1 )
+#define configSUPPORT_DYNAMIC_ALLOCATION              ( 1 )
+#define configTOTAL_HEAP_SIZE                         ( (size_t)(4 * 1024 * 1024) )
+#define configAPPLICATION_ALLOCATED_HEAP              ( 0 )
+#define configSTACK_ALLOCATION_FROM_SEPARATE_HEAP     ( 0 )
+
+/* Hook function related definitions. */
+#define configUSE_IDLE_HOOK                           ( 0 )
+#define configUSE_TICK_HOOK                           ( 0 )
+#define configCHECK_FOR_STACK_OVERFLOW                ( 0 )
+#define configUSE_MALLOC_FAILED_HOOK                  ( 1 )
+#define configUSE_DAEMON_TASK_STARTUP_HOOK            ( 1 )
+
+/* Run time and task stats gathering related definitions. */
+#define configGENERATE_RUN_TIME_STATS                 ( 1 )
+#define configUSE_TRACE_FACILITY                      ( 1 )
+#define configUSE_STATS_FORMATTING_FUNCTIONS          ( 1 )
+
+extern uint32_t simulator_get_run_time_counter(void);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()              simulator_get_run_time_counter()
+
+/* Co-routine related definitions. */
+#define configUSE_CO_ROUTINES                         ( 0 )
+#define configMAX_CO_ROUTINE_PRIORITIES               ( 1 )
+
+/* Software timer related definitions. */
+#define configUSE_TIMERS                              ( 1 )
+#define configTIMER_TASK_PRIORITY                     ( configMAX_PRIORITIES - 1 )
+#define configTIMER_QUEUE_LENGTH                      ( 10 )
+#define configTIMER_TASK_STACK_DEPTH                  ( configMINIMAL_STACK_SIZE * 2)
+
+/* Define to trap errors during development. */
+#include <assert.h>
+#define configASSERT( x )                             assert( ( x ) )
+
+/* Optional functions - most linkers will remove unused functions anyway. */
+#define INCLUDE_vTaskPrioritySet                      ( 1 )
+#define INCLUDE_uxTaskPriorityGet                     ( 1 )
+#define INCLUDE_vTaskDelete                           ( 1 )
+#define INCLUDE_vTaskSuspend                          ( 1 )
+#define INCLUDE_xTaskDelayUntil                       ( 1 )
+#define INCLUDE_vTaskDelay                            ( 1 )
+#define INCLUDE_xTaskGetSchedulerState                ( 1 )
+#define INCLUDE_xTaskGetCurrentTaskHandle             ( 1 )
+#define INCLUDE_uxTaskGetStackHighWaterMark           ( 1 )
+#define INCLUDE_uxTaskGetStackHighWaterMark2          ( 1 )
+#define INCLUDE_xTaskGetIdleTaskHandle                ( 1 )
+#define INCLUDE_eTaskGetState                         ( 1 )
+#define INCLUDE_xTimerPendFunctionCall                ( 0 )
+#define INCLUDE_xTaskAbortDelay                       ( 1 )
+#define INCLUDE_xTaskGetHandle                        ( 1 )
+#define INCLUDE_xTaskResumeFromISR                    ( 1 )
+#define INCLUDE_xQueueGetMutexHolder                  ( 1 )
+
+#endif /* FREERTOS_CONFIG_H */
+/** @} */
@@ -0,0 +1,39 @@
+/**
+ * @ingroup    simulator
+ *
+ * @{
+ * @file       simulator_config.h
+ * @brief      Host simulator configuration options
+ *
+ */
+#ifndef __SIMULATOR_CONFIG_H__
+#define __SIMULATOR_CONFIG_H__
+
+/**
+ * @brief Definitions for the file-backed MTD device and its mount point
+ */
+#define SIMULATOR_DISK_IMAGE_PATH             "sdcard.img"
+#define SIMULATOR_DISK_IMAGE_SIZE             (64ul * 1024ul * 1024ul)
+#define SIMULATOR_DISK_MOUNT_PATH             "/sd"
+
+/**
+ * @brief Definitions for the STDIO PTY task priority, stack and buffer sizes
+ */
+#define STDIO_PTY_READ_TASK_PRIORITY          4ul
+#define STDIO_PTY_READ_TASK_STACKSIZE         configMINIMAL_STACK_SIZE
+#define STDIO_PTY_READ_BUFFER_SIZE            64ul
+#define STDIO_PTY_POLL_PERIOD_MS              1ul
+
+/**
+ * @brief Definitions for the simulated SDIO. The task plays the role of the
+ *        SDIO / DMA hardware, the card holds D0 low (busy) for the given
+ *        number of ticks after a write and an erase command.
+ */
+#define SDIO_SIM_TASK_PRIORITY                (configMAX_PRIORITIES - 1)
+#define SDIO_SIM_TASK_STACKSIZE               (configMINIMAL_STACK_SIZE * 2)
+#define SDIO_SIM_QUEUE_LENGTH                 2ul
+#define SDIO_SIM_PROGRAMMING_TICKS            1ul
+#define SDIO_SIM_ERASE_TICKS                  2ul
+
+#endif /* __SIMULATOR_CONFIG_H__ */
+/** @} */
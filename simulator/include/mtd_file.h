@@ -0,0 +1,74 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     simulator_mtd_file
+ * @brief       MTD driver backed by a disk image file on the host
+ *
+ * @{
+ *
+ * @file        mtd_file.h
+ * @brief       Interface definition for the mtd_file driver
+ *
+ */
+#ifndef __MTD_FILE_H__
+#define __MTD_FILE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mtd.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Page size of the emulated device, matches the SD-HC block size
+ */
+#define MTD_FILE_PAGE_SIZE   (512ul)
+
+/**
+ * @brief   Device descriptor for mtd_file device
+ *
+ * This is an extension of the @c mtd_dev_t struct
+ */
+typedef struct {
+    mtd_dev_t base;     /**< inherit from mtd_dev_t object */
+    const char *path;   /**< path of the backing disk image */
+    size_t size;        /**< size of the disk image in bytes, the image is created
+                             (or grown) to this size on init. 0 uses the size of
+                             an already existing image */
+    int fd;             /**< file descriptor of the opened disk image */
+} mtd_file_t;
+
+/**
+ * @brief   mtd_file device operations table for mtd
+ */
+extern const mtd_desc_t mtd_file_driver;
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __MTD_FILE_H__ */
+/** @} */
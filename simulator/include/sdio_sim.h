@@ -0,0 +1,101 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     simulator_sdio
+ * @brief       Simulated SDIO peripheral and SD card backed by a disk image file
+ *
+ * @{
+ *
+ * @file        sdio_sim.h
+ * @brief       Interface definition for the simulated SDIO
+ *
+ */
+#ifndef __SDIO_SIM_H__
+#define __SDIO_SIM_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Command counters of the simulated card
+ */
+typedef struct
+{
+    uint32_t reads;             /**< CMD17 / CMD18 */
+    uint32_t writes;            /**< CMD24 / CMD25 */
+    uint32_t erases;            /**< CMD38 */
+    uint32_t status_reads;      /**< CMD13 */
+    uint32_t pre_erase_hints;   /**< ACMD23 */
+    uint32_t busy_end_irqs;     /**< D0 rising edges signalled through the EXTI */
+    uint32_t illegal_cmds;      /**< data commands issued while the card was busy */
+    uint32_t crc_errors;        /**< transfers failed with a data CRC error */
+    uint32_t bus_clock_hz;      /**< current bus clock, not a counter */
+    uint8_t high_speed;         /**< the card is in High-Speed mode, not a counter */
+} sdio_sim_stats_t;
+
+/**
+ * @brief   Sets the disk image of the simulated card
+ *
+ * Takes effect when the card is identified, the image is created (or grown)
+ * to @p size bytes by HAL_SD_Init() and HAL_SD_InitCard(). Changing it while
+ * a card is initialized simulates a card swap. 0 uses the size of an
+ * already existing image.
+ *
+ * @param[in]  path  path of the disk image
+ * @param[in]  size  size of the card in bytes
+ */
+void sdio_sim_set_image(const char *path, size_t size);
+
+/**
+ * @brief   Sets the High-Speed capabilities of the simulated card
+ *
+ * @param[in]  supported   the card reports the High-Speed function in the
+ *                         CMD6 status and accepts the switch
+ * @param[in]  crc_errors  data transfers fail with a CRC error while the bus
+ *                         is clocked faster than 25 MHz
+ */
+void sdio_sim_set_high_speed(bool supported, bool crc_errors);
+
+/**
+ * @brief   Returns the command counters of the simulated card
+ *
+ * @param[out] stats  counters
+ */
+void sdio_sim_get_stats(sdio_sim_stats_t *stats);
+
+/**
+ * @brief   Clears the command counters of the simulated card
+ */
+void sdio_sim_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SDIO_SIM_H__ */
+/** @} */
@@ -0,0 +1,268 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     simulator_sdio
+ * @{
+ *
+ * @file        stm32f4xx_hal.h
+ * @brief       Host replacement of the STM32F4 HAL subset used by the SD Card driver
+ *
+ * Only the types, constants and functions referenced by system/sdcard/sdcard.c
+ * and the headers it includes are provided, with the values of the STM32F4
+ * HAL. The functions are implemented by the simulated SDIO (sdio_sim.c).
+ */
+#ifndef __STM32F4xx_HAL_H__
+#define __STM32F4xx_HAL_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    HAL_OK       = 0x00U,
+    HAL_ERROR    = 0x01U,
+    HAL_BUSY     = 0x02U,
+    HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+    EXTI9_5_IRQn        = 23,
+    SDIO_IRQn           = 49,
+    DMA2_Stream3_IRQn   = 59,
+    DMA2_Stream6_IRQn   = 69,
+} IRQn_Type;
+
+uint32_t HAL_GetTick(void);
+
+#define __REV(value)    __builtin_bswap32(value)
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+
+#define __HAL_RCC_SDIO_CLK_ENABLE()     do { } while (0)
+#define __HAL_RCC_SDIO_CLK_DISABLE()    do { } while (0)
+#define __HAL_RCC_SDIO_FORCE_RESET()    do { } while (0)
+#define __HAL_RCC_SDIO_RELEASE_RESET()  do { } while (0)
+
+/**
+ * @name    SDIO low level definitions
+ * @{
+ */
+typedef struct SDIO_TypeDef SDIO_TypeDef;
+
+extern SDIO_TypeDef *const sdio_sim_instance;
+#define SDIO                                sdio_sim_instance
+
+typedef struct
+{
+    uint32_t ClockEdge;
+    uint32_t ClockBypass;
+    uint32_t ClockPowerSave;
+    uint32_t BusWide;
+    uint32_t HardwareFlowControl;
+    uint32_t ClockDiv;
+} SDIO_InitTypeDef;
+
+typedef struct
+{
+    uint32_t DataTimeOut;
+    uint32_t DataLength;
+    uint32_t DataBlockSize;
+    uint32_t TransferDir;
+    uint32_t TransferMode;
+    uint32_t DPSM;
+} SDIO_DataInitTypeDef;
+
+typedef struct
+{
+    uint32_t Argument;
+    uint32_t CmdIndex;
+    uint32_t Response;
+    uint32_t WaitForInterrupt;
+    uint32_t CPSM;
+} SDIO_CmdInitTypeDef;
+
+#define SDIO_CLOCK_EDGE_RISING              0x00000000U
+#define SDIO_CLOCK_BYPASS_DISABLE           0x00000000U
+#define SDIO_CLOCK_BYPASS_ENABLE            0x00000400U
+#define SDIO_CLOCK_POWER_SAVE_DISABLE       0x00000000U
+#define SDIO_BUS_WIDE_1B                    0x00000000U
+#define SDIO_BUS_WIDE_4B                    0x00000800U
+#define SDIO_HARDWARE_FLOW_CONTROL_ENABLE   0x00004000U
+#define SDIO_TRANSFER_CLK_DIV               ((uint8_t)0x0)
+#define SDIO_RESPONSE_SHORT                 0x00000040U
+#define SDIO_WAIT_NO                        0x00000000U
+#define SDIO_CPSM_ENABLE                    0x00000400U
+#define SDIO_CMDTIMEOUT                     5000U
+#define SDMMC_DATATIMEOUT                   0xFFFFFFFFU
+#define SDIO_DATABLOCK_SIZE_8B              0x00000030U
+#define SDIO_DATABLOCK_SIZE_64B             0x00000060U
+#define SDIO_TRANSFER_DIR_TO_SDIO           0x00000002U
+#define SDIO_TRANSFER_MODE_BLOCK            0x00000000U
+#define SDIO_DPSM_ENABLE                    0x00000001U
+
+#define SDIO_FLAG_DCRCFAIL                  0x00000002U
+#define SDIO_FLAG_DTIMEOUT                  0x00000008U
+#define SDIO_FLAG_TXUNDERR                  0x00000010U
+#define SDIO_FLAG_RXOVERR                   0x00000020U
+#define SDIO_FLAG_DATAEND                   0x00000100U
+#define SDIO_FLAG_DBCKEND                   0x00000400U
+#define SDIO_FLAG_RXDAVL                    0x00200000U
+#define SDIO_STATIC_DATA_FLAGS              (SDIO_FLAG_DCRCFAIL | SDIO_FLAG_DTIMEOUT | SDIO_FLAG_TXUNDERR | \
+                                             SDIO_FLAG_RXOVERR | SDIO_FLAG_DATAEND | SDIO_FLAG_DBCKEND)
+
+#define SDMMC_CMD_SET_BLOCK_COUNT           23U
+
+HAL_StatusTypeDef SDIO_Init(SDIO_TypeDef *SDIOx, SDIO_InitTypeDef Init);
+HAL_StatusTypeDef SDIO_ConfigData(SDIO_TypeDef *SDIOx, SDIO_DataInitTypeDef *Data);
+uint32_t SDIO_ReadFIFO(SDIO_TypeDef *SDIOx);
+uint32_t SDIO_GetFlag(SDIO_TypeDef *SDIOx, uint32_t flag);
+void SDIO_ClearFlag(SDIO_TypeDef *SDIOx, uint32_t flag);
+HAL_StatusTypeDef SDIO_SendCommand(SDIO_TypeDef *SDIOx, SDIO_CmdInitTypeDef *Command);
+uint32_t SDMMC_CmdBlockLength(SDIO_TypeDef *SDIOx, uint32_t BlockSize);
+uint32_t SDMMC_CmdAppCommand(SDIO_TypeDef *SDIOx, uint32_t Argument);
+uint32_t SDMMC_CmdSendSCR(SDIO_TypeDef *SDIOx);
+uint32_t SDMMC_CmdSwitch(SDIO_TypeDef *SDIOx, uint32_t Argument);
+uint32_t SDMMC_GetCmdResp1(SDIO_TypeDef *SDIOx, uint8_t SD_CMD, uint32_t Timeout);
+/** @} */
+
+/**
+ * @name    SD definitions
+ * @{
+ */
+typedef uint32_t HAL_SD_CardStateTypeDef;
+
+#define HAL_SD_CARD_TRANSFER                0x00000004U
+#define HAL_SD_CARD_PROGRAMMING             0x00000007U
+
+#define HAL_SD_ERROR_NONE                   0x00000000U
+#define HAL_SD_ERROR_CMD_CRC_FAIL           0x00000001U
+#define HAL_SD_ERROR_DATA_CRC_FAIL          0x00000002U
+#define HAL_SD_ERROR_CMD_RSP_TIMEOUT        0x00000004U
+#define HAL_SD_ERROR_DATA_TIMEOUT           0x00000008U
+#define HAL_SD_ERROR_TX_UNDERRUN            0x00000010U
+#define HAL_SD_ERROR_RX_OVERRUN             0x00000020U
+#define HAL_SD_ERROR_ADDR_MISALIGNED        0x00000040U
+#define HAL_SD_ERROR_BLOCK_LEN_ERR          0x00000080U
+#define HAL_SD_ERROR_ERASE_SEQ_ERR          0x00000100U
+#define HAL_SD_ERROR_BAD_ERASE_PARAM        0x00000200U
+#define HAL_SD_ERROR_WRITE_PROT_VIOLATION   0x00000400U
+#define HAL_SD_ERROR_LOCK_UNLOCK_FAILED     0x00000800U
+#define HAL_SD_ERROR_COM_CRC_FAILED         0x00001000U
+#define HAL_SD_ERROR_ILLEGAL_CMD            0x00002000U
+#define HAL_SD_ERROR_CARD_ECC_FAILED        0x00004000U
+#define HAL_SD_ERROR_CC_ERR                 0x00008000U
+#define HAL_SD_ERROR_GENERAL_UNKNOWN_ERR    0x00010000U
+#define HAL_SD_ERROR_STREAM_READ_UNDERRUN   0x00020000U
+#define HAL_SD_ERROR_STREAM_WRITE_OVERRUN   0x00040000U
+#define HAL_SD_ERROR_CID_CSD_OVERWRITE      0x00080000U
+#define HAL_SD_ERROR_WP_ERASE_SKIP          0x00100000U
+#define HAL_SD_ERROR_CARD_ECC_DISABLED      0x00200000U
+#define HAL_SD_ERROR_ERASE_RESET            0x00400000U
+#define HAL_SD_ERROR_AKE_SEQ_ERR            0x00800000U
+#define HAL_SD_ERROR_INVALID_VOLTRANGE      0x01000000U
+#define HAL_SD_ERROR_ADDR_OUT_OF_RANGE      0x02000000U
+#define HAL_SD_ERROR_REQUEST_NOT_APPLICABLE 0x04000000U
+#define HAL_SD_ERROR_PARAM                  0x08000000U
+#define HAL_SD_ERROR_UNSUPPORTED_FEATURE    0x10000000U
+#define HAL_SD_ERROR_BUSY                   0x20000000U
+#define HAL_SD_ERROR_DMA                    0x40000000U
+#define HAL_SD_ERROR_TIMEOUT                0x80000000U
+
+#define CARD_SDHC_SDXC                      0x00000001U
+
+typedef struct
+{
+    uint32_t CardType;
+    uint32_t CardVersion;
+    uint32_t Class;
+    uint32_t RelCardAdd;
+    uint32_t BlockNbr;
+    uint32_t BlockSize;
+    uint32_t LogBlockNbr;
+    uint32_t LogBlockSize;
+} HAL_SD_CardInfoTypeDef;
+
+typedef enum
+{
+    HAL_SD_TX_CPLT_CB_ID    = 0x00U,
+    HAL_SD_RX_CPLT_CB_ID    = 0x01U,
+    HAL_SD_ERROR_CB_ID      = 0x02U,
+    HAL_SD_ABORT_CB_ID      = 0x03U,
+    HAL_SD_MSP_INIT_CB_ID   = 0x10U,
+    HAL_SD_MSP_DEINIT_CB_ID = 0x11U
+} HAL_SD_CallbackIDTypeDef;
+
+typedef struct __SD_HandleTypeDef
+{
+    SDIO_TypeDef *Instance;
+    SDIO_InitTypeDef Init;
+    volatile uint32_t ErrorCode;
+    HAL_SD_CardInfoTypeDef SdCard;
+
+    void (*TxCpltCallback)(struct __SD_HandleTypeDef *hsd);
+    void (*RxCpltCallback)(struct __SD_HandleTypeDef *hsd);
+    void (*ErrorCallback)(struct __SD_HandleTypeDef *hsd);
+    void (*AbortCpltCallback)(struct __SD_HandleTypeDef *hsd);
+    void (*MspInitCallback)(struct __SD_HandleTypeDef *hsd);
+    void (*MspDeInitCallback)(struct __SD_HandleTypeDef *hsd);
+} SD_HandleTypeDef;
+
+typedef void (*pSD_CallbackTypeDef)(SD_HandleTypeDef *hsd);
+
+#define __HAL_SD_GET_FLAG(__HANDLE__, __FLAG__)     (0U != SDIO_GetFlag((__HANDLE__)->Instance, (__FLAG__)))
+#define __HAL_SD_CLEAR_FLAG(__HANDLE__, __FLAG__)   SDIO_ClearFlag((__HANDLE__)->Instance, (__FLAG__))
+
+HAL_StatusTypeDef HAL_SD_Init(SD_HandleTypeDef *hsd);
+HAL_StatusTypeDef HAL_SD_InitCard(SD_HandleTypeDef *hsd);
+HAL_StatusTypeDef HAL_SD_DeInit(SD_HandleTypeDef *hsd);
+HAL_StatusTypeDef HAL_SD_RegisterCallback(SD_HandleTypeDef *hsd, HAL_SD_CallbackIDTypeDef CallbackID,
+                                          pSD_CallbackTypeDef pCallback);
+HAL_StatusTypeDef HAL_SD_UnRegisterCallback(SD_HandleTypeDef *hsd, HAL_SD_CallbackIDTypeDef CallbackID);
+HAL_StatusTypeDef HAL_SD_ConfigWideBusOperation(SD_HandleTypeDef *hsd, uint32_t WideMode);
+HAL_StatusTypeDef HAL_SD_GetCardInfo(SD_HandleTypeDef *hsd, HAL_SD_CardInfoTypeDef *pCardInfo);
+HAL_SD_CardStateTypeDef HAL_SD_GetCardState(SD_HandleTypeDef *hsd);
+HAL_StatusTypeDef HAL_SD_ReadBlocks_DMA(SD_HandleTypeDef *hsd, uint8_t *pData,
+                                        uint32_t BlockAdd, uint32_t NumberOfBlocks);
+HAL_StatusTypeDef HAL_SD_WriteBlocks_DMA(SD_HandleTypeDef *hsd, uint8_t *pData,
+                                         uint32_t BlockAdd, uint32_t NumberOfBlocks);
+HAL_StatusTypeDef HAL_SD_Erase(SD_HandleTypeDef *hsd, uint32_t BlockStartAdd, uint32_t BlockEndAdd);
+void HAL_SD_IRQHandler(SD_HandleTypeDef *hsd);
+/** @} */
+
+/**
+ * @brief   The UART is not simulated, only declared for dma.h
+ */
+typedef struct __UART_HandleTypeDef UART_HandleTypeDef;
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __STM32F4xx_HAL_H__ */
+/** @} */
@@ -0,0 +1,229 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     simulator
+ * @{
+ * @file        main.c
+ * @brief       Host simulator entry point
+ *
+ * Starts the FreeRTOS POSIX port with the same system services as the
+ * F469 application (stdio, rtc, vfs, cli, cwd) and mounts a FatFs volume
+ * from a disk image through the mtd_cache and mtd_file drivers, so the
+ * vfs_mount -> fatfs_file_system -> mtd_diskio -> mtd path can be exercised
+ * and profiled without a board. With -s the image is accessed through the
+ * mtd_sdcard driver and the SD Card driver running on the simulated SDIO
+ * instead.
+ *
+ * Usage: f469sim [-s] [disk image path] [disk image size in MiB]
+ */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "stdio_base.h"
+#include "rtc.h"
+#include "vfs.h"
+#include "vfs_aio.h"
+#include "cli.h"
+#include "cwd.h"
+#include "panic.h"
+
+#include "fs/fatfs.h"
+#include "mtd.h"
+#include "mtd_cache.h"
+#include "mtd_file.h"
+#include "mtd_sdcard.h"
+#include "sdio_sim.h"
+#include "simulator_config.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static fatfs_desc_t _fatfs_desc;
+static vfs_mount_t _fatfs_disk_vfs_mount = {
+    .mount_point = SIMULATOR_DISK_MOUNT_PATH,
+    .fs = &fatfs_file_system,
+    .private_data = (void *)&_fatfs_desc,
+};
+static mtd_file_t mtd_file = {
+    .base = {
+        .driver = &mtd_file_driver,
+    },
+    .path = SIMULATOR_DISK_IMAGE_PATH,
+    .size = SIMULATOR_DISK_IMAGE_SIZE,
+    .fd = -1,
+};
+static mtd_sdcard_t mtd_sdcard = {
+    .base = {
+        .driver = &mtd_sdcard_driver,
+    },
+};
+static mtd_cache_t mtd_cache = MTD_CACHE_INIT(&mtd_file.base);
+
+/* GetIdleTaskMemory prototype (linked to static allocation support) */
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                   StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize);
+
+/* GetTimerTaskMemory prototype (linked to static allocation support) */
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer,
+                                    StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize);
+
+/* Hook prototypes */
+void vApplicationMallocFailedHook(void);
+void vApplicationDaemonTaskStartupHook(void);
+
+static int disk_mount(void);
+
+int main(int argc, char *argv[])
+{
+    if ((argc > 1) && (0 == strcmp(argv[1], "-s")))
+    {
+        mtd_cache.parent = &mtd_sdcard.base;
+        argc--;
+        argv++;
+    }
+
+    if (argc > 1)
+    {
+        mtd_file.path = argv[1];
+    }
+
+    if (argc > 2)
+    {
+        mtd_file.size = strtoul(argv[2], NULL, 0) * 1024ul * 1024ul;
+    }
+
+    vTaskStartScheduler();
+
+    return EXIT_FAILURE;
+}
+
+void vApplicationDaemonTaskStartupHook(void)
+{
+    stdio_init();
+    rtc_init();
+    vfs_init();
+    vfs_bind_stdio();
+    vfs_aio_init();
+    disk_mount();
+    cli_init();
+    cwd_init();
+}
+
+void vApplicationMallocFailedHook(void)
+{
+    panic("\r\n Not enough memory in system heap. (malloc failed hook checked)\r\n");
+}
+
+__NORETURN void panic(const char *message, ...)
+{
+    va_list va;
+    va_start(va, message);
+    vfprintf(stderr, message, va);
+    va_end(va);
+
+    abort();
+}
+
+/**
+ * @brief  Returns the run time statistics counter in microseconds
+ *
+ * @return The host monotonic clock truncated to 32 bits
+ */
+uint32_t simulator_get_run_time_counter(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t)(((uint64_t)ts.tv_sec * 1000000ull) + ((uint64_t)ts.tv_nsec / 1000ull));
+}
+
+/**
+ * @brief Mounts the disk image to the filesystem.
+ *
+ * A freshly created (or otherwise unformatted) image is formatted first.
+ *
+ * @return 0 on success,
+ * @return < 0 on failure.
+ */
+static int disk_mount(void)
+{
+    int err;
+
+    sdio_sim_set_image(mtd_file.path, mtd_file.size);
+    _fatfs_desc.dev = (mtd_dev_t *)&mtd_cache;
+
+    err = vfs_mount(&_fatfs_disk_vfs_mount);
+    if (-ENODEV == err)
+    {
+        err = vfs_format(&_fatfs_disk_vfs_mount);
+        if (0 == err)
+        {
+            err = vfs_mount(&_fatfs_disk_vfs_mount);
+        }
+    }
+
+    fprintf(stderr, "disk_mount : %s on %s : %s\n",
+            mtd_file.path, SIMULATOR_DISK_MOUNT_PATH, strerror(-err));
+
+    return err;
+}
+
+/* configSUPPORT_STATIC_ALLOCATION is set to 1, so the application must provide an
+ * implementation of vApplicationGetIdleTaskMemory() to provide the memory that is
+ * used by the Idle task.
+ * */
+static StaticTask_t xIdleTaskTCB;
+static StackType_t uxIdleTaskStack[configMINIMAL_STACK_SIZE];
+
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                   StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize)
+{
+    *ppxIdleTaskTCBBuffer = &xIdleTaskTCB;
+    *ppxIdleTaskStackBuffer = &uxIdleTaskStack[0];
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+/* configSUPPORT_STATIC_ALLOCATION and configUSE_TIMERS are both set to 1, so the
+ * application must provide an implementation of vApplicationGetTimerTaskMemory()
+ * to provide the memory that is used by the Timer service task.
+ * */
+static StaticTask_t xTimerTaskTCB;
+static StackType_t uxTimerTaskStack[configTIMER_TASK_STACK_DEPTH];
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer,
+                                    StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize)
+{
+    *ppxTimerTaskTCBBuffer = &xTimerTaskTCB;
+    *ppxTimerTaskStackBuffer = &uxTimerTaskStack[0];
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+/** @} */
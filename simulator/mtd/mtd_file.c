@@ -0,0 +1,217 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     simulator_mtd_file
+ * @{
+ *
+ * @file        mtd_file.c
+ * @brief       Driver for using a host disk image file via mtd interface
+ * @}
+ */
+#define _GNU_SOURCE /* for fallocate() */
+#define ENABLE_DEBUG 0
+#include "debug.h"
+#include "container.h"
+#include "macros/utils.h"
+#include "mtd.h"
+#include "mtd_file.h"
+
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static ssize_t _pread_all(int fd, void *buff, size_t size, off_t offset)
+{
+    uint8_t *dst = buff;
+    size_t done = 0;
+
+    while (done < size) {
+        ssize_t res = pread(fd, dst + done, size - done, offset + done);
+        if (res < 0) {
+            /* the POSIX port drives the tick with a signal */
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        if (res == 0) {
+            /* reading past the end of a sparse image returns zeroes */
+            memset(dst + done, 0, size - done);
+            break;
+        }
+        done += res;
+    }
+
+    return size;
+}
+
+static ssize_t _pwrite_all(int fd, const void *buff, size_t size, off_t offset)
+{
+    const uint8_t *src = buff;
+    size_t done = 0;
+
+    while (done < size) {
+        ssize_t res = pwrite(fd, src + done, size - done, offset + done);
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        done += res;
+    }
+
+    return size;
+}
+
+static int mtd_file_init(mtd_dev_t *dev)
+{
+    mtd_file_t *mtd_file = container_of(dev, mtd_file_t, base);
+    struct stat st;
+
+    DEBUG("mtd_file_init: %s\n", mtd_file->path);
+
+    mtd_file->fd = open(mtd_file->path, O_RDWR | O_CREAT, 0644);
+    if (mtd_file->fd < 0) {
+        return -errno;
+    }
+
+    if (fstat(mtd_file->fd, &st) < 0) {
+        int err = -errno;
+        close(mtd_file->fd);
+        mtd_file->fd = -1;
+        return err;
+    }
+
+    if ((size_t)st.st_size < mtd_file->size) {
+        if (ftruncate(mtd_file->fd, mtd_file->size) < 0) {
+            int err = -errno;
+            close(mtd_file->fd);
+            mtd_file->fd = -1;
+            return err;
+        }
+        st.st_size = mtd_file->size;
+    }
+
+    if (st.st_size < (off_t)MTD_FILE_PAGE_SIZE) {
+        close(mtd_file->fd);
+        mtd_file->fd = -1;
+        return -ENOSPC;
+    }
+
+    /* behave like an SD card: single page sectors of the SD-HC block size */
+    dev->pages_per_sector = 1;
+    dev->sector_count     = (uint32_t)(st.st_size / MTD_FILE_PAGE_SIZE);
+    dev->page_size        = MTD_FILE_PAGE_SIZE;
+    dev->write_size       = MTD_FILE_PAGE_SIZE;
+
+    return 0;
+}
+
+static int mtd_file_read_page(mtd_dev_t *dev, void *buff, uint32_t page,
+                              uint32_t offset, uint32_t size)
+{
+    mtd_file_t *mtd_file = container_of(dev, mtd_file_t, base);
+
+    DEBUG("mtd_file_read_page: page:%" PRIu32 " offset:%" PRIu32 " size:%" PRIu32 "\n",
+          page, offset, size);
+
+    ssize_t res = _pread_all(mtd_file->fd, buff, size,
+                             (off_t)page * MTD_FILE_PAGE_SIZE + offset);
+    if (res < 0) {
+        DEBUG("mtd_file_read_page: error %d\n", (int)res);
+        return -EIO;
+    }
+    return size;
+}
+
+static int mtd_file_write_page(mtd_dev_t *dev, const void *buff, uint32_t page,
+                               uint32_t offset, uint32_t size)
+{
+    mtd_file_t *mtd_file = container_of(dev, mtd_file_t, base);
+
+    DEBUG("mtd_file_write_page: page:%" PRIu32 " offset:%" PRIu32 " size:%" PRIu32 "\n",
+          page, offset, size);
+
+    ssize_t res = _pwrite_all(mtd_file->fd, buff, size,
+                              (off_t)page * MTD_FILE_PAGE_SIZE + offset);
+    if (res < 0) {
+        DEBUG("mtd_file_write_page: error %d\n", (int)res);
+        return -EIO;
+    }
+    return size;
+}
+
+static int mtd_file_erase_sector(mtd_dev_t *dev, uint32_t sector, uint32_t count)
+{
+    mtd_file_t *mtd_file = container_of(dev, mtd_file_t, base);
+    static const uint8_t zero[MTD_FILE_PAGE_SIZE];
+
+    DEBUG("mtd_file_erase_sector: sector: %" PRIu32 " count: %" PRIu32 "\n",
+          sector, count);
+
+    /* discard the range like the erase commands of mtd_sdcard, punched
+       holes read back as zeroes */
+    if (fallocate(mtd_file->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                  (off_t)sector * MTD_FILE_PAGE_SIZE,
+                  (off_t)count * MTD_FILE_PAGE_SIZE) == 0) {
+        return 0;
+    }
+
+    /* the host file system does not support hole punching */
+    while (count) {
+        ssize_t res = _pwrite_all(mtd_file->fd, zero, sizeof(zero),
+                                  (off_t)sector * MTD_FILE_PAGE_SIZE);
+        if (res < 0) {
+            DEBUG("mtd_file_erase_sector: error %d\n", (int)res);
+            return -EIO;
+        }
+        --count;
+        ++sector;
+    }
+    return 0;
+}
+
+static int mtd_file_power(mtd_dev_t *dev, enum mtd_power_state power)
+{
+    mtd_file_t *mtd_file = container_of(dev, mtd_file_t, base);
+
+    if (power == MTD_POWER_DOWN && mtd_file->fd >= 0) {
+        fsync(mtd_file->fd);
+    }
+
+    return 0;
+}
+
+const mtd_desc_t mtd_file_driver = {
+    .init = mtd_file_init,
+    .read_page = mtd_file_read_page,
+    .write_page = mtd_file_write_page,
+    .erase_sector = mtd_file_erase_sector,
+    .power = mtd_file_power,
+    .flags = MTD_DRIVER_FLAG_DIRECT_WRITE,
+};
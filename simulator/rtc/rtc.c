@@ -0,0 +1,94 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     simulator
+ * @{
+ * @file        rtc.c
+ * @brief       RTC emulation on top of the host real time clock
+ */
+#include "rtc.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * Offset between the emulated RTC and the host clock in seconds,
+ * set by rtc_set_time().
+ */
+static time_t _rtc_offset = 0;
+
+int rtc_init(void)
+{
+    _rtc_offset = 0;
+    return 0;
+}
+
+int rtc_deinit(void)
+{
+    return 0;
+}
+
+int rtc_set_time(struct tm *time)
+{
+    struct timespec ts;
+    struct tm t = *time;
+    time_t target = timegm(&t);
+
+    if (((time_t)-1 == target) || (0 != clock_gettime(CLOCK_REALTIME, &ts)))
+    {
+        return -EINVAL;
+    }
+
+    _rtc_offset = target - ts.tv_sec;
+
+    return 0;
+}
+
+int rtc_get_time(struct tm *time)
+{
+    uint16_t ms;
+    return rtc_get_time_ms(time, &ms);
+}
+
+int rtc_get_time_ms(struct tm *time, uint16_t *ms)
+{
+    struct timespec ts;
+
+    if (0 != clock_gettime(CLOCK_REALTIME, &ts))
+    {
+        return -1;
+    }
+
+    const time_t now = ts.tv_sec + _rtc_offset;
+    if (NULL == gmtime_r(&now, time))
+    {
+        return -1;
+    }
+
+    *ms = (uint16_t)(ts.tv_nsec / 1000000l);
+
+    return 0;
+}
+/** @} */
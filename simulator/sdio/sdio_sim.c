@@ -0,0 +1,850 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     simulator_sdio
+ * @{
+ *
+ * @file        sdio_sim.c
+ * @brief       Simulated SDIO peripheral and SD card backed by a disk image file
+ *
+ * Implements the HAL, LL, GPIO, DMA and RCC functions used by the SD Card
+ * driver (system/sdcard/sdcard.c), so the driver runs unmodified on the host.
+ * A high priority task plays the role of the SDIO and DMA hardware: it moves
+ * the data between the buffers and the disk image, calls the transfer
+ * complete callbacks and keeps the card busy (D0 low) for a while after the
+ * write and erase commands. The end of the busy state is signalled through
+ * the D0 EXTI callback when it is enabled. The SCR and the switch function
+ * status are returned through the FIFO, data transfers can be made to fail
+ * with CRC errors at the High-Speed clock.
+ * @}
+ */
+#define _GNU_SOURCE /* for fallocate() */
+#include "stm32f4xx_hal.h"
+#include "rcc.h"
+#include "dma.h"
+#include "gpio.h"
+#include "sdio_sim.h"
+#include "simulator_config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#define SDIO_SIM_BLOCK_SIZE     512ul
+#define SDIO_SIM_SDIOCLK_HZ     48000000ul
+#define SDIO_SIM_MAX_DS_HZ      25000000ul
+
+typedef enum
+{
+    SDIO_SIM_OP_READ,
+    SDIO_SIM_OP_WRITE,
+    SDIO_SIM_OP_BUSY,
+} sdio_sim_op_type_t;
+
+typedef struct
+{
+    sdio_sim_op_type_t type;
+    uint8_t *data;
+    uint32_t block_addr;
+    uint32_t block_num;
+    TickType_t busy_ticks;
+} sdio_sim_op_t;
+
+struct SDIO_TypeDef
+{
+    int unused;
+};
+
+static struct SDIO_TypeDef _sdio;
+SDIO_TypeDef *const sdio_sim_instance = &_sdio;
+
+static const char *_path = SIMULATOR_DISK_IMAGE_PATH;
+static size_t _size = SIMULATOR_DISK_IMAGE_SIZE;
+static int _fd = -1;
+
+static SD_HandleTypeDef *_hsd = NULL;
+static volatile bool _busy = false;
+static volatile bool _exti_enabled = false;
+static void (*_exti_callback)(void) = NULL;
+static bool _app_cmd = false;
+static sdio_sim_stats_t _stats;
+
+static SDIO_InitTypeDef _sdio_init;
+static bool _hs_supported = true;
+static bool _hs_crc_errors = false;
+static bool _card_high_speed = false;
+
+static uint32_t _fifo[16];
+static uint32_t _fifo_len = 0;
+static uint32_t _fifo_pos = 0;
+static uint32_t _data_length = 0;
+static uint32_t _flags = 0;
+
+static StaticQueue_t _op_queue_struct;
+static uint8_t _op_queue_storage[SDIO_SIM_QUEUE_LENGTH * sizeof(sdio_sim_op_t)];
+static QueueHandle_t _op_queue = NULL;
+
+static StackType_t _task_stack[SDIO_SIM_TASK_STACKSIZE];
+static StaticTask_t _task_tcb;
+static TaskHandle_t h_task = NULL;
+
+static void sdio_sim_task(void *params);
+static void sdio_sim_busy_end(void);
+static HAL_StatusTypeDef sdio_sim_check_access(SD_HandleTypeDef *hsd, uint32_t block_addr, uint32_t block_num);
+static int sdio_sim_transfer(bool write, uint8_t *data, uint32_t block_addr, uint32_t block_num);
+static int sdio_sim_discard(uint32_t block_addr, uint32_t block_num);
+static uint32_t sdio_sim_bus_clock(void);
+static void sdio_sim_fifo_load(const uint8_t *data, uint32_t size);
+
+void sdio_sim_set_image(const char *path, size_t size)
+{
+    _path = path;
+    _size = size;
+}
+
+void sdio_sim_set_high_speed(bool supported, bool crc_errors)
+{
+    _hs_supported = supported;
+    _hs_crc_errors = crc_errors;
+}
+
+void sdio_sim_get_stats(sdio_sim_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = _stats;
+    stats->bus_clock_hz = sdio_sim_bus_clock();
+    stats->high_speed = (true == _card_high_speed) ? 1 : 0;
+    taskEXIT_CRITICAL();
+}
+
+void sdio_sim_reset_stats(void)
+{
+    taskENTER_CRITICAL();
+    memset(&_stats, 0, sizeof(_stats));
+    taskEXIT_CRITICAL();
+}
+
+HAL_StatusTypeDef HAL_SD_Init(SD_HandleTypeDef *hsd)
+{
+    if (NULL != hsd->MspInitCallback)
+    {
+        hsd->MspInitCallback(hsd);
+    }
+
+    return HAL_SD_InitCard(hsd);
+}
+
+HAL_StatusTypeDef HAL_SD_InitCard(SD_HandleTypeDef *hsd)
+{
+    struct stat st;
+
+    /* the image may have been replaced since the previous identification */
+    if (_fd >= 0)
+    {
+        fsync(_fd);
+        close(_fd);
+        _fd = -1;
+    }
+
+    _fd = open(_path, O_RDWR | O_CREAT, 0644);
+    if (_fd < 0)
+    {
+        hsd->ErrorCode = HAL_SD_ERROR_GENERAL_UNKNOWN_ERR;
+        return HAL_ERROR;
+    }
+
+    if ((fstat(_fd, &st) < 0) ||
+        (((size_t)st.st_size < _size) && (ftruncate(_fd, _size) < 0)))
+    {
+        close(_fd);
+        _fd = -1;
+        hsd->ErrorCode = HAL_SD_ERROR_GENERAL_UNKNOWN_ERR;
+        return HAL_ERROR;
+    }
+
+    if ((size_t)st.st_size < _size)
+    {
+        st.st_size = _size;
+    }
+
+    memset(&hsd->SdCard, 0, sizeof(hsd->SdCard));
+    hsd->SdCard.CardType = CARD_SDHC_SDXC;
+    hsd->SdCard.RelCardAdd = 0x1234u;
+    hsd->SdCard.BlockNbr = (uint32_t)(st.st_size / SDIO_SIM_BLOCK_SIZE);
+    hsd->SdCard.BlockSize = SDIO_SIM_BLOCK_SIZE;
+    hsd->SdCard.LogBlockNbr = hsd->SdCard.BlockNbr;
+    hsd->SdCard.LogBlockSize = SDIO_SIM_BLOCK_SIZE;
+    hsd->ErrorCode = HAL_SD_ERROR_NONE;
+
+    _hsd = hsd;
+    _busy = false;
+    _app_cmd = false;
+    _card_high_speed = false;
+    _sdio_init = hsd->Init;
+
+    if (NULL == h_task)
+    {
+        _op_queue = xQueueCreateStatic(SDIO_SIM_QUEUE_LENGTH,
+                                       sizeof(sdio_sim_op_t),
+                                       _op_queue_storage,
+                                       &_op_queue_struct);
+        configASSERT(_op_queue);
+
+        h_task = xTaskCreateStatic(sdio_sim_task,
+                                   "SDIO SIM",
+                                   SDIO_SIM_TASK_STACKSIZE,
+                                   NULL,
+                                   SDIO_SIM_TASK_PRIORITY,
+                                   _task_stack,
+                                   &_task_tcb);
+        configASSERT(h_task);
+    }
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SD_DeInit(SD_HandleTypeDef *hsd)
+{
+    if (NULL != hsd->MspDeInitCallback)
+    {
+        hsd->MspDeInitCallback(hsd);
+    }
+
+    if (_fd >= 0)
+    {
+        fsync(_fd);
+        close(_fd);
+        _fd = -1;
+    }
+
+    _hsd = NULL;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SD_RegisterCallback(SD_HandleTypeDef *hsd, HAL_SD_CallbackIDTypeDef CallbackID,
+                                          pSD_CallbackTypeDef pCallback)
+{
+    if (NULL == pCallback)
+    {
+        hsd->ErrorCode |= HAL_SD_ERROR_PARAM;
+        return HAL_ERROR;
+    }
+
+    switch (CallbackID)
+    {
+        case HAL_SD_TX_CPLT_CB_ID    : hsd->TxCpltCallback = pCallback; break;
+        case HAL_SD_RX_CPLT_CB_ID    : hsd->RxCpltCallback = pCallback; break;
+        case HAL_SD_ERROR_CB_ID      : hsd->ErrorCallback = pCallback; break;
+        case HAL_SD_ABORT_CB_ID      : hsd->AbortCpltCallback = pCallback; break;
+        case HAL_SD_MSP_INIT_CB_ID   : hsd->MspInitCallback = pCallback; break;
+        case HAL_SD_MSP_DEINIT_CB_ID : hsd->MspDeInitCallback = pCallback; break;
+        default                      : return HAL_ERROR;
+    }
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SD_UnRegisterCallback(SD_HandleTypeDef *hsd, HAL_SD_CallbackIDTypeDef CallbackID)
+{
+    switch (CallbackID)
+    {
+        case HAL_SD_TX_CPLT_CB_ID    : hsd->TxCpltCallback = NULL; break;
+        case HAL_SD_RX_CPLT_CB_ID    : hsd->RxCpltCallback = NULL; break;
+        case HAL_SD_ERROR_CB_ID      : hsd->ErrorCallback = NULL; break;
+        case HAL_SD_ABORT_CB_ID      : hsd->AbortCpltCallback = NULL; break;
+        case HAL_SD_MSP_INIT_CB_ID   : hsd->MspInitCallback = NULL; break;
+        case HAL_SD_MSP_DEINIT_CB_ID : hsd->MspDeInitCallback = NULL; break;
+        default                      : return HAL_ERROR;
+    }
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SD_ConfigWideBusOperation(SD_HandleTypeDef *hsd, uint32_t WideMode)
+{
+    hsd->Init.BusWide = WideMode;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SD_GetCardInfo(SD_HandleTypeDef *hsd, HAL_SD_CardInfoTypeDef *pCardInfo)
+{
+    *pCardInfo = hsd->SdCard;
+    return HAL_OK;
+}
+
+HAL_SD_CardStateTypeDef HAL_SD_GetCardState(SD_HandleTypeDef *hsd)
+{
+    (void)hsd;
+
+    _stats.status_reads++;
+
+    return (true == _busy) ? HAL_SD_CARD_PROGRAMMING : HAL_SD_CARD_TRANSFER;
+}
+
+HAL_StatusTypeDef HAL_SD_ReadBlocks_DMA(SD_HandleTypeDef *hsd, uint8_t *pData,
+                                        uint32_t BlockAdd, uint32_t NumberOfBlocks)
+{
+    HAL_StatusTypeDef ret = sdio_sim_check_access(hsd, BlockAdd, NumberOfBlocks);
+    if (HAL_OK != ret)
+    {
+        return ret;
+    }
+
+    _stats.reads++;
+
+    sdio_sim_op_t op = {
+        .type = SDIO_SIM_OP_READ,
+        .data = pData,
+        .block_addr = BlockAdd,
+        .block_num = NumberOfBlocks,
+    };
+    xQueueSend(_op_queue, &op, portMAX_DELAY);
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SD_WriteBlocks_DMA(SD_HandleTypeDef *hsd, uint8_t *pData,
+                                         uint32_t BlockAdd, uint32_t NumberOfBlocks)
+{
+    HAL_StatusTypeDef ret = sdio_sim_check_access(hsd, BlockAdd, NumberOfBlocks);
+    if (HAL_OK != ret)
+    {
+        return ret;
+    }
+
+    _stats.writes++;
+
+    /* the card is programming from the first received block */
+    _busy = true;
+
+    sdio_sim_op_t op = {
+        .type = SDIO_SIM_OP_WRITE,
+        .data = pData,
+        .block_addr = BlockAdd,
+        .block_num = NumberOfBlocks,
+        .busy_ticks = SDIO_SIM_PROGRAMMING_TICKS,
+    };
+    xQueueSend(_op_queue, &op, portMAX_DELAY);
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SD_Erase(SD_HandleTypeDef *hsd, uint32_t BlockStartAdd, uint32_t BlockEndAdd)
+{
+    if (BlockEndAdd < BlockStartAdd)
+    {
+        hsd->ErrorCode |= HAL_SD_ERROR_PARAM;
+        return HAL_ERROR;
+    }
+
+    /* the end address is inclusive */
+    HAL_StatusTypeDef ret = sdio_sim_check_access(hsd, BlockStartAdd, BlockEndAdd - BlockStartAdd + 1);
+    if (HAL_OK != ret)
+    {
+        return ret;
+    }
+
+    _stats.erases++;
+
+    if (sdio_sim_discard(BlockStartAdd, BlockEndAdd - BlockStartAdd + 1) < 0)
+    {
+        hsd->ErrorCode |= HAL_SD_ERROR_GENERAL_UNKNOWN_ERR;
+        return HAL_ERROR;
+    }
+
+    /* CMD38 has an R1b response, the card is busy until the erase is done */
+    _busy = true;
+
+    sdio_sim_op_t op = {
+        .type = SDIO_SIM_OP_BUSY,
+        .busy_ticks = SDIO_SIM_ERASE_TICKS,
+    };
+    xQueueSend(_op_queue, &op, portMAX_DELAY);
+
+    return HAL_OK;
+}
+
+void HAL_SD_IRQHandler(SD_HandleTypeDef *hsd)
+{
+    (void)hsd;
+}
+
+uint32_t SDMMC_CmdAppCommand(SDIO_TypeDef *SDIOx, uint32_t Argument)
+{
+    (void)SDIOx;
+
+    if ((NULL == _hsd) || (Argument != (_hsd->SdCard.RelCardAdd << 16)))
+    {
+        return HAL_SD_ERROR_CMD_RSP_TIMEOUT;
+    }
+
+    _app_cmd = true;
+
+    return HAL_SD_ERROR_NONE;
+}
+
+HAL_StatusTypeDef SDIO_SendCommand(SDIO_TypeDef *SDIOx, SDIO_CmdInitTypeDef *Command)
+{
+    (void)SDIOx;
+
+    if ((true == _app_cmd) && (SDMMC_CMD_SET_BLOCK_COUNT == Command->CmdIndex))
+    {
+        if (true == _busy)
+        {
+            _stats.illegal_cmds++;
+        }
+        else
+        {
+            _stats.pre_erase_hints++;
+        }
+    }
+
+    _app_cmd = false;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef SDIO_Init(SDIO_TypeDef *SDIOx, SDIO_InitTypeDef Init)
+{
+    (void)SDIOx;
+
+    _sdio_init = Init;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef SDIO_ConfigData(SDIO_TypeDef *SDIOx, SDIO_DataInitTypeDef *Data)
+{
+    (void)SDIOx;
+
+    _data_length = Data->DataLength;
+
+    return HAL_OK;
+}
+
+uint32_t SDIO_ReadFIFO(SDIO_TypeDef *SDIOx)
+{
+    (void)SDIOx;
+
+    return (_fifo_pos < _fifo_len) ? _fifo[_fifo_pos++] : 0;
+}
+
+uint32_t SDIO_GetFlag(SDIO_TypeDef *SDIOx, uint32_t flag)
+{
+    (void)SDIOx;
+
+    uint32_t flags = _flags;
+
+    if (_fifo_pos < _fifo_len)
+    {
+        flags |= SDIO_FLAG_RXDAVL;
+    }
+
+    return flags & flag;
+}
+
+void SDIO_ClearFlag(SDIO_TypeDef *SDIOx, uint32_t flag)
+{
+    (void)SDIOx;
+
+    _flags &= ~flag;
+}
+
+uint32_t SDMMC_CmdBlockLength(SDIO_TypeDef *SDIOx, uint32_t BlockSize)
+{
+    (void)SDIOx;
+    (void)BlockSize;
+
+    return HAL_SD_ERROR_NONE;
+}
+
+uint32_t SDMMC_CmdSendSCR(SDIO_TypeDef *SDIOx)
+{
+    (void)SDIOx;
+
+    if (false == _app_cmd)
+    {
+        return HAL_SD_ERROR_ILLEGAL_CMD;
+    }
+
+    _app_cmd = false;
+
+    /* SD_SPEC 2 (SD 2.00), 1 and 4 bit bus widths */
+    const uint8_t scr[8] = { 0x02, 0x35, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    sdio_sim_fifo_load(scr, sizeof(scr));
+
+    return HAL_SD_ERROR_NONE;
+}
+
+uint32_t SDMMC_CmdSwitch(SDIO_TypeDef *SDIOx, uint32_t Argument)
+{
+    (void)SDIOx;
+
+    _app_cmd = false;
+
+    uint8_t status[64] = {0};
+    const uint32_t function = Argument & 0x0Fu;
+    const bool supported = (0 == function) || ((1 == function) && (true == _hs_supported));
+
+    /* maximum current 100 mA, group 1 functions 0 (default) and 1 (High-Speed) */
+    status[1] = 0x64u;
+    status[12] = 0x80u;
+    status[13] = (true == _hs_supported) ? 0x03u : 0x01u;
+    status[16] = (true == supported) ? (uint8_t)function : 0x0Fu;
+
+    if ((0 != (Argument & 0x80000000u)) && (true == supported))
+    {
+        _card_high_speed = (1 == function);
+    }
+
+    sdio_sim_fifo_load(status, sizeof(status));
+
+    return HAL_SD_ERROR_NONE;
+}
+
+uint32_t SDMMC_GetCmdResp1(SDIO_TypeDef *SDIOx, uint8_t SD_CMD, uint32_t Timeout)
+{
+    (void)SDIOx;
+    (void)SD_CMD;
+    (void)Timeout;
+
+    return HAL_SD_ERROR_NONE;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    (void)IRQn;
+    (void)PreemptPriority;
+    (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    (void)IRQn;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    (void)IRQn;
+}
+
+HAL_StatusTypeDef sdio_clock_source_init(void)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef sdio_clock_source_deinit(void)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef clk48_clock_deinit(void)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef sdcard_sdio_dma_rx_init(SD_HandleTypeDef *h_sd)
+{
+    (void)h_sd;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef sdcard_sdio_dma_tx_init(SD_HandleTypeDef *h_sd)
+{
+    (void)h_sd;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef sdcard_sdio_dma_rx_deinit(SD_HandleTypeDef *h_sd)
+{
+    (void)h_sd;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef sdcard_sdio_dma_tx_deinit(SD_HandleTypeDef *h_sd)
+{
+    (void)h_sd;
+    return HAL_OK;
+}
+
+void sdcard_cmd_pin_init(void) { }
+void sdcard_clk_pin_init(void) { }
+void sdcard_d3_pin_init(void) { }
+void sdcard_d2_pin_init(void) { }
+void sdcard_d1_pin_init(void) { }
+void sdcard_d0_pin_init(void) { }
+void sdcard_cmd_pin_deinit(void) { }
+void sdcard_clk_pin_deinit(void) { }
+void sdcard_d3_pin_deinit(void) { }
+void sdcard_d2_pin_deinit(void) { }
+void sdcard_d1_pin_deinit(void) { }
+void sdcard_d0_pin_deinit(void) { }
+
+int sdcard_d0_pin_exti_init(void (*exti_callback_fn)(void))
+{
+    configASSERT(exti_callback_fn);
+
+    _exti_callback = exti_callback_fn;
+    _exti_enabled = false;
+
+    return 0;
+}
+
+int sdcard_d0_pin_exti_deinit(void)
+{
+    _exti_enabled = false;
+    _exti_callback = NULL;
+
+    return 0;
+}
+
+void sdcard_d0_pin_exti_enable(void)
+{
+    _exti_enabled = true;
+}
+
+void sdcard_d0_pin_exti_disable(void)
+{
+    _exti_enabled = false;
+}
+
+int sdcard_d0_pin_read(void)
+{
+    return (true == _busy) ? 0 : 1;
+}
+
+/**
+ * @brief Simulated SDIO / DMA hardware.
+ *
+ * @param params Pointer to task parameters (not used).
+ */
+static void sdio_sim_task(void *params)
+{
+    (void)params;
+
+    for ( ;; )
+    {
+        sdio_sim_op_t op;
+        xQueueReceive(_op_queue, &op, portMAX_DELAY);
+
+        switch (op.type)
+        {
+            case SDIO_SIM_OP_READ :
+            case SDIO_SIM_OP_WRITE :
+            {
+                const bool write = (SDIO_SIM_OP_WRITE == op.type);
+
+                /* the bus runs faster than the default speed maximum */
+                if ((true == _hs_crc_errors) && (sdio_sim_bus_clock() > SDIO_SIM_MAX_DS_HZ))
+                {
+                    _stats.crc_errors++;
+                    _busy = false;
+                    _hsd->ErrorCode |= HAL_SD_ERROR_DATA_CRC_FAIL;
+                    if (NULL != _hsd->ErrorCallback)
+                    {
+                        _hsd->ErrorCallback(_hsd);
+                    }
+                }
+                else if (sdio_sim_transfer(write, op.data, op.block_addr, op.block_num) < 0)
+                {
+                    _hsd->ErrorCode |= HAL_SD_ERROR_DATA_CRC_FAIL;
+                    if (NULL != _hsd->ErrorCallback)
+                    {
+                        _hsd->ErrorCallback(_hsd);
+                    }
+                }
+                else if ((true == write) && (NULL != _hsd->TxCpltCallback))
+                {
+                    _hsd->TxCpltCallback(_hsd);
+                }
+                else if ((false == write) && (NULL != _hsd->RxCpltCallback))
+                {
+                    _hsd->RxCpltCallback(_hsd);
+                }
+            }
+            break;
+
+            case SDIO_SIM_OP_BUSY :
+            default :
+            break;
+        }
+
+        if (true == _busy)
+        {
+            vTaskDelay(op.busy_ticks);
+            sdio_sim_busy_end();
+        }
+    }
+}
+
+/**
+ * @brief Releases the D0 line and signals the rising edge if the EXTI is enabled.
+ */
+static void sdio_sim_busy_end(void)
+{
+    _busy = false;
+
+    if ((true == _exti_enabled) && (NULL != _exti_callback))
+    {
+        _stats.busy_end_irqs++;
+        _exti_callback();
+    }
+}
+
+/**
+ * @brief Returns the SDIO_CK frequency selected by the clock control register.
+ */
+static uint32_t sdio_sim_bus_clock(void)
+{
+    if (SDIO_CLOCK_BYPASS_ENABLE == _sdio_init.ClockBypass)
+    {
+        return SDIO_SIM_SDIOCLK_HZ;
+    }
+
+    return SDIO_SIM_SDIOCLK_HZ / (_sdio_init.ClockDiv + 2);
+}
+
+/**
+ * @brief Loads the data block of a command into the receive FIFO.
+ */
+static void sdio_sim_fifo_load(const uint8_t *data, uint32_t size)
+{
+    if (size > _data_length)
+    {
+        size = _data_length;
+    }
+
+    memset(_fifo, 0, sizeof(_fifo));
+    memcpy(_fifo, data, (size < sizeof(_fifo)) ? size : sizeof(_fifo));
+
+    _fifo_len = (size + 3) / 4;
+    _fifo_pos = 0;
+    _flags |= SDIO_FLAG_DATAEND;
+}
+
+/**
+ * @brief Checks if a data command is accepted by the card.
+ */
+static HAL_StatusTypeDef sdio_sim_check_access(SD_HandleTypeDef *hsd, uint32_t block_addr, uint32_t block_num)
+{
+    if ((_fd < 0) || (NULL == _hsd))
+    {
+        hsd->ErrorCode |= HAL_SD_ERROR_REQUEST_NOT_APPLICABLE;
+        return HAL_ERROR;
+    }
+
+    /* data commands are illegal in the programming state */
+    if (true == _busy)
+    {
+        _stats.illegal_cmds++;
+        hsd->ErrorCode |= HAL_SD_ERROR_ILLEGAL_CMD;
+        return HAL_ERROR;
+    }
+
+    if ((0 == block_num) || (block_addr + block_num > hsd->SdCard.BlockNbr) || (block_addr + block_num < block_addr))
+    {
+        hsd->ErrorCode |= HAL_SD_ERROR_ADDR_OUT_OF_RANGE;
+        return HAL_ERROR;
+    }
+
+    hsd->ErrorCode = HAL_SD_ERROR_NONE;
+
+    return HAL_OK;
+}
+
+/**
+ * @brief Moves the data of a read or write command.
+ */
+static int sdio_sim_transfer(bool write, uint8_t *data, uint32_t block_addr, uint32_t block_num)
+{
+    const size_t size = (size_t)block_num * SDIO_SIM_BLOCK_SIZE;
+    const off_t offset = (off_t)block_addr * SDIO_SIM_BLOCK_SIZE;
+    size_t done = 0;
+
+    while (done < size)
+    {
+        ssize_t res = (true == write) ? pwrite(_fd, data + done, size - done, offset + done)
+                                      : pread(_fd, data + done, size - done, offset + done);
+        if (res < 0)
+        {
+            /* the POSIX port drives the tick with a signal */
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return -errno;
+        }
+
+        if (0 == res)
+        {
+            /* reading past the end of a sparse image returns zeroes */
+            memset(data + done, 0, size - done);
+            break;
+        }
+
+        done += res;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Discards the erased blocks, punched holes read back as zeroes.
+ */
+static int sdio_sim_discard(uint32_t block_addr, uint32_t block_num)
+{
+    static const uint8_t zero[SDIO_SIM_BLOCK_SIZE];
+
+    if (0 == fallocate(_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                       (off_t)block_addr * SDIO_SIM_BLOCK_SIZE,
+                       (off_t)block_num * SDIO_SIM_BLOCK_SIZE))
+    {
+        return 0;
+    }
+
+    while (block_num)
+    {
+        if (sdio_sim_transfer(true, (uint8_t *)zero, block_addr, 1) < 0)
+        {
+            return -EIO;
+        }
+        block_num--;
+        block_addr++;
+    }
+
+    return 0;
+}
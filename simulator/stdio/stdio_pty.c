@@ -0,0 +1,306 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     simulator
+ * @{
+ *
+ * @file        stdio_pty.c
+ * @brief       STDIO over a host pseudo-terminal implementation
+ *              The slave side of the pty can be opened with any terminal
+ *              emulator (e.g. screen, picocom) as if it was the STDIO UART
+ * @}
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "stdio_base.h"
+#include "stdio_rx.h"
+#include "simulator_config.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+static StackType_t _read_task_stack[STDIO_PTY_READ_TASK_STACKSIZE];
+static StaticTask_t _read_task_tcb;
+static TaskHandle_t h_read_task = NULL;
+
+static stdio_stats_t _stats;
+
+static int _pty_master = -1;
+static int _pty_slave = -1;
+
+static int pty_open(void);
+static void pty_close(void);
+static int pty_write(const uint8_t *data, size_t len);
+static void pty_read_task(void *params);
+
+void stdio_init(void)
+{
+    stdio_rx_init();
+
+    if (pty_open() < 0)
+    {
+        fprintf(stderr, "stdio_pty: cannot open pseudo-terminal: %s\n", strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    h_read_task = xTaskCreateStatic(pty_read_task,
+                                    "STDIO PTY Read",
+                                    STDIO_PTY_READ_TASK_STACKSIZE,
+                                    NULL,
+                                    STDIO_PTY_READ_TASK_PRIORITY,
+                                    _read_task_stack,
+                                    &_read_task_tcb);
+}
+
+void stdio_deinit(void)
+{
+    vTaskDelete(h_read_task);
+    h_read_task = NULL;
+
+    stdio_rx_deinit();
+
+    pty_close();
+}
+
+void stdio_stats_get(stdio_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = _stats;
+    taskEXIT_CRITICAL();
+}
+
+void stdio_stats_reset(void)
+{
+    taskENTER_CRITICAL();
+    memset(&_stats, 0, sizeof(_stats));
+    taskEXIT_CRITICAL();
+}
+
+ssize_t stdio_write(const void *buffer, size_t len)
+{
+    ssize_t result = len;
+
+    if (IS_USED(MODULE_STDIO_UART_ONLCR))
+    {
+        static const uint8_t crlf[2] = { (uint8_t)'\r', (uint8_t)'\n' };
+        const uint8_t *buf = buffer;
+
+        while (len)
+        {
+            const uint8_t *pos = memchr(buf, '\n', len);
+            size_t chunk_len = (pos != NULL && len != 1)
+                             ? (uintptr_t)pos - (uintptr_t)buf
+                             : len;
+            int ret = pty_write(buf, chunk_len);
+            if (ret < 0)
+            {
+                return ret;
+            }
+
+            buf += chunk_len;
+            len -= chunk_len;
+
+            if (len)
+            {
+                ret = pty_write(crlf, sizeof(crlf));
+                if (ret < 0)
+                {
+                    return ret;
+                }
+
+                buf++;
+                len--;
+            }
+        }
+    }
+    else
+    {
+        int ret = pty_write((const uint8_t *)buffer, len);
+        if (ret < 0)
+        {
+            return ret;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief  Opens the pseudo-terminal and redirects the host stdout to it
+ *
+ * The slave side is kept open and switched to raw mode so that the
+ * characters typed in the terminal emulator arrive unprocessed, the same
+ * way as they would over the STDIO UART. The slave path is printed on
+ * stderr, which stays connected to the launching terminal.
+ *
+ * @return 0 on success
+ * @return < 0 on error, errno is set
+ */
+static int pty_open(void)
+{
+    struct termios tio;
+
+    _pty_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (_pty_master < 0)
+    {
+        return -1;
+    }
+
+    if ((grantpt(_pty_master) < 0) || (unlockpt(_pty_master) < 0))
+    {
+        pty_close();
+        return -1;
+    }
+
+    const char *slave_name = ptsname(_pty_master);
+    if (NULL == slave_name)
+    {
+        pty_close();
+        return -1;
+    }
+
+    _pty_slave = open(slave_name, O_RDWR | O_NOCTTY);
+    if (_pty_slave < 0)
+    {
+        pty_close();
+        return -1;
+    }
+
+    if (0 == tcgetattr(_pty_slave, &tio))
+    {
+        cfmakeraw(&tio);
+        tcsetattr(_pty_slave, TCSANOW, &tio);
+    }
+
+    fprintf(stderr, "stdio_pty: console is available on %s\n", slave_name);
+
+    /* printf() and friends of the host C library end up on the pty too */
+    fflush(stdout);
+    if (dup2(_pty_master, STDOUT_FILENO) < 0)
+    {
+        pty_close();
+        return -1;
+    }
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    return 0;
+}
+
+/**
+ * @brief  Closes both sides of the pseudo-terminal
+ */
+static void pty_close(void)
+{
+    if (_pty_slave >= 0)
+    {
+        close(_pty_slave);
+        _pty_slave = -1;
+    }
+
+    if (_pty_master >= 0)
+    {
+        close(_pty_master);
+        _pty_master = -1;
+    }
+}
+
+/**
+ * @brief  Writes the whole buffer to the pseudo-terminal
+ *
+ * @param  data Pointer to the data to write
+ * @param  len  Number of bytes to write
+ *
+ * @return 0 on success
+ * @return < 0 on error
+ */
+static int pty_write(const uint8_t *data, size_t len)
+{
+    while (len)
+    {
+        ssize_t ret = write(_pty_master, data, len);
+        if (ret < 0)
+        {
+            /* the POSIX port drives the tick with a signal */
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return -errno;
+        }
+
+        data += ret;
+        len -= (size_t)ret;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief PTY read task.
+ *
+ * This task polls the pseudo-terminal for received characters and appends
+ * them to the stdin receive ring. Blocking in read() is avoided as the
+ * task must give the CPU back to the FreeRTOS scheduler.
+ *
+ * @param params Pointer to task parameters (not used).
+ */
+static void pty_read_task(void *params)
+{
+    (void)params;
+
+    uint8_t rx_data[STDIO_PTY_READ_BUFFER_SIZE];
+
+    for ( ;; )
+    {
+        struct pollfd pfd = {
+            .fd = _pty_master,
+            .events = POLLIN,
+        };
+
+        ssize_t len = 0;
+        if ((1 == poll(&pfd, 1, 0)) && (pfd.revents & POLLIN))
+        {
+            len = read(_pty_master, rx_data, sizeof(rx_data));
+        }
+
+        if (len <= 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(STDIO_PTY_POLL_PERIOD_MS));
+            continue;
+        }
+
+        taskENTER_CRITICAL();
+        _stats.rx_bytes += (uint32_t)len;
+        taskEXIT_CRITICAL();
+
+        stdio_rx_write(rx_data, (size_t)len);
+    }
+}
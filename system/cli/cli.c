@@ -29,7 +29,6 @@
  */
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
 #include "semphr.h"
 
 #define EMBEDDED_CLI_IMPL
@@ -41,58 +40,24 @@
 
 #include <stdio.h>
 #include "stdio_base.h"
-#include "stm32f4xx_hal.h"
+#include "stdio_rx.h"
 
 static EmbeddedCli *_cli;
 static CLI_UINT _cli_buffer[BYTES_TO_CLI_UINTS(CLI_BUFFER_SIZE)];
 
-static StackType_t _cli_io_read_task_stack[CLI_IO_READ_TASK_STACK_SIZE];
-static StaticTask_t _cli_io_read_task_tcb;
-static TaskHandle_t h_cli_io_read_task = NULL;
+static StackType_t _cli_task_stack[CLI_TASK_STACK_SIZE];
+static StaticTask_t _cli_task_tcb;
+static TaskHandle_t h_cli_task = NULL;
 
-static StackType_t _cli_process_task_stack[CLI_PROCESS_TASK_STACK_SIZE];
-static StaticTask_t _cli_process_task_tcb;
-static TaskHandle_t h_cli_process_task = NULL;
+static stdio_rx_listener_t _cli_rx_listener;
 
-static StaticQueue_t _cli_rx_queue_struct;
-static uint8_t _cli_rx_queue_storage[CLI_RX_QUEUE_LENGTH * sizeof(uint8_t *)];
-static QueueHandle_t cli_rx_queue = NULL;
-
-static void cli_io_read_task(void *params);
-static void cli_process_task(void *params);
+static void cli_task(void *params);
 static void cli_write_char(EmbeddedCli *cli, char c);
 
 void cli_init(void)
 {
     _cli = NULL;
 
-    cli_rx_queue = xQueueCreateStatic(CLI_RX_QUEUE_LENGTH,
-                                      sizeof(uint8_t),
-                                      _cli_rx_queue_storage,
-                                      &_cli_rx_queue_struct);
-    assert(cli_rx_queue);
-
-    int ret = stdio_add_stdin_listener(cli_rx_queue);
-    assert(0 == ret);
-
-    h_cli_io_read_task = xTaskCreateStatic(cli_io_read_task,
-                                           "CLI IO Read",
-                                           CLI_IO_READ_TASK_STACK_SIZE,
-                                           NULL,
-                                           CLI_IO_READ_TASK_PRIORITY,
-                                           _cli_io_read_task_stack,
-                                           &_cli_io_read_task_tcb);
-    assert(h_cli_io_read_task);
-
-    h_cli_process_task = xTaskCreateStatic(cli_process_task,
-                                           "CLI Process",
-                                           CLI_PROCESS_TASK_STACK_SIZE,
-                                           NULL,
-                                           CLI_PROCESS_TASK_PRIORITY,
-                                           _cli_process_task_stack,
-                                           &_cli_process_task_tcb);
-    assert(h_cli_process_task);
-
     EmbeddedCliConfig *config = embeddedCliDefaultConfig();
     config->cliBuffer = _cli_buffer;
     config->cliBufferSize = CLI_BUFFER_SIZE;
@@ -107,51 +72,64 @@ void cli_init(void)
 
     cli_init_command_bindings(_cli);
     cli_command_clear_terminal(_cli, NULL, NULL);
+
+    h_cli_task = xTaskCreateStatic(cli_task,
+                                   "CLI",
+                                   CLI_TASK_STACK_SIZE,
+                                   NULL,
+                                   CLI_TASK_PRIORITY,
+                                   _cli_task_stack,
+                                   &_cli_task_tcb);
+    assert(h_cli_task);
+
+    int ret = stdio_rx_listener_add(&_cli_rx_listener,
+                                    h_cli_task,
+                                    CLI_RX_NOTIFY_INDEX,
+                                    STDIO_RX_DROP_OLDEST);
+    assert(0 == ret);
 }
 
 void cli_deinit(void)
 {
-    vTaskDelete(h_cli_io_read_task);
-    vTaskDelete(h_cli_process_task);
-    vQueueDelete(cli_rx_queue);
-    h_cli_io_read_task = NULL;
-    h_cli_process_task = NULL;
-    cli_rx_queue = NULL;
+    stdio_rx_listener_remove(&_cli_rx_listener);
+    vTaskDelete(h_cli_task);
+    h_cli_task = NULL;
 }
 
 /**
- * @brief  Task function responsible for receiving characters and passing them
- *         to the Embedded CLI library
+ * @brief  Task function responsible for receiving the characters, passing
+ *         them to the Embedded CLI library and processing them
+ *
+ * The task sleeps until it is notified of a burst of received characters.
+ * Then it passes the characters to the Embedded CLI library in chunks and
+ * processes each chunk right away, so a command is executed as soon as its
+ * line is complete and the task does not wake up while nobody is typing.
  *
  * @param  params Task parameters (not used).
  */
-static void cli_io_read_task(void *params)
+static void cli_task(void *params)
 {
     (void)params;
 
-    for ( ;; )
-    {
-        char c;
-        BaseType_t ret = xQueueReceive(cli_rx_queue, &c, portMAX_DELAY);
-        assert(ret);
+    char rx_data[CLI_RX_CHUNK_SIZE];
 
-        embeddedCliReceiveChar(_cli, c);
-    }
-}
-
-/**
- * @brief  Task function responsible for processing the received characters
- *
- * @param  params Task parameters (not used).
- */
-static void cli_process_task(void *params)
-{
-    (void)params;
+    /* prints the prompt */
+    embeddedCliProcess(_cli);
 
     for ( ;; )
     {
-        embeddedCliProcess(_cli);
-        vTaskDelay(10);
+        ulTaskNotifyTakeIndexed(CLI_RX_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+
+        size_t len;
+        while ((len = stdio_rx_listener_read(&_cli_rx_listener, rx_data, sizeof(rx_data))) > 0)
+        {
+            for (size_t i = 0; i < len; i++)
+            {
+                embeddedCliReceiveChar(_cli, rx_data[i]);
+            }
+
+            embeddedCliProcess(_cli);
+        }
     }
 }
 
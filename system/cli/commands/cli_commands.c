@@ -127,6 +127,21 @@ static CliCommandBinding memstat_binding = {
     .binding = cli_command_memstat
 };
 
+static CliCommandBinding iostat_binding = {
+    .name = "iostat",
+    .help = "Displays the I/O statistics of the storage devices.\r\n        "
+            "Displays the number of operations, errors and bytes, the p50,\r\n        "
+            "p99 and maximum latencies and the request sizes of the reads,\r\n        "
+            "writes, erases, flushes and trims of each MTD device and the\r\n        "
+            "hit rate of the dentry cache. The -r option clears the\r\n        "
+            "statistics, the -i option displays the device\r\n        "
+            "statistics of consecutive intervals of the given length.\r\n        "
+            "Usage: iostat [-r] [-i <seconds> [count]]\r\n",
+    .tokenizeArgs = true,
+    .context = NULL,
+    .binding = cli_command_iostat
+};
+
 static CliCommandBinding ls_binding = {
     .name = "ls",
     .help = "List directory contents or mount points.\r\n        "
@@ -218,6 +233,8 @@ void cli_init_command_bindings(EmbeddedCli *cli)
     assert(ret);
     ret = embeddedCliAddBinding(cli, memstat_binding);
     assert(ret);
+    ret = embeddedCliAddBinding(cli, iostat_binding);
+    assert(ret);
     ret = embeddedCliAddBinding(cli, ls_binding);
     assert(ret);
     ret = embeddedCliAddBinding(cli, cd_binding);
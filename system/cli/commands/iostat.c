@@ -0,0 +1,362 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     system_cli
+ * @{
+ * @file        iostat.c
+ * @brief       MTD Device and Dentry Cache I/O Statistics
+ */
+#include "embedded_cli.h"
+#include "cli_config.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "mtd.h"
+#include "stdio_base.h"
+#include "vfs.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define IOSTAT_DEFAULT_COUNT    5ul
+#define IOSTAT_MAX_INTERVAL_S   3600ul
+
+static const char *_op_names[MTD_STATS_OP_NUMOF] = {
+    [MTD_STATS_READ]  = "read",
+    [MTD_STATS_WRITE] = "write",
+    [MTD_STATS_ERASE] = "erase",
+    [MTD_STATS_FLUSH] = "flush",
+    [MTD_STATS_TRIM]  = "trim",
+};
+
+static mtd_stats_t _stats;
+
+static void print_device_statistics(unsigned idx, const mtd_dev_t *mtd, const mtd_stats_t *stats);
+static void print_dcache_statistics(void);
+static void print_fcache_statistics(void);
+static void print_stdio_statistics(void);
+static void print_size_distribution(const mtd_op_stats_t *stats);
+static void print_interval_statistics(unsigned idx, const mtd_stats_t *prev, const mtd_stats_t *curr, uint32_t interval_s);
+static void subtract_statistics(mtd_op_stats_t *diff, const mtd_op_stats_t *prev, const mtd_op_stats_t *curr);
+static void run_periodic_refresh(uint32_t interval_s, uint32_t count);
+
+/**
+ * @brief Function that is executed when the iostat command is entered.
+ *        Displays the I/O statistics of the initialized MTD devices.
+ *
+ * Without arguments the statistics accumulated since the start (or the last
+ * reset) are printed for every device: the number of operations, errors and
+ * bytes, the p50, p99 and maximum latencies and the distribution of the
+ * request sizes. The hit rate of the dentry cache and the usage of the file
+ * cache of the VFS and the receive statistics of the console are printed
+ * after them. The -r option clears the statistics of all devices. The -i
+ * option prints the statistics of each interval of the given length instead,
+ * the given number of times.
+ *
+ * @param cli     Pointer to the EmbeddedCli instance (unused).
+ * @param args    Pointer to the arguments passed to the command, "-r" or
+ *                "-i <seconds> [count]".
+ * @param context Pointer to additional context data (unused).
+ */
+void cli_command_iostat(EmbeddedCli *cli, char *args, void *context)
+{
+    (void)cli;
+    (void)context;
+
+    const int argc = embeddedCliGetTokenCount(args);
+
+    if (argc > 0)
+    {
+        const char *option = embeddedCliGetToken(args, 1);
+
+        if (0 == strncmp(option, "-r", CLI_CMD_BUFFER_SIZE))
+        {
+            for (unsigned i = 0; NULL != mtd_stats_dev_get(i); i++)
+            {
+                mtd_stats_reset(mtd_stats_dev_get(i));
+            }
+            vfs_dcache_stats_reset();
+            vfs_fcache_stats_reset();
+            stdio_stats_reset();
+            printf("  I/O statistics cleared.\r\n");
+            return;
+        }
+
+        if ((0 == strncmp(option, "-i", CLI_CMD_BUFFER_SIZE)) && (argc > 1))
+        {
+            const int interval_s = atoi(embeddedCliGetToken(args, 2));
+            const int count = (argc > 2) ? atoi(embeddedCliGetToken(args, 3)) : (int)IOSTAT_DEFAULT_COUNT;
+
+            if ((interval_s < 1) || (interval_s > (int)IOSTAT_MAX_INTERVAL_S) || (count < 1))
+            {
+                printf("  iostat: invalid interval or count\r\n");
+                return;
+            }
+
+            run_periodic_refresh((uint32_t)interval_s, (uint32_t)count);
+            return;
+        }
+
+        printf("  iostat: unknown option \"%s\"\r\n", option);
+        return;
+    }
+
+    if (NULL == mtd_stats_dev_get(0))
+    {
+        printf("  No MTD device has been initialized.\r\n");
+    }
+
+    for (unsigned i = 0; NULL != mtd_stats_dev_get(i); i++)
+    {
+        const mtd_dev_t *mtd = mtd_stats_dev_get(i);
+        mtd_stats_get(mtd, &_stats);
+        print_device_statistics(i, mtd, &_stats);
+    }
+
+    print_dcache_statistics();
+    print_fcache_statistics();
+    print_stdio_statistics();
+}
+
+/**
+ * @brief Prints the statistics of the dentry cache of the VFS.
+ */
+static void print_dcache_statistics(void)
+{
+    vfs_dcache_stats_t stats;
+    vfs_dcache_stats_get(&stats);
+
+    const uint32_t hits = stats.hits + stats.negative_hits;
+    const uint32_t lookups = hits + stats.misses;
+    const uint32_t rate = (0 != lookups) ? (uint32_t)((100ull * hits) / lookups) : 0;
+
+    printf("\r\n  Dentry cache: %lu lookups, %lu hits (%lu negative), %lu misses, %lu%% hit rate\r\n",
+           (unsigned long)lookups,
+           (unsigned long)hits,
+           (unsigned long)stats.negative_hits,
+           (unsigned long)stats.misses,
+           (unsigned long)rate);
+    printf("                %lu invalidations, %lu evictions\r\n",
+           (unsigned long)stats.invalidations,
+           (unsigned long)stats.evictions);
+}
+
+/**
+ * @brief Prints the statistics of the file cache of the VFS.
+ */
+static void print_fcache_statistics(void)
+{
+    vfs_fcache_stats_t stats;
+    vfs_fcache_stats_get(&stats);
+
+    printf("\r\n  File cache:   %lu / %lu bytes, %lu hits, %lu loads\r\n",
+           (unsigned long)stats.bytes,
+           (unsigned long)VFS_FCACHE_BUDGET,
+           (unsigned long)stats.hits,
+           (unsigned long)stats.loads);
+    printf("                %lu invalidations, %lu evictions\r\n",
+           (unsigned long)stats.invalidations,
+           (unsigned long)stats.evictions);
+}
+
+/**
+ * @brief Prints the receive statistics of the console.
+ */
+static void print_stdio_statistics(void)
+{
+    stdio_stats_t stats;
+    stdio_stats_get(&stats);
+
+    printf("\r\n  Console Rx:   %lu bytes, %lu dropped, %lu overruns, %lu errors\r\n",
+           (unsigned long)stats.rx_bytes,
+           (unsigned long)stats.rx_dropped,
+           (unsigned long)stats.rx_overruns,
+           (unsigned long)stats.rx_errors);
+}
+
+/**
+ * @brief Prints the accumulated statistics of a MTD device.
+ */
+static void print_device_statistics(unsigned idx, const mtd_dev_t *mtd, const mtd_stats_t *stats)
+{
+    printf("\r\n  mtd%u: %lu sectors, %lu B / sector\r\n\r\n", idx,
+           (unsigned long)mtd->sector_count,
+           (unsigned long)(mtd->pages_per_sector * mtd->page_size));
+    printf("     Op   |     Ops    |   Errors   |      Bytes     |  p50 us  |  p99 us  |  max us  \r\n");
+    printf("  --------+------------+------------+----------------+----------+----------+----------\r\n");
+
+    for (unsigned op = 0; op < MTD_STATS_OP_NUMOF; op++)
+    {
+        const mtd_op_stats_t *s = &stats->op[op];
+        printf("   %-6s | %10lu | %10lu | %14llu | %8lu | %8lu | %8lu\r\n",
+               _op_names[op],
+               (unsigned long)s->ops,
+               (unsigned long)s->errors,
+               (unsigned long long)s->bytes,
+               (unsigned long)mtd_stats_latency_percentile(s, 50),
+               (unsigned long)mtd_stats_latency_percentile(s, 99),
+               (unsigned long)s->latency_max);
+    }
+
+    printf("\r\n  Request sizes:\r\n");
+
+    for (unsigned op = 0; op < MTD_STATS_OP_NUMOF; op++)
+    {
+        if (0 != stats->op[op].ops)
+        {
+            printf("   %-6s |", _op_names[op]);
+            print_size_distribution(&stats->op[op]);
+        }
+    }
+}
+
+/**
+ * @brief Prints the non-empty request size buckets of an operation type,
+ *        labelled with the smallest size they count.
+ */
+static void print_size_distribution(const mtd_op_stats_t *stats)
+{
+    for (unsigned i = 0; i < MTD_STATS_SIZE_BUCKETS; i++)
+    {
+        if (0 == stats->size_hist[i])
+        {
+            continue;
+        }
+
+        const uint32_t size = 1ul << i;
+        const char *plus = (MTD_STATS_SIZE_BUCKETS - 1 == i) ? "+" : "";
+
+        if (size >= 1024ul)
+        {
+            printf(" %luK%s:%lu", (unsigned long)(size / 1024ul), plus, (unsigned long)stats->size_hist[i]);
+        }
+        else
+        {
+            printf(" %lu%s:%lu", (unsigned long)size, plus, (unsigned long)stats->size_hist[i]);
+        }
+    }
+
+    printf("\r\n");
+}
+
+/**
+ * @brief Prints the statistics of the operations completed between two
+ *        snapshots of a MTD device.
+ */
+static void print_interval_statistics(unsigned idx, const mtd_stats_t *prev, const mtd_stats_t *curr, uint32_t interval_s)
+{
+    for (unsigned op = 0; op < MTD_STATS_OP_NUMOF; op++)
+    {
+        mtd_op_stats_t diff;
+        subtract_statistics(&diff, &prev->op[op], &curr->op[op]);
+
+        if (0 == diff.ops)
+        {
+            continue;
+        }
+
+        printf("   mtd%-2u | %-6s | %8lu | %8lu | %10lu | %8lu | %8lu | %8lu\r\n",
+               idx,
+               _op_names[op],
+               (unsigned long)(diff.ops / interval_s),
+               (unsigned long)diff.errors,
+               (unsigned long)(diff.bytes / 1024ull / interval_s),
+               (unsigned long)mtd_stats_latency_percentile(&diff, 50),
+               (unsigned long)mtd_stats_latency_percentile(&diff, 99),
+               (unsigned long)mtd_stats_latency_percentile(&diff, 100));
+    }
+}
+
+/**
+ * @brief Computes the statistics of the operations accounted between two
+ *        snapshots. The maximum latency is not known for the interval, it is
+ *        estimated from the latency histogram.
+ */
+static void subtract_statistics(mtd_op_stats_t *diff, const mtd_op_stats_t *prev, const mtd_op_stats_t *curr)
+{
+    diff->ops = curr->ops - prev->ops;
+    diff->errors = curr->errors - prev->errors;
+    diff->bytes = curr->bytes - prev->bytes;
+    diff->latency_max = curr->latency_max;
+
+    for (unsigned i = 0; i < MTD_STATS_SIZE_BUCKETS; i++)
+    {
+        diff->size_hist[i] = curr->size_hist[i] - prev->size_hist[i];
+    }
+
+    for (unsigned i = 0; i < MTD_STATS_LATENCY_BUCKETS; i++)
+    {
+        diff->latency_hist[i] = curr->latency_hist[i] - prev->latency_hist[i];
+    }
+}
+
+/**
+ * @brief Prints the statistics of the consecutive intervals of the given
+ *        length. The command line is blocked until all intervals elapsed.
+ */
+static void run_periodic_refresh(uint32_t interval_s, uint32_t count)
+{
+    mtd_stats_t *prev = pvPortMalloc(MTD_STATS_DEVS_NUMOF * sizeof(mtd_stats_t));
+    mtd_stats_t *curr = pvPortMalloc(sizeof(mtd_stats_t));
+
+    if ((NULL == prev) || (NULL == curr))
+    {
+        printf("  Not enough memory.\r\n");
+        vPortFree(prev);
+        vPortFree(curr);
+        return;
+    }
+
+    /* devices initialized later are compared to empty statistics */
+    memset(prev, 0, MTD_STATS_DEVS_NUMOF * sizeof(mtd_stats_t));
+
+    for (unsigned i = 0; NULL != mtd_stats_dev_get(i); i++)
+    {
+        mtd_stats_get(mtd_stats_dev_get(i), &prev[i]);
+    }
+
+    TickType_t last_wake_time = xTaskGetTickCount();
+
+    for (uint32_t n = 0; n < count; n++)
+    {
+        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(interval_s * 1000ul));
+
+        printf("\r\n   Dev   |   Op   |  Ops/s   |  Errors  |   KiB/s    |  p50 us  |  p99 us  |  max us  \r\n");
+        printf("  -------+--------+----------+----------+------------+----------+----------+----------\r\n");
+
+        for (unsigned i = 0; NULL != mtd_stats_dev_get(i); i++)
+        {
+            mtd_stats_get(mtd_stats_dev_get(i), curr);
+            print_interval_statistics(i, &prev[i], curr, interval_s);
+            prev[i] = *curr;
+        }
+    }
+
+    vPortFree(prev);
+    vPortFree(curr);
+}
+/** @} */
@@ -62,7 +62,7 @@ void cli_command_runtime_stats(EmbeddedCli *cli, char *args, void *context)
     const uint32_t number_of_tasks = uxTaskGetNumberOfTasks();
     TaskStatus_t *tasks = pvPortMalloc(number_of_tasks * sizeof(TaskStatus_t));
     uint32_t total_runtime;
-    char cpu_usage_str[8];
+    char cpu_usage_str[12];
 
     if (NULL == tasks)
     {
@@ -87,7 +87,7 @@ void cli_command_runtime_stats(EmbeddedCli *cli, char *args, void *context)
         const uint32_t cpu_usage = tasks[i].ulRunTimeCounter / total_runtime;
         if (cpu_usage > 0ul)
         {
-            snprintf(cpu_usage_str, sizeof(cpu_usage_str), "%3lu%%", cpu_usage);
+            snprintf(cpu_usage_str, sizeof(cpu_usage_str), "%3lu%%", (unsigned long)cpu_usage);
         }
         else
         {
@@ -99,7 +99,7 @@ void cli_command_runtime_stats(EmbeddedCli *cli, char *args, void *context)
                tasks[i].pcTaskName,
                _task_states[tasks[i].eCurrentState],
                tasks[i].uxCurrentPriority,
-               tasks[i].ulRunTimeCounter,
+               (unsigned long)tasks[i].ulRunTimeCounter,
                cpu_usage_str);
     }
 
@@ -148,7 +148,7 @@ void cli_command_task_stats(EmbeddedCli *cli, char *args, void *context)
                tasks[i].pcTaskName,
                _task_states[tasks[i].eCurrentState],
                tasks[i].uxCurrentPriority,
-               stack_size, stack_usage);
+               (unsigned long)stack_size, stack_usage);
     }
 
     vPortFree(tasks);
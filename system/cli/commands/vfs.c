@@ -47,9 +47,11 @@
 #include <sys/time.h>
 
 #define MAX_NUM_OF_FILES    2796202ul
+#define LS_BATCH_SIZE       8u
 
 static char _work_area[1024ul];
 static char _path[VFS_NAME_MAX + 1];
+static vfs_dirent_stat_t _entries[LS_BATCH_SIZE];
 
 static const char *get_unit(const uint64_t size, uint64_t *converted);
 static void list_mountpoints(void);
@@ -473,7 +475,11 @@ static void list_mountpoints(void)
         const uint32_t use = (uint32_t)(((buf.f_blocks - buf.f_bfree) * 100) / buf.f_blocks);
 
         printf("  %-10s | %10llu %2s | %10llu %2s | %10llu %2s | %7lu %%\r\n",
-               dir.mp->mount_point, total_conv, total_unit, used_conv, used_unit, free_conv, free_unit, use);
+               dir.mp->mount_point,
+               (unsigned long long)total_conv, total_unit,
+               (unsigned long long)used_conv, used_unit,
+               (unsigned long long)free_conv, free_unit,
+               (unsigned long)use);
     }
 }
 
@@ -523,6 +529,8 @@ static const char *get_unit(const uint64_t size, uint64_t *converted)
  *
  * This function opens the directory specified by the given path and iterates through its contents,
  * printing details such as modification date, size (for files), and name of each item.
+ * The entries are read in batches together with their attributes, so the directory is
+ * scanned only once.
  *
  * @param path The path of the directory to list items from.
  */
@@ -546,53 +554,47 @@ static void list_items_in_path(const char *path)
 
     printf("\r\n  Directory of %s\r\n\r\n", path);
 
-    for (uint32_t i = 0; i < MAX_NUM_OF_FILES; i++)
+    uint32_t nitems = 0;
+    while (nitems < MAX_NUM_OF_FILES)
     {
-        vfs_dirent_t entry;
-        res = vfs_readdir(&dir, &entry);
-        if (res < 0) {
-            printf("\r\n  vfs_readdir error: %s\r\n", strerror(-res));
+        ssize_t count = vfs_readdir_batch(&dir, _entries, LS_BATCH_SIZE);
+        if (count < 0) {
+            printf("\r\n  vfs_readdir_batch error: %s\r\n", strerror(-count));
             break;
         }
-        if (res == 0) {
+        if (count == 0) {
             break;
         }
 
-        memset(_work_area, 0x00, (2 * (VFS_NAME_MAX + 1)));
-        snprintf(_work_area, sizeof(_work_area), "%s/%s", _path, entry.d_name);
-
-        struct stat stat;
-        int err = vfs_stat(_work_area, &stat);
-        if (err < 0) {
-            printf("\r\n  vfs_stat error: %s\r\n", strerror(-err));
-            break;
-        }
-
-        struct tm tbuf;
-        char mdate[11] = {'\0'};
-        strftime(mdate, sizeof(mdate), "%m/%d/%Y", localtime_r(&stat.st_mtim.tv_sec, &tbuf));
-        char mtime[6] = {'\0'};
-        strftime(mtime, sizeof(mtime), "%H:%M", localtime_r(&stat.st_mtim.tv_sec, &tbuf));
-
-        char filesize[17] = {'\0'};
-        if (stat.st_mode & S_IFDIR)
-        {
-            snprintf(filesize, sizeof(filesize), "%-16s", "<DIR>");
-            ndirs++;
-        }
-        else if (stat.st_mode & S_IFREG)
+        for (ssize_t i = 0; (i < count) && (nitems < MAX_NUM_OF_FILES); i++, nitems++)
         {
-            snprintf(filesize, sizeof(filesize), "%16lu", stat.st_size);
-            nfiles++;
-        }
-        else
-        {
-            snprintf(filesize, sizeof(filesize), " ");
-        }
-
+            const vfs_dirent_stat_t *entry = &_entries[i];
+
+            struct tm tbuf;
+            char mdate[11] = {'\0'};
+            strftime(mdate, sizeof(mdate), "%m/%d/%Y", localtime_r(&entry->d_mtim.tv_sec, &tbuf));
+            char mtime[6] = {'\0'};
+            strftime(mtime, sizeof(mtime), "%H:%M", localtime_r(&entry->d_mtim.tv_sec, &tbuf));
+
+            char filesize[17] = {'\0'};
+            if (S_ISDIR(entry->d_mode))
+            {
+                snprintf(filesize, sizeof(filesize), "%-16s", "<DIR>");
+                ndirs++;
+            }
+            else if (S_ISREG(entry->d_mode))
+            {
+                snprintf(filesize, sizeof(filesize), "%16lu", (unsigned long)entry->d_size);
+                nfiles++;
+            }
+            else
+            {
+                snprintf(filesize, sizeof(filesize), " ");
+            }
 
-        printf("%10s  %5s  %16s %s\r\n",
-               mdate, mtime, filesize, entry.d_name);
+            printf("%10s  %5s  %16s %s\r\n",
+                   mdate, mtime, filesize, entry->d_name);
+        }
     }
 
     printf("\r\n%16u Dir(s)\r\n", ndirs);
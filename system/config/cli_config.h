@@ -27,13 +27,20 @@
 #define CLI_PRINT_BUFFER_SIZE          512
 
 /**
- * @brief Definitions for CLI task priorities, stack and queue sizes
+ * @brief Definitions for the CLI task priority and stack size
  */
-#define CLI_IO_READ_TASK_PRIORITY      2ul
-#define CLI_IO_READ_TASK_STACK_SIZE    (configMINIMAL_STACK_SIZE)
-#define CLI_PROCESS_TASK_PRIORITY      2ul
-#define CLI_PROCESS_TASK_STACK_SIZE    (configMINIMAL_STACK_SIZE + 31 * configMINIMAL_STACK_SIZE)
-#define CLI_RX_QUEUE_LENGTH            1ul
+#define CLI_TASK_PRIORITY              2ul
+#define CLI_TASK_STACK_SIZE            (configMINIMAL_STACK_SIZE + 31 * configMINIMAL_STACK_SIZE)
+
+/**
+ * @brief Definitions for the stdin listener of the CLI. The characters are
+ *        copied from the stdin receive ring in chunks of CLI_RX_CHUNK_SIZE
+ *        and processed after each chunk, CLI_RX_CHUNK_SIZE must not exceed
+ *        CLI_RX_BUFFER_SIZE. The CLI task is woken up with the task
+ *        notification at CLI_RX_NOTIFY_INDEX.
+ */
+#define CLI_RX_CHUNK_SIZE              16ul
+#define CLI_RX_NOTIFY_INDEX            0ul
 
 #endif /* __CLI_CONFIG_H__ */
 /** @} */
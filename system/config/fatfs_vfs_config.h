@@ -0,0 +1,47 @@
+/**
+ * @ingroup    system_config
+ *
+ * @{
+ * @file       fatfs_vfs_config.h
+ * @brief      FatFs VFS wrapper configuration options
+ *
+ */
+#ifndef __FATFS_VFS_CONFIG_H__
+#define __FATFS_VFS_CONFIG_H__
+
+/**
+ * @brief Definitions for the read-ahead. A file is read ahead after
+ *        FATFS_READAHEAD_TRIGGER consecutive reads without a seek, into two
+ *        buffers of the window size (set per file with VFS_F_SETRA). The
+ *        window is rounded up to a multiple of the sector size.
+ */
+#define FATFS_READAHEAD_DEFAULT_WINDOW          4096ul
+#define FATFS_READAHEAD_MAX_WINDOW              (64ul * 1024ul)
+#define FATFS_READAHEAD_TRIGGER                 2ul
+#define FATFS_READAHEAD_TASK_PRIORITY           3ul
+#define FATFS_READAHEAD_TASK_STACKSIZE          (configMINIMAL_STACK_SIZE * 2)
+#define FATFS_READAHEAD_QUEUE_LENGTH            VFS_MAX_OPEN_FILES
+
+/**
+ * @brief Definitions for the fast seek. The cluster link map table of a file
+ *        of at least FATFS_FASTSEEK_MIN_SIZE bytes is built on the first seek
+ *        into another cluster and freed on close. It starts with
+ *        FATFS_FASTSEEK_INITIAL_ENTRIES entries and is rebuilt with the size
+ *        reported by FatFs if the file is more fragmented, files needing more
+ *        than FATFS_FASTSEEK_MAX_ENTRIES entries (2 per fragment) are seeked
+ *        by following the FAT chain.
+ */
+#define FATFS_FASTSEEK_MIN_SIZE                 (256ul * 1024ul)
+#define FATFS_FASTSEEK_INITIAL_ENTRIES          32ul
+#define FATFS_FASTSEEK_MAX_ENTRIES              1024ul
+
+/**
+ * @brief Number of pending discard (CTRL_TRIM) ranges per volume. Adjacent
+ *        ranges are merged, the pending ranges are erased on CTRL_SYNC after
+ *        the cache is flushed. The smallest range is forgotten when no slot
+ *        is left, written sectors are removed from the ranges.
+ */
+#define FATFS_TRIM_RANGES_NUMOF                 8ul
+
+#endif /* __FATFS_VFS_CONFIG_H__ */
+/** @} */
@@ -46,7 +46,7 @@
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 
-#define FF_USE_EXPAND         0
+#define FF_USE_EXPAND         1
 /* This option switches f_expand function. (0:Disable or 1:Enable) */
 
 
@@ -221,7 +221,7 @@
 /  f_fdisk function. 0x100000000 max. This option has no effect when FF_LBA64 == 0. */
 
 
-#define FF_USE_TRIM           0
+#define FF_USE_TRIM           1
 /* This option switches support for ATA-TRIM. (0:Disable or 1:Enable)
 /  To enable Trim function, also CTRL_TRIM command should be implemented to the
 /  disk_ioctl() function. */
@@ -271,7 +271,13 @@
 */
 
 
-#define FF_FS_LOCK            2
+/* One lock per open file of the VFS, plus the open directories. Keep the
+/  fallback in sync with the default VFS_MAX_OPEN_FILES of vfs.h. */
+#ifdef VFS_MAX_OPEN_FILES
+#define FF_FS_LOCK            (VFS_MAX_OPEN_FILES + 8)
+#else
+#define FF_FS_LOCK            (16 + 8)
+#endif
 /* The option FF_FS_LOCK switches file lock function to control duplicated file open
 /  and illegal operation to open objects. This option must be 0 when FF_FS_READONLY
 /  is 1.
@@ -0,0 +1,36 @@
+/**
+ * @ingroup    system_config
+ *
+ * @{
+ * @file       mtd_cache_config.h
+ * @brief      MTD block cache configuration options
+ *
+ */
+#ifndef __MTD_CACHE_CONFIG_H__
+#define __MTD_CACHE_CONFIG_H__
+
+/**
+ * @brief Default geometry of the block cache. The capacity is
+ *        sets * ways * sector size of the cached device (16 KiB with 512 byte
+ *        SD Card blocks). The number of sets must be a power of two.
+ */
+#define MTD_CACHE_NUMOF_SETS                    8ul
+#define MTD_CACHE_NUMOF_WAYS                    4ul
+
+/**
+ * @brief Transfers of at least this many sectors bypass the cache, so bulk
+ *        file data does not evict the FAT and directory sectors and keeps
+ *        using multi-block transfers.
+ */
+#define MTD_CACHE_BYPASS_THRESHOLD              4ul
+
+/**
+ * @brief Maximum number of dirty lines caching consecutive sectors that are
+ *        written back with a single multi-block transfer. A staging buffer
+ *        of this many sectors is allocated with the cache, 1 disables the
+ *        write combining.
+ */
+#define MTD_CACHE_WRITE_COMBINE_SECTORS         8ul
+
+#endif /* __MTD_CACHE_CONFIG_H__ */
+/** @} */
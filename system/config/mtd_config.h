@@ -0,0 +1,42 @@
+/**
+ * @ingroup    system_config
+ *
+ * @{
+ * @file       mtd_config.h
+ * @brief      MTD I/O statistics configuration options
+ *
+ */
+#ifndef __MTD_CONFIG_H__
+#define __MTD_CONFIG_H__
+
+/**
+ * @brief Maximum number of initialized MTD devices whose statistics can be
+ *        listed by the iostat command.
+ */
+#define MTD_STATS_DEVS_NUMOF                    4ul
+
+/**
+ * @brief Number of request size buckets. Bucket n counts the operations of
+ *        2^n to 2^(n+1)-1 bytes, the last bucket also counts the larger ones.
+ */
+#define MTD_STATS_SIZE_BUCKETS                  16ul
+
+/**
+ * @brief Number of latency buckets. Bucket 0 counts the operations completed
+ *        within the resolution of the timer, bucket n the ones that took
+ *        2^(n-1) to 2^n-1 microseconds, the last bucket also counts the
+ *        slower ones.
+ */
+#define MTD_STATS_LATENCY_BUCKETS               21ul
+
+/**
+ * @brief Period of the FreeRTOS run time statistics counter in microseconds,
+ *        which is used to time the operations. The counter of the runtime
+ *        statistics timer is incremented at 10 kHz.
+ */
+#ifndef MTD_STATS_RUN_TIME_COUNTER_US
+#define MTD_STATS_RUN_TIME_COUNTER_US           100ul
+#endif
+
+#endif /* __MTD_CONFIG_H__ */
+/** @} */
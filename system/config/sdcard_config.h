@@ -40,6 +40,24 @@
 #define SDCARD_D0_PIN                           GPIO_PIN_8
 #define SDCARD_GPIO_AFx_SDIO                    GPIO_AF12_SDIO
 
+/**
+ * @brief Definitions for the busy-end detection on the D0 line. The card
+ *        holds D0 low while it is programming, the rising edge is detected
+ *        with the EXTI. EXTI9_5 is shared with the USB Host over-current pin,
+ *        so the same interrupt priority is used.
+ */
+#define SDCARD_D0_PIN_EXTI_GPIO                 EXTI_GPIOC
+#define SDCARD_D0_PIN_EXTI_LINE                 EXTI_LINE_8
+#define SDCARD_D0_PIN_EXTIx_IRQn                EXTI9_5_IRQn
+#define SDCARD_D0_PIN_EXTIx_IRQ_PRIORITY        6ul
+
+/**
+ * @brief Number of times the D0 line is sampled before the driver blocks on
+ *        the busy-end interrupt. Short busy periods are caught by the spin
+ *        without a context switch.
+ */
+#define SDCARD_BUSY_SPIN_COUNT                  256ul
+
 /**
  * @brief Definitions for the Tx / Rx DMA Channels and interrupts
  */
@@ -54,9 +72,34 @@
 #define SDCARD_DMAx_TX_IRQ_PRIORITY             15ul
 #define SDCARD_DMAx_RX_IRQ_PRIORITY             15ul
 #define SDCARD_DMA_BLOCK_TRANSFER_TIMEOUT_MS    5000ul
+
+/**
+ * @brief High-Speed mode is negotiated (CMD6) with the cards supporting it
+ *        when set to 1, the bus is then clocked directly from the 48 MHz
+ *        SDIO clock (bypass) instead of 48 MHz / 2. The driver falls back to
+ *        the default speed clock if a transfer fails with a CRC error.
+ */
+#define SDCARD_HIGH_SPEED_ENABLE                1ul
 #define SDCARD_DMAx_RX_STREAM_IRQHandler        DMA2_Stream3_IRQHandler
 #define SDCARD_DMAx_TX_STREAM_IRQHandler        DMA2_Stream6_IRQHandler
 
+/**
+ * @brief Size of the bounce buffer used for transfers from / to buffers that
+ *        are not word-aligned. Must be a multiple of the 512 byte block size,
+ *        larger buffers allow longer multi-block transfers (4 - 16 KiB).
+ */
+#define SDCARD_BOUNCE_BUFFER_SIZE               (8ul * 1024ul)
+
+/**
+ * @brief Definitions for the SD Card I/O task and its request queue. The
+ *        notification index is used to signal the completion of a request
+ *        to the submitting task, index 0 is used by the SD Card monitor.
+ */
+#define SDCARD_IO_TASK_PRIORITY                 5ul
+#define SDCARD_IO_TASK_STACKSIZE                (configMINIMAL_STACK_SIZE * 2)
+#define SDCARD_REQUEST_QUEUE_LENGTH             8ul
+#define SDCARD_TASK_NOTIFICATION_INDEX          1ul
+
 #endif /* __SDCARD_CONFIG_H__ */
 /** @} */
 
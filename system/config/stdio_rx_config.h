@@ -0,0 +1,42 @@
+/**
+ * @ingroup    system_config
+ *
+ * @{
+ * @file       stdio_rx_config.h
+ * @brief      STDIO receive ring configuration options
+ *
+ */
+#ifndef __STDIO_RX_CONFIG_H__
+#define __STDIO_RX_CONFIG_H__
+
+/**
+ * @brief Size of the receive ring shared by the stdin listeners. Each
+ *        listener can fall behind the newest received byte by this many
+ *        bytes. Must be a power of two.
+ */
+#define STDIO_RX_RING_SIZE                      1024ul
+
+/**
+ * @brief Index of the task notification used by stdio_read() to wait for
+ *        received bytes. Index 0 is used by the CLI (CLI_RX_NOTIFY_INDEX)
+ *        and the SD card monitor, index 1 by the SD card driver
+ *        (SDCARD_TASK_NOTIFICATION_INDEX) and index 3 by the asynchronous
+ *        file I/O (VFS_AIO_NOTIFY_INDEX).
+ */
+#define STDIO_RX_NOTIFY_INDEX                   2ul
+
+/**
+ * @brief Default timing of stdio_read(), following the non-canonical mode of
+ *        a POSIX terminal. With STDIO_RX_VMIN > 0 the read returns once that
+ *        many bytes have been received, or once STDIO_RX_VTIME tenths of a
+ *        second passed without a new byte after the first one (if not 0).
+ *        With STDIO_RX_VMIN = 0 the read returns as soon as any byte has been
+ *        received or STDIO_RX_VTIME tenths of a second passed. The bytes
+ *        already received are always returned as well, up to the requested
+ *        length.
+ */
+#define STDIO_RX_VMIN                           1ul
+#define STDIO_RX_VTIME                          0ul
+
+#endif /* __STDIO_RX_CONFIG_H__ */
+/** @} */
@@ -10,18 +10,35 @@
 #define __STDIO_UART_CONFIG_H__
 
 /**
- * @brief Definitions for the read and write tasks and queues
+ * @brief Definitions for the read and write tasks
  */
-#define STDIO_UART_RX_QUEUE_LENGTH              8ul
-#define STDIO_UART_TX_AVAIL_QUEUE_LENGTH        16ul
-#define STDIO_UART_TX_READY_QUEUE_LENGTH        STDIO_UART_TX_AVAIL_QUEUE_LENGTH
 #define STDIO_UART_WRITE_TASK_PRIORITY          4ul
 #define STDIO_UART_WRITE_TASK_STACKSIZE         configMINIMAL_STACK_SIZE
-#define STDIO_UART_TX_BUFFER_DEPTH              512ul
 #define STDIO_UART_READ_TASK_PRIORITY           4ul
 #define STDIO_UART_READ_TASK_STACKSIZE          configMINIMAL_STACK_SIZE
-#define STDIO_UART_STDIN_QUEUE_LENGTH           1ul
-#define STDIO_UART_MAX_NUM_OF_STDIN_LISTENERS   10ul
+
+/**
+ * @brief Definitions for the Tx byte ring
+ *
+ * stdio_write() appends to the ring and the write task transmits the largest
+ * contiguous span of it with a single DMA transfer. When the line is idle and
+ * less than STDIO_UART_TX_FLUSH_THRESHOLD bytes are pending, the write task
+ * waits at most STDIO_UART_TX_FLUSH_TIMEOUT_MS for more data to coalesce.
+ * The ring size must be a power of two and at most 32768 bytes.
+ */
+#define STDIO_UART_TX_RING_SIZE                 4096ul
+#define STDIO_UART_TX_FLUSH_THRESHOLD           64ul
+#define STDIO_UART_TX_FLUSH_TIMEOUT_MS          2ul
+
+/**
+ * @brief Size of the Rx DMA buffer
+ *
+ * The receiver fills the buffer continuously in circular DMA mode and the
+ * read task is woken up on the half transfer, transfer complete and idle
+ * line events. The buffer must hold the bytes arriving while the read task
+ * is not scheduled, must be a power of two and at most 32768 bytes.
+ */
+#define STDIO_UART_RX_DMA_BUFFER_SIZE           256ul
 
 /**
  * @brief Definition of the used USART peripheral
@@ -50,6 +67,15 @@
 #define STDIO_UART_IRQHandler                   USART3_IRQHandler
 #define STDIO_UART_DMA_STREAM_IRQHandler        DMA1_Stream3_IRQHandler
 
+/**
+ * @brief Definitions for the Rx DMA channel and interrupts
+ */
+#define STDIO_UART_DMAx_RX_STREAMx              DMA1_Stream1
+#define STDIO_UART_DMA_RX_CHANNELx              DMA_CHANNEL_4
+#define STDIO_UART_DMAx_RX_STREAMx_IRQn         DMA1_Stream1_IRQn
+#define STDIO_UART_DMAx_RX_STREAMx_IRQ_PRIORITY 8ul
+#define STDIO_UART_DMA_RX_STREAM_IRQHandler     DMA1_Stream1_IRQHandler
+
 #endif /* __STDIO_UART_CONFIG_H__ */
 /** @} */
 
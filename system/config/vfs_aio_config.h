@@ -0,0 +1,36 @@
+/**
+ * @ingroup    system_config
+ *
+ * @{
+ * @file       vfs_aio_config.h
+ * @brief      Asynchronous file I/O configuration options
+ *
+ */
+#ifndef __VFS_AIO_CONFIG_H__
+#define __VFS_AIO_CONFIG_H__
+
+/**
+ * @brief Definitions for the I/O worker pool. Requests on different files
+ *        are serviced in parallel by up to VFS_AIO_WORKERS_NUMOF tasks,
+ *        requests on the same file descriptor are serviced one at a time in
+ *        submission order.
+ */
+#define VFS_AIO_WORKERS_NUMOF                   2ul
+#define VFS_AIO_TASK_PRIORITY                   3ul
+#define VFS_AIO_TASK_STACKSIZE                  (configMINIMAL_STACK_SIZE * 4)
+
+/**
+ * @brief Maximum number of requests queued at the same time, submitting
+ *        more fails with -EAGAIN.
+ */
+#define VFS_AIO_QUEUE_LENGTH                    16ul
+
+/**
+ * @brief Index of the task notification given to the task set in
+ *        vfs_aiocb_t::notify on completion, distinct from the indexes used
+ *        by the CLI, the SD card driver and the UART receiver.
+ */
+#define VFS_AIO_NOTIFY_INDEX                    3ul
+
+#endif /* __VFS_AIO_CONFIG_H__ */
+/** @} */
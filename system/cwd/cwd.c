@@ -95,6 +95,7 @@ void cwd_deinit(void)
  *
  * @return 0 if changing the current working directory was successful
  * @return -ENAMETOOLONG if the path combined with cwd is larger than VFS_NAME_MAX
+ * @return -ENOTDIR if the path is not a directory
  */
 int chdir(const char *__path)
 {
@@ -114,19 +115,19 @@ int chdir(const char *__path)
         return 0;
     }
 
-    vfs_DIR dir;
-    res = vfs_opendir(&dir, _path);
+    /* answered by the dentry cache when the path was looked up recently */
+    struct stat st;
+    res = vfs_stat(_path, &st);
     if (res < 0) {
         return res;
     }
 
-    res = vfs_closedir(&dir);
-    if (res < 0) {
-        return res;
+    if (!S_ISDIR(st.st_mode)) {
+        return -ENOTDIR;
     }
 
     cwd_lock();
-    strncpy(_cwd, _path, VFS_NAME_MAX);
+    memcpy(_cwd, _path, sizeof(_cwd));
     cwd_unlock();
 
     return 0;
@@ -305,11 +306,12 @@ static int normalize_path(char *to, size_t to_len, const char *from, size_t from
     }
 
     // Check that fits in PATH_MAX
-    if (strnlen(work_area, work_area_len) > VFS_NAME_MAX) {
+    const size_t len = strnlen(work_area, work_area_len);
+    if ((len > VFS_NAME_MAX) || (len >= to_len)) {
         return -ENAMETOOLONG;
     }
 
-    strncpy(to, work_area, to_len);
+    memcpy(to, work_area, len + 1);
 
     return 0;
 }
@@ -35,6 +35,7 @@
 #include "sdcard_config.h"
 
 static DMA_HandleTypeDef h_stdio_uart_dma_tx;
+static DMA_HandleTypeDef h_stdio_uart_dma_rx;
 static DMA_HandleTypeDef h_sdio_dma_tx;
 static DMA_HandleTypeDef h_sdio_dma_rx;
 
@@ -63,9 +64,31 @@ HAL_StatusTypeDef stdio_uart_dma_init(UART_HandleTypeDef *huart)
 
     __HAL_LINKDMA(huart, hdmatx, h_stdio_uart_dma_tx);
 
+    h_stdio_uart_dma_rx.Instance = STDIO_UART_DMAx_RX_STREAMx;
+    h_stdio_uart_dma_rx.Init.Channel = STDIO_UART_DMA_RX_CHANNELx;
+    h_stdio_uart_dma_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    h_stdio_uart_dma_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+    h_stdio_uart_dma_rx.Init.MemInc = DMA_MINC_ENABLE;
+    h_stdio_uart_dma_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    h_stdio_uart_dma_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    h_stdio_uart_dma_rx.Init.Mode = DMA_CIRCULAR;
+    h_stdio_uart_dma_rx.Init.Priority = DMA_PRIORITY_MEDIUM;
+    h_stdio_uart_dma_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+
+    ret = HAL_DMA_Init(&h_stdio_uart_dma_rx);
+    if (HAL_OK != ret)
+    {
+        return ret;
+    }
+
+    __HAL_LINKDMA(huart, hdmarx, h_stdio_uart_dma_rx);
+
     HAL_NVIC_SetPriority(STDIO_UART_DMAx_STREAMx_IRQn, STDIO_UART_DMAx_STREAMx_IRQ_PRIORITY, 0);
     HAL_NVIC_EnableIRQ(STDIO_UART_DMAx_STREAMx_IRQn);
 
+    HAL_NVIC_SetPriority(STDIO_UART_DMAx_RX_STREAMx_IRQn, STDIO_UART_DMAx_RX_STREAMx_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(STDIO_UART_DMAx_RX_STREAMx_IRQn);
+
     return HAL_OK;
 }
 
@@ -79,7 +102,14 @@ HAL_StatusTypeDef stdio_uart_dma_deinit(UART_HandleTypeDef *huart)
         return ret;
     }
 
+    ret = HAL_DMA_DeInit(huart->hdmarx);
+    if (HAL_OK != ret)
+    {
+        return ret;
+    }
+
     HAL_NVIC_DisableIRQ(STDIO_UART_DMAx_STREAMx_IRQn);
+    HAL_NVIC_DisableIRQ(STDIO_UART_DMAx_RX_STREAMx_IRQn);
     rcc_periph_clk_disable((const void *)STDIO_UART_DMAx);
 
     return HAL_OK;
@@ -196,6 +226,14 @@ void STDIO_UART_DMA_STREAM_IRQHandler(void)
     HAL_DMA_IRQHandler(&h_stdio_uart_dma_tx);
 }
 
+/**
+ * @brief STDIO UART DMA Rx Stream Interrupt Handler
+ */
+void STDIO_UART_DMA_RX_STREAM_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&h_stdio_uart_dma_rx);
+}
+
 /**
  * @brief SDCARD DMA Rx Stream Interrupt Handler
  */
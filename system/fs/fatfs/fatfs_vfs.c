@@ -34,9 +34,17 @@
 #include <string.h>
 
 #include "fs/fatfs.h"
+#include "fatfs/source/diskio.h"
+#include "fatfs_vfs_config.h"
 
 #include "time.h"
 #include "container.h"
+#include "macros/utils.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
 
 #define ENABLE_DEBUG 0
 #include <debug.h>
@@ -44,10 +52,64 @@
 #define TEST_FATFS_MAX_VOL_STR_LEN 14 /* "-2147483648:/\0" */
 
 static int fatfs_err_to_errno(int32_t err);
+static void _readahead_task_create(void);
+static mode_t _fatfs_attrib_to_mode(BYTE fattrib);
 static void _fatfs_time_to_timespec(WORD fdate, WORD ftime, time_t *time);
 
 mtd_dev_t *fatfs_mtd_devs[FF_VOLUMES];
 
+/**
+ * @brief Returns the sector size of a volume, FatFs only stores it if
+ *        FF_MIN_SS and FF_MAX_SS differ
+ */
+static inline UINT _sector_size(const FATFS *fs)
+{
+#if FF_MAX_SS != FF_MIN_SS
+    return fs->ssize;
+#else
+    (void)fs;
+    return FF_MAX_SS;
+#endif
+}
+
+/**
+ * @brief Open directory, kept in the private buffer of a vfs_DIR
+ */
+typedef struct {
+    DIR dir;            /**< FatFs directory object */
+    FRESULT batch_err;  /**< error hit by a batch that still returned entries,
+                             reported by the next batch */
+} fatfs_dir_t;
+
+/**
+ * @brief Read-ahead state of a file
+ *
+ * Two buffers of ra_window bytes are used: the file is read from buf[cur]
+ * while buf[cur ^ 1] is filled by the read-ahead task. The FIL object is
+ * owned by the read-ahead task while a fill is pending, every other access
+ * has to wait for its completion first.
+ */
+struct fatfs_readahead {
+    uint8_t *buf[2];                /**< buffers of ra_window bytes */
+    UINT len[2];                    /**< number of valid bytes in the buffers */
+    UINT pos;                       /**< number of bytes consumed from buf[cur] */
+    FSIZE_t base;                   /**< file offset of the first byte of buf[cur] */
+    uint8_t cur;                    /**< index of the buffer being consumed */
+    bool pending;                   /**< buf[cur ^ 1] is being filled */
+    bool eof;                       /**< the last fill reached the end of file */
+    FRESULT result;                 /**< result of the last background fill */
+    SemaphoreHandle_t done;         /**< given when a background fill completes */
+    StaticSemaphore_t done_storage; /**< storage of the done semaphore */
+};
+
+static StackType_t _ra_task_stack[FATFS_READAHEAD_TASK_STACKSIZE];
+static StaticTask_t _ra_task_tcb;
+static TaskHandle_t h_ra_task = NULL;
+
+static StaticQueue_t _ra_queue_struct;
+static uint8_t _ra_queue_storage[FATFS_READAHEAD_QUEUE_LENGTH * sizeof(fatfs_file_desc_t *)];
+static QueueHandle_t _ra_queue = NULL;
+
 /**
  * @brief Concatenate drive number and path into the buffer provided by fs_desc
  *
@@ -113,10 +175,8 @@ static int _mount(vfs_mount_t *mountp)
 {
     /* if one of the lines below fail to compile you probably need to adjust
        vfs buffer sizes ;) */
-    static_assert(VFS_DIR_BUFFER_SIZE >= sizeof(DIR),
-                  "DIR must fit into VFS_DIR_BUFFER_SIZE");
-    static_assert(VFS_FILE_BUFFER_SIZE >= sizeof(fatfs_file_desc_t),
-                  "fatfs_file_desc_t must fit into VFS_FILE_BUFFER_SIZE");
+    static_assert(VFS_DIR_BUFFER_SIZE >= sizeof(fatfs_dir_t),
+                  "fatfs_dir_t must fit into VFS_DIR_BUFFER_SIZE");
 
     fatfs_desc_t *fs_desc = (fatfs_desc_t *)mountp->private_data;
 
@@ -125,6 +185,8 @@ static int _mount(vfs_mount_t *mountp)
         return -ENOMEM;
     }
 
+    _readahead_task_create();
+
     _build_abs_path(fs_desc, "");
 
     memset(&fs_desc->fat_fs, 0, sizeof(fs_desc->fat_fs));
@@ -150,6 +212,11 @@ static int _umount(vfs_mount_t *mountp)
 
     _build_abs_path(fs_desc, "");
 
+    /* the card may already be gone, unmount even if the flush fails */
+    if (mtd_flush(fs_desc->dev) != 0) {
+        DEBUG("fatfs_vfs.c: _umount: flushing the device failed\n");
+    }
+
     DEBUG("unmounting file system of volume '%s'\n", fs_desc->abs_path_str_buff);
     FRESULT res = f_unmount(fs_desc->abs_path_str_buff);
 
@@ -215,9 +282,464 @@ static int _rename(vfs_mount_t *mountp, const char *from_path,
 
 static fatfs_file_desc_t * _get_fatfs_file_desc(vfs_file_t *f)
 {
-    /* the private buffer is part of a union that also contains a
-     * void pointer, hence, it is naturally aligned */
-    return (fatfs_file_desc_t *)(uintptr_t)f->private_data.buffer;
+    /* allocated by the VFS from the file slab of the mount */
+    return (fatfs_file_desc_t *)f->private_data.ptr;
+}
+
+/**
+ * @brief Fills the next read-ahead buffer of the queued files
+ */
+static void _readahead_task(void *params)
+{
+    (void)params;
+
+    for (;;) {
+        fatfs_file_desc_t *fd;
+        xQueueReceive(_ra_queue, &fd, portMAX_DELAY);
+
+        fatfs_readahead_t *ra = fd->ra;
+        const uint8_t next = ra->cur ^ 1;
+
+        ra->result = f_read(&fd->file, ra->buf[next], fd->ra_window, &ra->len[next]);
+        xSemaphoreGive(ra->done);
+    }
+}
+
+static void _readahead_task_create(void)
+{
+    if (h_ra_task != NULL) {
+        return;
+    }
+
+    _ra_queue = xQueueCreateStatic(FATFS_READAHEAD_QUEUE_LENGTH,
+                                   sizeof(fatfs_file_desc_t *),
+                                   _ra_queue_storage,
+                                   &_ra_queue_struct);
+    assert(_ra_queue);
+
+    h_ra_task = xTaskCreateStatic(_readahead_task,
+                                  "FatFs RA",
+                                  FATFS_READAHEAD_TASK_STACKSIZE,
+                                  NULL,
+                                  FATFS_READAHEAD_TASK_PRIORITY,
+                                  _ra_task_stack,
+                                  &_ra_task_tcb);
+    assert(h_ra_task);
+}
+
+static int _ra_alloc(fatfs_file_desc_t *fd)
+{
+    /* the struct size is a multiple of the pointer size, the buffers
+       stay word aligned for the DMA */
+    fatfs_readahead_t *ra = pvPortMalloc(sizeof(*ra) + 2 * fd->ra_window);
+    if (ra == NULL) {
+        return -ENOMEM;
+    }
+
+    memset(ra, 0, sizeof(*ra));
+    ra->buf[0] = (uint8_t *)(ra + 1);
+    ra->buf[1] = ra->buf[0] + fd->ra_window;
+    ra->done = xSemaphoreCreateBinaryStatic(&ra->done_storage);
+    assert(ra->done);
+
+    fd->ra = ra;
+
+    return 0;
+}
+
+static void _ra_free(fatfs_file_desc_t *fd)
+{
+    if (fd->ra == NULL) {
+        return;
+    }
+
+    assert(!fd->ra->pending);
+
+    vSemaphoreDelete(fd->ra->done);
+    vPortFree(fd->ra);
+    fd->ra = NULL;
+}
+
+static inline bool _ra_active(const fatfs_file_desc_t *fd)
+{
+    const fatfs_readahead_t *ra = fd->ra;
+
+    return (ra != NULL) && (ra->pending || (ra->pos < ra->len[ra->cur]));
+}
+
+static void _ra_submit(fatfs_file_desc_t *fd)
+{
+    fatfs_readahead_t *ra = fd->ra;
+
+    if (ra->eof) {
+        return;
+    }
+
+    /* there is at most one fill per open file in the queue */
+    ra->pending = true;
+    if (xQueueSend(_ra_queue, &fd, 0) != pdTRUE) {
+        ra->pending = false;
+    }
+}
+
+static FRESULT _ra_wait(fatfs_file_desc_t *fd)
+{
+    fatfs_readahead_t *ra = fd->ra;
+
+    xSemaphoreTake(ra->done, portMAX_DELAY);
+    ra->pending = false;
+
+    if (ra->result != FR_OK) {
+        ra->len[ra->cur ^ 1] = 0;
+    }
+    else if (ra->len[ra->cur ^ 1] < fd->ra_window) {
+        ra->eof = true;
+    }
+
+    return ra->result;
+}
+
+/**
+ * @brief Discards the read-ahead data and moves the file pointer back to the
+ *        position of the next byte the reader has not consumed yet
+ *
+ * Has to be called before any access to the FIL object other than reading.
+ */
+static int _ra_drop(fatfs_file_desc_t *fd)
+{
+    fatfs_readahead_t *ra = fd->ra;
+
+    fd->ra_seq_reads = 0;
+
+    if (ra == NULL) {
+        return 0;
+    }
+
+    FSIZE_t unread = ra->len[ra->cur] - ra->pos;
+
+    if (ra->pending) {
+        _ra_wait(fd);
+        unread += ra->len[ra->cur ^ 1];
+    }
+
+    ra->len[0] = 0;
+    ra->len[1] = 0;
+    ra->pos = 0;
+    ra->eof = false;
+
+    if (unread == 0) {
+        return 0;
+    }
+
+    return fatfs_err_to_errno(f_lseek(&fd->file, f_tell(&fd->file) - unread));
+}
+
+static ssize_t _ra_read(fatfs_file_desc_t *fd, void *dest, size_t nbytes)
+{
+    fatfs_readahead_t *ra = fd->ra;
+    uint8_t *dst = dest;
+    size_t total = 0;
+    FRESULT res = FR_OK;
+
+    while (total < nbytes) {
+        const UINT avail = ra->len[ra->cur] - ra->pos;
+
+        if (avail) {
+            const size_t n = MIN((size_t)avail, nbytes - total);
+            memcpy(dst + total, ra->buf[ra->cur] + ra->pos, n);
+            ra->pos += n;
+            total += n;
+            continue;
+        }
+
+        if (ra->pending) {
+            /* continue with the buffer filled in the background and
+               start filling the consumed one */
+            res = _ra_wait(fd);
+            if (res != FR_OK) {
+                break;
+            }
+
+            ra->base += ra->len[ra->cur];
+            ra->cur ^= 1;
+            ra->pos = 0;
+            _ra_submit(fd);
+            continue;
+        }
+
+        if (ra->eof) {
+            return total;
+        }
+
+        /* nothing buffered, large requests are read directly */
+        if (nbytes - total >= fd->ra_window) {
+            UINT br;
+            /* the consumed buffer does not end at the file pointer anymore */
+            ra->len[ra->cur] = 0;
+            ra->pos = 0;
+            res = f_read(&fd->file, dst + total, nbytes - total, &br);
+            if (res != FR_OK) {
+                break;
+            }
+            return total + br;
+        }
+
+        ra->base = f_tell(&fd->file);
+        res = f_read(&fd->file, ra->buf[ra->cur], fd->ra_window, &ra->len[ra->cur]);
+        ra->pos = 0;
+        if (res != FR_OK) {
+            ra->len[ra->cur] = 0;
+            break;
+        }
+        if (ra->len[ra->cur] < fd->ra_window) {
+            ra->eof = true;
+        }
+        _ra_submit(fd);
+    }
+
+    if (total) {
+        return total;
+    }
+
+    return fatfs_err_to_errno(res);
+}
+
+static void _clmt_free(fatfs_file_desc_t *fd)
+{
+    fd->file.cltbl = NULL;
+    vPortFree(fd->clmt);
+    fd->clmt = NULL;
+}
+
+/**
+ * @brief Builds the cluster link map table of the file, so FatFs seeks
+ *        without following the FAT chain
+ */
+static void _clmt_build(fatfs_file_desc_t *fd)
+{
+    DWORD entries = FATFS_FASTSEEK_INITIAL_ENTRIES;
+
+    while (1) {
+        DWORD *clmt = pvPortMalloc(entries * sizeof(DWORD));
+        if (clmt == NULL) {
+            fd->clmt_disabled = true;
+            return;
+        }
+
+        clmt[0] = entries;
+        fd->file.cltbl = clmt;
+
+        FRESULT res = f_lseek(&fd->file, CREATE_LINKMAP);
+        if (res == FR_OK) {
+            fd->clmt = clmt;
+            return;
+        }
+
+        /* on FR_NOT_ENOUGH_CORE the first entry holds the required size */
+        const DWORD required = clmt[0];
+        fd->file.cltbl = NULL;
+        vPortFree(clmt);
+
+        if ((res != FR_NOT_ENOUGH_CORE) || (required <= entries) ||
+            (required > FATFS_FASTSEEK_MAX_ENTRIES)) {
+            fd->clmt_disabled = true;
+            return;
+        }
+
+        entries = required;
+    }
+}
+
+/**
+ * @brief Prepares the fast seek for a seek to @p pos
+ *
+ * The map is built for a seek into another cluster of a large file. FatFs
+ * clips the fast seek at the end of the file and cannot extend the file
+ * with the map, so it is dropped for good when the file grows.
+ */
+static void _clmt_seek(fatfs_file_desc_t *fd, FSIZE_t pos)
+{
+    const FSIZE_t size = f_size(&fd->file);
+
+    if (fd->clmt != NULL) {
+        if (pos > size) {
+            _clmt_free(fd);
+            fd->clmt_disabled = true;
+        }
+        return;
+    }
+
+    if (fd->clmt_disabled || (size < FATFS_FASTSEEK_MIN_SIZE) || (pos > size)) {
+        return;
+    }
+
+    const FSIZE_t cluster_size = (FSIZE_t)fd->file.obj.fs->csize * _sector_size(fd->file.obj.fs);
+
+    if ((pos / cluster_size) != (f_tell(&fd->file) / cluster_size)) {
+        _clmt_build(fd);
+    }
+}
+
+/**
+ * @brief Gets the first sector and the number of sectors from the file
+ *        pointer to the end of its fragment from the fast seek map
+ *
+ * @return number of sectors, 0 if the file has no map
+ */
+static UINT _direct_run(const fatfs_file_desc_t *fd, LBA_t *sector)
+{
+    const FIL *fp = &fd->file;
+    const FATFS *fs = fp->obj.fs;
+
+    if (fd->clmt == NULL) {
+        return 0;
+    }
+
+    const DWORD fsect = (DWORD)(f_tell(fp) / _sector_size(fs));
+    const DWORD csect = fsect & (fs->csize - 1);
+    DWORD cl = fsect / fs->csize;
+
+    /* the map holds (length, first cluster) pairs of the fragments */
+    for (const DWORD *tbl = fd->clmt + 1; tbl[0] != 0; tbl += 2) {
+        if (cl < tbl[0]) {
+            *sector = fs->database + (LBA_t)fs->csize * (tbl[1] + cl - 2) + csect;
+            return (tbl[0] - cl) * fs->csize - csect;
+        }
+        cl -= tbl[0];
+    }
+
+    return 0;
+}
+
+static inline bool _direct_aligned(const fatfs_file_desc_t *fd, const void *buf,
+                                   size_t nbytes)
+{
+    const UINT ss = _sector_size(fd->file.obj.fs);
+
+    return ((f_tell(&fd->file) % ss) == 0) && ((nbytes % ss) == 0) &&
+           (((uintptr_t)buf % sizeof(uint32_t)) == 0);
+}
+
+/**
+ * @brief Transfers the sectors of an O_DIRECT file inside its size between
+ *        the buffer and the disk, one disk access per fragment
+ *
+ * The rest (the file tail, a file without map or the bytes extending the
+ * file) is left to FatFs, which still transfers whole sectors directly.
+ *
+ * The sector buffer of the file may hold a sector of the transfer, possibly
+ * modified and not written yet. It is the latest copy of that sector: a read
+ * takes the sector from it, a write updates it.
+ */
+static ssize_t _direct_rw(vfs_file_t *filp, void *buf, size_t nbytes, bool write)
+{
+    fatfs_file_desc_t *fd = _get_fatfs_file_desc(filp);
+    fatfs_desc_t *fs_desc = (fatfs_desc_t *)filp->mp->private_data;
+    FIL *fp = &fd->file;
+    const UINT ss = _sector_size(fp->obj.fs);
+    uint8_t *data = buf;
+    size_t total = 0;
+    FRESULT res = FR_OK;
+
+    while (total < nbytes) {
+        const FSIZE_t pos = f_tell(fp);
+        const FSIZE_t left = (f_size(fp) > pos) ? f_size(fp) - pos : 0;
+        LBA_t sector = 0;
+        UINT count = (UINT)(MIN((FSIZE_t)(nbytes - total), left) / ss);
+
+        count = MIN(count, _direct_run(fd, &sector));
+        /* a multi-block transfer of the SD card driver is limited to 16 bits */
+        count = MIN(count, (UINT)UINT16_MAX);
+
+        if (count == 0) {
+            UINT n;
+            if (write) {
+                /* the map cannot follow the file beyond its size */
+                if (fd->clmt != NULL) {
+                    _clmt_free(fd);
+                    fd->clmt_disabled = true;
+                }
+                res = f_write(fp, data + total, nbytes - total, &n);
+            }
+            else {
+                res = f_read(fp, data + total, nbytes - total, &n);
+            }
+            if (res == FR_OK) {
+                total += n;
+            }
+            break;
+        }
+
+        /* the other FatFs calls on the volume hold the same lock */
+        if (!ff_mutex_take(fs_desc->vol_idx)) {
+            res = FR_TIMEOUT;
+            break;
+        }
+
+        /* the sector in the sector buffer of the file, if it is part of the transfer */
+        const bool buffered = (fp->sect - sector) < count;
+        const size_t buffered_offset = buffered ? (size_t)(fp->sect - sector) * ss : 0;
+        DRESULT dres;
+        if (write) {
+            dres = disk_write(fp->obj.fs->pdrv, data + total, sector, count);
+            if ((dres == RES_OK) && buffered) {
+                memcpy(fp->buf, data + total + buffered_offset, ss);
+            }
+            if (dres == RES_OK) {
+                /* a write of 0 bytes only marks the file modified, so the
+                   directory entry is updated by f_sync() and f_close() */
+                UINT n;
+                res = f_write(fp, data + total, 0, &n);
+            }
+        }
+        else {
+            dres = disk_read(fp->obj.fs->pdrv, data + total, sector, count);
+            if ((dres == RES_OK) && buffered) {
+                memcpy(data + total + buffered_offset, fp->buf, ss);
+            }
+        }
+        ff_mutex_give(fs_desc->vol_idx);
+
+        if (dres != RES_OK) {
+            res = FR_DISK_ERR;
+        }
+        if (res != FR_OK) {
+            break;
+        }
+
+        total += (size_t)count * ss;
+
+        /* only moves the pointer, the new position is sector aligned */
+        res = f_lseek(fp, pos + (FSIZE_t)count * ss);
+        if (res != FR_OK) {
+            break;
+        }
+    }
+
+    if ((total == 0) && (res != FR_OK)) {
+        return fatfs_err_to_errno(res);
+    }
+
+    return (ssize_t)total;
+}
+
+/**
+ * @brief   The position of the directory entry identifies an open file on the
+ *          volume, whatever long or short name and case it was opened with
+ */
+static uint64_t _fatfs_file_id(const FIL *fp)
+{
+#if FF_FS_EXFAT
+    if (fp->obj.fs->fs_type == FS_EXFAT) {
+        /* the entry set is located by its directory and the offset in it,
+           dir_sect does not point to it */
+        return ((uint64_t)fp->obj.c_scl << 32) | ((uint64_t)fp->obj.c_ofs / 32 + 1);
+    }
+#endif
+    /* 32 byte directory entries, the sector number alone may use all 32 bits */
+    uint32_t entry = (uint32_t)(fp->dir_ptr - fp->obj.fs->win) / 32;
+
+    return (uint64_t)fp->dir_sect * (_sector_size(fp->obj.fs) / 32) + entry + 1;
 }
 
 static int _open(vfs_file_t *filp, const char *name, int flags, mode_t mode)
@@ -230,7 +752,18 @@ static int _open(vfs_file_t *filp, const char *name, int flags, mode_t mode)
     DEBUG("fatfs_vfs.c: _open: private_data = %p, name = %s; flags = 0x%x\n",
           filp->mp->private_data, name, flags);
 
-    strncpy(fd->fname, fs_desc->abs_path_str_buff, VFS_NAME_MAX);
+    memcpy(fd->fname, fs_desc->abs_path_str_buff, sizeof(fd->fname));
+
+    fd->ra = NULL;
+    fd->ra_window = FATFS_READAHEAD_DEFAULT_WINDOW;
+    fd->ra_seq_reads = 0;
+    fd->clmt = NULL;
+    fd->clmt_disabled = false;
+    fd->direct = ((flags & O_DIRECT) == O_DIRECT);
+
+    if (fd->direct) {
+        fd->ra_window = 0;
+    }
 
     uint8_t fatfs_flags = 0;
 
@@ -274,6 +807,15 @@ static int _open(vfs_file_t *filp, const char *name, int flags, mode_t mode)
     DEBUG("fatfs_vfs.c _open: returning fatfserr=%d; errno=%d\n", open_resu,
           fatfs_err_to_errno(open_resu));
 
+    if (open_resu == FR_OK) {
+        filp->file_id = _fatfs_file_id(&fd->file);
+    }
+
+    /* O_DIRECT transfers follow the fragments of the file */
+    if ((open_resu == FR_OK) && fd->direct) {
+        _clmt_build(fd);
+    }
+
     return fatfs_err_to_errno(open_resu);
 }
 
@@ -283,8 +825,13 @@ static int _close(vfs_file_t *filp)
 
     DEBUG("fatfs_vfs.c: _close: private_data = %p\n", filp->mp->private_data);
 
+    _ra_drop(fd);
+    _ra_free(fd);
+
     FRESULT res = f_close(&fd->file);
 
+    _clmt_free(fd);
+
     if (res == FR_OK) {
         DEBUG("[OK]");
     }
@@ -299,6 +846,24 @@ static ssize_t _write(vfs_file_t *filp, const void *src, size_t nbytes)
 {
     fatfs_file_desc_t *fd = _get_fatfs_file_desc(filp);
 
+    int ra_res = _ra_drop(fd);
+    if (ra_res < 0) {
+        return ra_res;
+    }
+
+    if (fd->direct) {
+        if (!_direct_aligned(fd, src, nbytes)) {
+            return -EINVAL;
+        }
+        return _direct_rw(filp, (void *)src, nbytes, true);
+    }
+
+    if ((fd->clmt != NULL) &&
+        (f_tell(&fd->file) + nbytes > f_size(&fd->file))) {
+        _clmt_free(fd);
+        fd->clmt_disabled = true;
+    }
+
     UINT bw;
 
     FRESULT res = f_write(&fd->file, src, nbytes, &bw);
@@ -313,6 +878,12 @@ static ssize_t _write(vfs_file_t *filp, const void *src, size_t nbytes)
 static int _fsync(vfs_file_t *filp)
 {
     fatfs_file_desc_t *fd = _get_fatfs_file_desc(filp);
+    fatfs_desc_t *fs_desc = (fatfs_desc_t *)filp->mp->private_data;
+
+    int ra_res = _ra_drop(fd);
+    if (ra_res < 0) {
+        return ra_res;
+    }
 
     FRESULT res = f_sync(&fd->file);
 
@@ -320,6 +891,44 @@ static int _fsync(vfs_file_t *filp)
         return fatfs_err_to_errno(res);
     }
 
+    /* f_sync() only reaches the disk if the file was modified */
+    return mtd_flush(fs_desc->dev);
+}
+
+static int _fallocate(vfs_file_t *filp, off_t offset, off_t len)
+{
+    fatfs_file_desc_t *fd = _get_fatfs_file_desc(filp);
+    const FSIZE_t size = (FSIZE_t)offset + (FSIZE_t)len;
+
+    if (size <= f_size(&fd->file)) {
+        return 0;
+    }
+
+    /* f_expand only allocates the clusters of an empty file */
+    if (f_size(&fd->file) != 0) {
+        return -ENOTSUP;
+    }
+
+    int res = _ra_drop(fd);
+    if (res < 0) {
+        return res;
+    }
+
+    FRESULT fres = f_expand(&fd->file, size, 1);
+    if (fres == FR_DENIED) {
+        /* there is no contiguous free area of this size */
+        return -ENOSPC;
+    }
+    if (fres != FR_OK) {
+        return fatfs_err_to_errno(fres);
+    }
+
+    /* the chain is a single fragment, with its map the writes into the
+       file follow it without reading the FAT */
+    _clmt_free(fd);
+    fd->clmt_disabled = false;
+    _clmt_build(fd);
+
     return 0;
 }
 
@@ -327,6 +936,25 @@ static ssize_t _read(vfs_file_t *filp, void *dest, size_t nbytes)
 {
     fatfs_file_desc_t *fd = _get_fatfs_file_desc(filp);
 
+    if (fd->direct) {
+        if (!_direct_aligned(fd, dest, nbytes)) {
+            return -EINVAL;
+        }
+        return _direct_rw(filp, dest, nbytes, false);
+    }
+
+    if (_ra_active(fd)) {
+        return _ra_read(fd, dest, nbytes);
+    }
+
+    /* read ahead after a few sequential reads smaller than the window */
+    if ((fd->ra_window != 0) && (nbytes < fd->ra_window) &&
+        (++fd->ra_seq_reads > FATFS_READAHEAD_TRIGGER)) {
+        if ((fd->ra != NULL) || (_ra_alloc(fd) == 0)) {
+            return _ra_read(fd, dest, nbytes);
+        }
+    }
+
     UINT br;
 
     FRESULT res = f_read(&fd->file, dest, nbytes, &br);
@@ -338,11 +966,240 @@ static ssize_t _read(vfs_file_t *filp, void *dest, size_t nbytes)
     return (ssize_t)br;
 }
 
+static ssize_t _readv(vfs_file_t *filp, const struct iovec *iov, int iovcnt)
+{
+    fatfs_file_desc_t *fd = _get_fatfs_file_desc(filp);
+    fatfs_desc_t *fs_desc = (fatfs_desc_t *)filp->mp->private_data;
+
+    /* the vector is read in one go, the read-ahead task would need the
+       volume held below */
+    int ra_res = _ra_drop(fd);
+    if (ra_res < 0) {
+        return ra_res;
+    }
+
+    /* the volume lock is recursive, the FatFs calls below take it again */
+    if (!ff_mutex_take(fs_desc->vol_idx)) {
+        return fatfs_err_to_errno(FR_TIMEOUT);
+    }
+
+    ssize_t total = 0;
+    ssize_t res = 0;
+
+    for (int i = 0; i < iovcnt; i++) {
+        size_t len = iov[i].iov_len;
+
+        if (fd->direct) {
+            if (!_direct_aligned(fd, iov[i].iov_base, len)) {
+                res = -EINVAL;
+                break;
+            }
+            res = _direct_rw(filp, iov[i].iov_base, len, false);
+            if (res < 0) {
+                break;
+            }
+            total += res;
+        }
+        else {
+            UINT br;
+            FRESULT fres = f_read(&fd->file, iov[i].iov_base, len, &br);
+            if (fres != FR_OK) {
+                res = fatfs_err_to_errno(fres);
+                break;
+            }
+            total += br;
+            res = br;
+        }
+
+        if ((size_t)res < len) {
+            /* end of file */
+            break;
+        }
+    }
+
+    ff_mutex_give(fs_desc->vol_idx);
+
+    return ((res < 0) && (total == 0)) ? res : total;
+}
+
+/**
+ * @brief Writes the buffers of a vector to a buffered file, merging the
+ *        consecutive buffers smaller than a sector into whole sectors
+ *
+ * Without the merging FatFs reads each sector that a small buffer only
+ * partially overwrites into the buffer of the file before writing it back.
+ * The volume must be held by the caller, the buffers are merged in its
+ * gather buffer.
+ */
+static ssize_t _gather_write(fatfs_desc_t *fs_desc, fatfs_file_desc_t *fd,
+                             const struct iovec *iov, int iovcnt)
+{
+    uint8_t *gather = (iovcnt > 1) ? fs_desc->gather_buf : NULL;
+    const UINT ss = _sector_size(&fs_desc->fat_fs);
+    FSIZE_t pos = f_tell(&fd->file);
+    size_t gathered = 0;
+    ssize_t total = 0;
+    FRESULT res = FR_OK;
+    bool full = false;
+    UINT bw;
+
+    for (int i = 0; (i < iovcnt) && (res == FR_OK) && !full; i++) {
+        const uint8_t *src = iov[i].iov_base;
+        size_t len = iov[i].iov_len;
+
+        while ((len > 0) && (res == FR_OK) && !full) {
+            if ((gather == NULL) ||
+                ((gathered == 0) && ((pos % ss) == 0) && (len >= ss))) {
+                /* whole sectors are written from the buffer of the caller */
+                size_t n = (gather == NULL) ? len : len - (len % ss);
+                res = f_write(&fd->file, src, n, &bw);
+                total += bw;
+                pos += bw;
+                full = (bw < n);
+                src += n;
+                len -= n;
+                continue;
+            }
+
+            /* fill the rest of the current sector */
+            size_t room = ss - (size_t)((pos + gathered) % ss);
+            size_t n = (len < room) ? len : room;
+            memcpy(&gather[gathered], src, n);
+            gathered += n;
+            src += n;
+            len -= n;
+
+            if (((pos + gathered) % ss) == 0) {
+                res = f_write(&fd->file, gather, gathered, &bw);
+                total += bw;
+                pos += bw;
+                full = (bw < gathered);
+                gathered = 0;
+            }
+        }
+    }
+
+    if ((res == FR_OK) && !full && (gathered > 0)) {
+        res = f_write(&fd->file, gather, gathered, &bw);
+        total += bw;
+    }
+
+    if ((res != FR_OK) && (total == 0)) {
+        return fatfs_err_to_errno(res);
+    }
+    /* short if e.g. the disk is full */
+    return total;
+}
+
+static ssize_t _writev(vfs_file_t *filp, const struct iovec *iov, int iovcnt)
+{
+    fatfs_file_desc_t *fd = _get_fatfs_file_desc(filp);
+    fatfs_desc_t *fs_desc = (fatfs_desc_t *)filp->mp->private_data;
+
+    int ra_res = _ra_drop(fd);
+    if (ra_res < 0) {
+        return ra_res;
+    }
+
+    /* the volume lock is recursive, the FatFs calls below take it again */
+    if (!ff_mutex_take(fs_desc->vol_idx)) {
+        return fatfs_err_to_errno(FR_TIMEOUT);
+    }
+
+    ssize_t res = 0;
+
+    if (fd->direct) {
+        ssize_t total = 0;
+        for (int i = 0; i < iovcnt; i++) {
+            if (!_direct_aligned(fd, iov[i].iov_base, iov[i].iov_len)) {
+                res = -EINVAL;
+                break;
+            }
+            res = _direct_rw(filp, iov[i].iov_base, iov[i].iov_len, true);
+            if (res < 0) {
+                break;
+            }
+            total += res;
+            if ((size_t)res < iov[i].iov_len) {
+                break;
+            }
+        }
+        res = ((res < 0) && (total == 0)) ? res : total;
+    }
+    else {
+        size_t nbytes = 0;
+        for (int i = 0; i < iovcnt; i++) {
+            nbytes += iov[i].iov_len;
+        }
+        if ((fd->clmt != NULL) &&
+            (f_tell(&fd->file) + nbytes > f_size(&fd->file))) {
+            _clmt_free(fd);
+            fd->clmt_disabled = true;
+        }
+        res = _gather_write(fs_desc, fd, iov, iovcnt);
+    }
+
+    ff_mutex_give(fs_desc->vol_idx);
+
+    return res;
+}
+
+/**
+ * @brief Moves the read position within the current read-ahead buffer
+ *
+ * ftell() and seeks that stay within the buffer keep the read-ahead running.
+ * The FIL object is not accessed, a background fill may be pending.
+ *
+ * @return the new position, or -1 if it is outside of the buffer
+ */
+static off_t _ra_seek(fatfs_file_desc_t *fd, off_t off, int whence)
+{
+    fatfs_readahead_t *ra = fd->ra;
+
+    if ((ra == NULL) || (ra->len[ra->cur] == 0)) {
+        return -1;
+    }
+
+    off_t new_pos;
+
+    if (whence == SEEK_SET) {
+        new_pos = off;
+    }
+    else if (whence == SEEK_CUR) {
+        new_pos = (off_t)(ra->base + ra->pos) + off;
+    }
+    else if (whence == SEEK_END) {
+        new_pos = (off_t)f_size(&fd->file) + off;
+    }
+    else {
+        return -1;
+    }
+
+    if ((new_pos < (off_t)ra->base) || (new_pos > (off_t)(ra->base + ra->len[ra->cur]))) {
+        return -1;
+    }
+
+    ra->pos = (UINT)(new_pos - (off_t)ra->base);
+
+    return new_pos;
+}
+
 static off_t _lseek(vfs_file_t *filp, off_t off, int whence)
 {
     fatfs_file_desc_t *fd = _get_fatfs_file_desc(filp);
     FRESULT res;
-    off_t new_pos = 0;
+    off_t new_pos = _ra_seek(fd, off, whence);
+
+    if (new_pos >= 0) {
+        return new_pos;
+    }
+
+    new_pos = 0;
+
+    int ra_res = _ra_drop(fd);
+    if (ra_res < 0) {
+        return ra_res;
+    }
 
     if (whence == SEEK_SET) {
         new_pos = off;
@@ -357,6 +1214,8 @@ static off_t _lseek(vfs_file_t *filp, off_t off, int whence)
         return fatfs_err_to_errno(FR_INVALID_PARAMETER);
     }
 
+    _clmt_seek(fd, new_pos);
+
     res = f_lseek(&fd->file, new_pos);
 
     if (res == FR_OK) {
@@ -366,19 +1225,51 @@ static off_t _lseek(vfs_file_t *filp, off_t off, int whence)
     return fatfs_err_to_errno(res);
 }
 
+static int _fcntl(vfs_file_t *filp, int cmd, int arg)
+{
+    fatfs_file_desc_t *fd = _get_fatfs_file_desc(filp);
+
+    switch (cmd) {
+        case VFS_F_SETRA: {
+            if ((arg < 0) || ((uint32_t)arg > FATFS_READAHEAD_MAX_WINDOW)) {
+                return -EINVAL;
+            }
+
+            int res = _ra_drop(fd);
+            if (res < 0) {
+                return res;
+            }
+
+            _ra_free(fd);
+            fd->ra_window = (((uint32_t)arg + FF_MAX_SS - 1) / FF_MAX_SS) * FF_MAX_SS;
+            return 0;
+        }
+        case VFS_F_GETRA:
+            return (int)fd->ra_window;
+        default:
+            break;
+    }
+
+    return -EINVAL;
+}
+
 static int _fstat(vfs_file_t *filp, struct stat *buf)
 {
-    fatfs_desc_t *fs_desc = (fatfs_desc_t *)filp->mp->private_data;
+    fatfs_file_desc_t *fd = _get_fatfs_file_desc(filp);
     FILINFO fi;
     FRESULT res;
 
-    res = f_stat(fs_desc->abs_path_str_buff, &fi);
+    /* the path buffer of the mount holds the path of the last operation of
+       any task on the volume, look up the name the file was opened with */
+    res = f_stat(fd->fname, &fi);
 
     if (res != FR_OK) {
         return fatfs_err_to_errno(res);
     }
 
-    buf->st_size = fi.fsize;
+    /* the directory entry is only updated on sync, the open file knows the
+       current size */
+    buf->st_size = f_size(&fd->file);
 
     /* set last modification timestamp */
 #ifdef SYS_STAT_H
@@ -387,29 +1278,21 @@ static int _fstat(vfs_file_t *filp, struct stat *buf)
     _fatfs_time_to_timespec(fi.fdate, fi.ftime, &(buf->st_mtime));
 #endif
 
-    if (fi.fattrib & AM_DIR) {
-        buf->st_mode = S_IFDIR;  /**< it's a directory */
-    }
-    else {
-        buf->st_mode = S_IFREG;  /**< it's a regular file */
-    }
-
-    /** always grant read access */
-    buf->st_mode |= (S_IRUSR | S_IRGRP | S_IROTH);
-
-    if (fi.fattrib & AM_RDO) {
-        /** grant write access if file isn't RO*/
-        buf->st_mode ^= (S_IWUSR | S_IWGRP | S_IWOTH);
-    }
+    buf->st_mode = _fatfs_attrib_to_mode(fi.fattrib);
 
     return fatfs_err_to_errno(res);
 }
 
-static inline DIR * _get_DIR(vfs_DIR *d)
+static inline fatfs_dir_t * _get_fatfs_dir(vfs_DIR *d)
 {
     /* the private buffer is part of a union that also contains a
      * void pointer, hence, it is naturally aligned */
-    return (DIR *)(uintptr_t)d->private_data.buffer;
+    return (fatfs_dir_t *)(uintptr_t)d->private_data.buffer;
+}
+
+static inline DIR * _get_DIR(vfs_DIR *d)
+{
+    return &_get_fatfs_dir(d)->dir;
 }
 
 static int _opendir(vfs_DIR *dirp, const char *dirname)
@@ -417,6 +1300,7 @@ static int _opendir(vfs_DIR *dirp, const char *dirname)
     DIR *dir = _get_DIR(dirp);
     fatfs_desc_t *fs_desc = (fatfs_desc_t *)dirp->mp->private_data;
 
+    _get_fatfs_dir(dirp)->batch_err = FR_OK;
     _build_abs_path(fs_desc, dirname);
 
     return fatfs_err_to_errno(f_opendir(dir, fs_desc->abs_path_str_buff));
@@ -435,7 +1319,7 @@ static int _readdir(vfs_DIR *dirp, vfs_dirent_t *entry)
         }
         else {
             entry->d_ino = 0; //TODO: set this properly
-            strncpy(entry->d_name, fi.fname, VFS_NAME_MAX);
+            snprintf(entry->d_name, sizeof(entry->d_name), "%s", fi.fname);
             return 1;
         }
     }
@@ -443,6 +1327,54 @@ static int _readdir(vfs_DIR *dirp, vfs_dirent_t *entry)
     return fatfs_err_to_errno(res);
 }
 
+static ssize_t _readdir_batch(vfs_DIR *dirp, vfs_dirent_stat_t *entries, size_t n)
+{
+    fatfs_dir_t *fatfs_dir = _get_fatfs_dir(dirp);
+    DIR *dir = &fatfs_dir->dir;
+    fatfs_desc_t *fs_desc = (fatfs_desc_t *)dirp->mp->private_data;
+    FILINFO fi;
+    FRESULT res = FR_OK;
+    size_t count = 0;
+
+    /* the entries read before the error were returned by the previous batch */
+    if (fatfs_dir->batch_err != FR_OK) {
+        res = fatfs_dir->batch_err;
+        fatfs_dir->batch_err = FR_OK;
+        return fatfs_err_to_errno(res);
+    }
+
+    /* the volume lock is recursive, hold it for the whole batch */
+    if (!ff_mutex_take(fs_desc->vol_idx)) {
+        return fatfs_err_to_errno(FR_TIMEOUT);
+    }
+
+    while (count < n) {
+        res = f_readdir(dir, &fi);
+        if ((res != FR_OK) || (fi.fname[0] == 0)) {
+            break;
+        }
+
+        vfs_dirent_stat_t *entry = &entries[count++];
+        entry->d_ino = 0;
+        entry->d_mode = _fatfs_attrib_to_mode(fi.fattrib);
+        entry->d_size = fi.fsize;
+        entry->d_mtim.tv_nsec = 0;
+        _fatfs_time_to_timespec(fi.fdate, fi.ftime, &(entry->d_mtim.tv_sec));
+        snprintf(entry->d_name, sizeof(entry->d_name), "%s", fi.fname);
+    }
+
+    ff_mutex_give(fs_desc->vol_idx);
+
+    if (res != FR_OK) {
+        if (count == 0) {
+            return fatfs_err_to_errno(res);
+        }
+        fatfs_dir->batch_err = res;
+    }
+
+    return count;
+}
+
 static int _closedir(vfs_DIR *dirp)
 {
     DIR *dir = _get_DIR(dirp);
@@ -469,6 +1401,28 @@ static int _rmdir (vfs_mount_t *mountp, const char *name)
     return fatfs_err_to_errno(f_unlink(fs_desc->abs_path_str_buff));
 }
 
+static mode_t _fatfs_attrib_to_mode(BYTE fattrib)
+{
+    mode_t mode;
+
+    if (fattrib & AM_DIR) {
+        mode = S_IFDIR;  /**< it's a directory */
+    }
+    else {
+        mode = S_IFREG;  /**< it's a regular file */
+    }
+
+    /** always grant read access */
+    mode |= (S_IRUSR | S_IRGRP | S_IROTH);
+
+    if (!(fattrib & AM_RDO)) {
+        /** grant write access if file isn't RO */
+        mode |= (S_IWUSR | S_IWGRP | S_IWOTH);
+    }
+
+    return mode;
+}
+
 static void _fatfs_time_to_timespec(WORD fdate, WORD ftime, time_t *time)
 {
     struct tm t = {
@@ -555,14 +1509,19 @@ static const vfs_file_ops_t fatfs_file_ops = {
     .close = _close,
     .read = _read,
     .write = _write,
+    .readv = _readv,
+    .writev = _writev,
+    .fcntl = _fcntl,
     .lseek = _lseek,
     .fstat = _fstat,
     .fsync = _fsync,
+    .fallocate = _fallocate,
 };
 
 static const vfs_dir_ops_t fatfs_dir_ops = {
     .opendir = _opendir,
     .readdir = _readdir,
+    .readdir_batch = _readdir_batch,
     .closedir = _closedir,
 };
 
@@ -570,4 +1529,6 @@ const vfs_file_system_t fatfs_file_system = {
     .fs_op = &fatfs_fs_ops,
     .f_op = &fatfs_file_ops,
     .d_op = &fatfs_dir_ops,
+    .flags = VFS_FS_FLAG_DCACHE,
+    .file_data_size = sizeof(fatfs_file_desc_t),
 };
@@ -55,7 +55,8 @@ int ff_mutex_create (	/* Returns 1:Function succeeded or 0:Could not create the
 	int vol				/* Mutex ID: Volume mutex (0 to FF_VOLUMES - 1) or system mutex (FF_VOLUMES) */
 )
 {
-	Mutex[vol] = xSemaphoreCreateMutex();
+	/* recursive, so that the VFS driver can hold the volume across several file functions */
+	Mutex[vol] = xSemaphoreCreateRecursiveMutex();
 	return (int)(Mutex[vol] != NULL);
 }
 
@@ -86,7 +87,7 @@ int ff_mutex_take (	/* Returns 1:Succeeded or 0:Timeout */
 	int vol			/* Mutex ID: Volume mutex (0 to FF_VOLUMES - 1) or system mutex (FF_VOLUMES) */
 )
 {
-	return (int)(xSemaphoreTake(Mutex[vol], FF_FS_TIMEOUT) == pdTRUE);
+	return (int)(xSemaphoreTakeRecursive(Mutex[vol], FF_FS_TIMEOUT) == pdTRUE);
 }
 
 
@@ -101,7 +102,7 @@ void ff_mutex_give (
 	int vol			/* Mutex ID: Volume mutex (0 to FF_VOLUMES - 1) or system mutex (FF_VOLUMES) */
 )
 {
-	xSemaphoreGive(Mutex[vol]);
+	xSemaphoreGiveRecursive(Mutex[vol]);
 }
 
 #endif	/* FF_FS_REENTRANT */
@@ -23,8 +23,13 @@
  *           based on low level disk I/O module example for FatFs by ChaN, 2016
  */
 
+#include <errno.h>
+#include <string.h>
+
 #include "fatfs_diskio_mtd.h"
+#include "fatfs_vfs_config.h"
 #include "ffconf.h"
+#include "macros/utils.h"
 #include "mtd.h"
 #define ENABLE_DEBUG 0
 #include "debug.h"
@@ -36,6 +41,168 @@
 /* mtd devices for use by FatFs should be provided by the application */
 extern mtd_dev_t *fatfs_mtd_devs[FF_VOLUMES];
 
+#if (FF_USE_TRIM == 1)
+/**
+ * @brief   Sector range freed by FatFs that has not been erased yet
+ */
+typedef struct {
+    uint32_t start;     /**< first sector of the range */
+    uint32_t count;     /**< number of sectors, 0 if the slot is free */
+} trim_range_t;
+
+static trim_range_t _trim_ranges[FF_VOLUMES][FATFS_TRIM_RANGES_NUMOF];
+
+/**
+ * @brief           erases the pending trim ranges of a drive
+ *
+ * Only the mtd sectors completely inside a range are erased. The FAT updates
+ * that freed the ranges have to be on the medium already, otherwise a power
+ * loss could leave live cluster chains pointing to erased data.
+ */
+static int _trim_flush(BYTE pdrv)
+{
+    mtd_dev_t *mtd = fatfs_mtd_devs[pdrv];
+    int ret = 0;
+
+    for (unsigned i = 0; i < FATFS_TRIM_RANGES_NUMOF; i++) {
+        trim_range_t *range = &_trim_ranges[pdrv][i];
+        if (range->count == 0) {
+            continue;
+        }
+
+        const uint32_t first = (range->start + mtd->pages_per_sector - 1)
+                             / mtd->pages_per_sector;
+        const uint32_t end = (range->start + range->count) / mtd->pages_per_sector;
+
+        DEBUG("mtd_diskio: trim %lu + %lu\n", (long unsigned)range->start,
+              (long unsigned)range->count);
+
+        if (end > first) {
+            int res = mtd_erase_sector(mtd, first, end - first);
+            /* discarding is only a hint, the card may not support it */
+            if (res < 0 && res != -ENOTSUP && ret == 0) {
+                ret = res;
+            }
+        }
+
+        range->count = 0;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief           returns the slot of the smallest pending range
+ */
+static unsigned _trim_smallest(const trim_range_t *ranges)
+{
+    unsigned smallest = 0;
+
+    for (unsigned i = 1; i < FATFS_TRIM_RANGES_NUMOF; i++) {
+        if (ranges[i].count < ranges[smallest].count) {
+            smallest = i;
+        }
+    }
+
+    return smallest;
+}
+
+/**
+ * @brief           queues a sector range for erasing, merging it with the
+ *                  adjacent or overlapping pending ranges
+ *
+ * Discarding is only a hint: when no slot is left, the smallest range is
+ * forgotten instead of erasing the ranges before the FAT is synced.
+ */
+static void _trim_add(BYTE pdrv, uint32_t start, uint32_t count)
+{
+    trim_range_t *ranges = _trim_ranges[pdrv];
+    uint32_t end = start + count;
+    unsigned i = 0;
+
+    while (i < FATFS_TRIM_RANGES_NUMOF) {
+        trim_range_t *range = &ranges[i];
+        if (range->count != 0 &&
+            range->start <= end && start <= range->start + range->count) {
+            /* merge and rescan, the result may touch another range */
+            end = MAX(end, range->start + range->count);
+            start = MIN(start, range->start);
+            range->count = 0;
+            i = 0;
+            continue;
+        }
+        i++;
+    }
+
+    for (i = 0; i < FATFS_TRIM_RANGES_NUMOF; i++) {
+        if (ranges[i].count == 0) {
+            break;
+        }
+    }
+
+    if (i == FATFS_TRIM_RANGES_NUMOF) {
+        i = _trim_smallest(ranges);
+        if (ranges[i].count >= end - start) {
+            return;
+        }
+    }
+
+    ranges[i].start = start;
+    ranges[i].count = end - start;
+}
+
+/**
+ * @brief           removes [start, start + count) from the pending ranges,
+ *                  the sectors are reused and must not be erased anymore
+ *
+ * A range split in two keeps both parts if there is a free slot, the smaller
+ * part is forgotten otherwise.
+ */
+static void _trim_clip(BYTE pdrv, uint32_t start, uint32_t count)
+{
+    trim_range_t *ranges = _trim_ranges[pdrv];
+    const uint32_t end = start + count;
+
+    for (unsigned i = 0; i < FATFS_TRIM_RANGES_NUMOF; i++) {
+        trim_range_t *range = &ranges[i];
+        const uint32_t range_end = range->start + range->count;
+
+        if (range->count == 0 || range_end <= start || end <= range->start) {
+            continue;
+        }
+
+        const uint32_t head = (start > range->start) ? start - range->start : 0;
+        const uint32_t tail = (range_end > end) ? range_end - end : 0;
+
+        if (head != 0 && tail != 0) {
+            unsigned j;
+            for (j = 0; j < FATFS_TRIM_RANGES_NUMOF; j++) {
+                if (ranges[j].count == 0) {
+                    break;
+                }
+            }
+            if (j < FATFS_TRIM_RANGES_NUMOF) {
+                ranges[j].start = end;
+                ranges[j].count = tail;
+            }
+            else if (tail > head) {
+                range->start = end;
+                range->count = tail;
+                continue;
+            }
+            range->count = head;
+        }
+        else if (head != 0) {
+            range->count = head;
+        }
+        else {
+            range->start = end;
+            range->count = tail;
+        }
+    }
+}
+#endif
+
 /**
  * @brief           returns the status of the disk
  *
@@ -79,6 +246,11 @@ DSTATUS disk_initialize(BYTE pdrv)
         return STA_NOINIT;
     }
 
+#if (FF_USE_TRIM == 1)
+    /* the ranges of a previously used medium must not be erased */
+    memset(_trim_ranges[pdrv], 0, sizeof(_trim_ranges[pdrv]));
+#endif
+
     uint32_t sector_size = fatfs_mtd_devs[pdrv]->page_size
                          * fatfs_mtd_devs[pdrv]->pages_per_sector;
     if (sector_size > FF_MAX_SS) {
@@ -140,6 +312,10 @@ DRESULT disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
         return RES_PARERR;
     }
 
+#if (FF_USE_TRIM == 1)
+    _trim_clip(pdrv, sector, count);
+#endif
+
     int res = mtd_write_sector(mtd, buff, sector, count);
     if (res != 0) {
         return RES_ERROR;
@@ -160,8 +336,6 @@ DRESULT disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count)
  */
 DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
 {
-    (void)buff;
-
     if ((pdrv >= FF_VOLUMES) || (fatfs_mtd_devs[pdrv]->driver == NULL)) {
         return RES_PARERR;
     }
@@ -169,7 +343,16 @@ DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
     switch (cmd) {
 #if (FF_FS_READONLY == 0)
         case CTRL_SYNC:
-            /* r/w is always finished within r/w-functions of mtd */
+            /* write back what a caching mtd layer still holds */
+            if (mtd_flush(fatfs_mtd_devs[pdrv]) != 0) {
+                return RES_ERROR;
+            }
+#if (FF_USE_TRIM == 1)
+            /* the FAT updates freeing the ranges are on the medium now */
+            if (_trim_flush(pdrv) != 0) {
+                return RES_ERROR;
+            }
+#endif
             return RES_OK;
 #endif
 
@@ -192,8 +375,20 @@ DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff)
 #endif
 
 #if (FF_USE_TRIM == 1)
-        case CTRL_TRIM:
+        /* buff holds the first and the last sector of the freed range */
+        case CTRL_TRIM: {
+            const LBA_t *range = buff;
+            if (range[1] < range[0]) {
+                return RES_PARERR;
+            }
+            mtd_dev_t *mtd = fatfs_mtd_devs[pdrv];
+            const uint32_t count = range[1] - range[0] + 1;
+            const uint64_t size = (uint64_t)count * mtd->page_size * mtd->pages_per_sector;
+            const uint32_t start = mtd_stats_start();
+            _trim_add(pdrv, range[0], count);
+            mtd_stats_record(mtd, MTD_STATS_TRIM, MIN(size, UINT32_MAX), start, 0);
             return RES_OK;
+        }
 #endif
     }
 
@@ -38,8 +38,14 @@
 #include "stdio_uart_config.h"
 #include "usbh_conf.h"
 
+#include <assert.h>
+
 static EXTI_HandleTypeDef h_exti_sdcard_cd_pin;
 static EXTI_HandleTypeDef h_exti_usb_host_overcurrent_pin;
+static EXTI_HandleTypeDef h_exti_sdcard_d0_pin;
+
+static_assert(SDCARD_D0_PIN_EXTIx_IRQn == USB_HOST_OVERCURRENT_PIN_EXTIx_IRQn,
+              "the SD Card D0 line is served by the USB Host over-current EXTI handler");
 
 void led1_pin_init(void)
 {
@@ -381,6 +387,69 @@ int sdcard_cd_pin_deinit(void)
     return 0;
 }
 
+int sdcard_d0_pin_exti_init(void (*exti_callback_fn)(void))
+{
+    assert(exti_callback_fn);
+
+    /* the pin stays in SDIO alternate function mode, only the EXTI line is
+       connected to it. The line is masked until the busy-end is awaited */
+    EXTI_ConfigTypeDef exti_config = {
+        .Line = SDCARD_D0_PIN_EXTI_LINE,
+        .Mode = EXTI_MODE_INTERRUPT,
+        .Trigger = EXTI_TRIGGER_RISING,
+        .GPIOSel = SDCARD_D0_PIN_EXTI_GPIO
+    };
+
+    HAL_StatusTypeDef ret;
+    ret = HAL_EXTI_SetConfigLine(&h_exti_sdcard_d0_pin, &exti_config);
+    if (HAL_OK != ret)
+    {
+        return hal_statustypedef_to_errno(ret);
+    }
+
+    sdcard_d0_pin_exti_disable();
+
+    ret = HAL_EXTI_RegisterCallback(&h_exti_sdcard_d0_pin, HAL_EXTI_COMMON_CB_ID, exti_callback_fn);
+    if (HAL_OK != ret)
+    {
+        return hal_statustypedef_to_errno(ret);
+    }
+
+    HAL_NVIC_SetPriority(SDCARD_D0_PIN_EXTIx_IRQn, SDCARD_D0_PIN_EXTIx_IRQ_PRIORITY, 0ul);
+    HAL_NVIC_EnableIRQ(SDCARD_D0_PIN_EXTIx_IRQn);
+
+    return 0;
+}
+
+int sdcard_d0_pin_exti_deinit(void)
+{
+    /* EXTI9_5_IRQn is shared with the USB Host over-current pin, only the line is released */
+    HAL_StatusTypeDef ret = HAL_EXTI_ClearConfigLine(&h_exti_sdcard_d0_pin);
+    if (HAL_OK != ret)
+    {
+        return hal_statustypedef_to_errno(ret);
+    }
+
+    return 0;
+}
+
+void sdcard_d0_pin_exti_enable(void)
+{
+    __HAL_GPIO_EXTI_CLEAR_IT(SDCARD_D0_PIN);
+    SET_BIT(EXTI->IMR, SDCARD_D0_PIN);
+}
+
+void sdcard_d0_pin_exti_disable(void)
+{
+    CLEAR_BIT(EXTI->IMR, SDCARD_D0_PIN);
+    __HAL_GPIO_EXTI_CLEAR_IT(SDCARD_D0_PIN);
+}
+
+int sdcard_d0_pin_read(void)
+{
+    return (GPIO_PIN_SET == HAL_GPIO_ReadPin(SDCARD_D0_PIN_GPIO_PORT, SDCARD_D0_PIN)) ? 1 : 0;
+}
+
 void usb_host_vbus_pin_init(void)
 {
     GPIO_InitTypeDef vbus_pin = {
@@ -542,11 +611,16 @@ void usb_host_powerswitch_disable(void)
 }
 
 /**
- * @brief USB Over-Current EXTI Interrupt Handler
+ * @brief USB Over-Current and SD Card D0 busy-end EXTI Interrupt Handler
  */
 void USB_HOST_OVERCURRENT_PIN_EXTIx_IRQHandler(void)
 {
     HAL_EXTI_IRQHandler(&h_exti_usb_host_overcurrent_pin);
+
+    if (0 != h_exti_sdcard_d0_pin.Line)
+    {
+        HAL_EXTI_IRQHandler(&h_exti_sdcard_d0_pin);
+    }
 }
 
 /**
@@ -56,6 +56,7 @@ extern void cli_command_set_date(EmbeddedCli *cli, char *args, void *context);
 extern void cli_command_set_time(EmbeddedCli *cli, char *args, void *context);
 extern void cli_command_version(EmbeddedCli *cli, char *args, void *context);
 extern void cli_command_memstat(EmbeddedCli *cli, char *args, void *context);
+extern void cli_command_iostat(EmbeddedCli *cli, char *args, void *context);
 extern void cli_command_ls(EmbeddedCli *cli, char *args, void *context);
 extern void cli_command_cd(EmbeddedCli *cli, char *args, void *context);
 extern void cli_command_cp(EmbeddedCli *cli, char *args, void *context);
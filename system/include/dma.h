@@ -37,10 +37,10 @@ extern "C" {
 #include "stm32f4xx_hal.h"
 
 /**
- * @brief  Initializes DMA for the STDIO UART transmission.
+ * @brief  Initializes DMA for the STDIO UART transmission and reception.
  *
  * This function configures the DMA controller to transfer data from memory to the UART peripheral
- * for transmission.
+ * for transmission and from the UART peripheral to memory in circular mode for reception.
  *
  * @param  huart Pointer to a UART_HandleTypeDef structure that contains
  *               the configuration information for the specified UART module.
@@ -50,7 +50,7 @@ extern "C" {
 HAL_StatusTypeDef stdio_uart_dma_init(UART_HandleTypeDef *huart);
 
 /**
- * @brief  De-initializes DMA for the STDIO UART transmission.
+ * @brief  De-initializes DMA for the STDIO UART transmission and reception.
  *
  * @param  huart Pointer to a UART_HandleTypeDef structure that contains
  *               the configuration information for the specified UART module.
@@ -88,15 +88,30 @@ typedef struct fatfs_desc {
     /** most FatFs file operations need an absolute path. This buffer provides
         static memory to circumvent stack allocation within vfs-wrappers */
     char abs_path_str_buff[FATFS_MAX_ABS_PATH_SIZE];
+
+    /** the small buffers of a vectored write are merged into whole sectors
+        here, it is only used while the volume is held */
+    BYTE gather_buf[FF_MAX_SS] __attribute__((aligned(4)));
 } fatfs_desc_t;
 
+/**
+ * @brief Read-ahead state of a file, allocated on the first sequential read
+ */
+typedef struct fatfs_readahead fatfs_readahead_t;
+
 /**
  * @brief FatFs file instance descriptor
  */
 typedef struct fatfs_file_desc {
     FIL file;                     /**< FatFs work area for a single file */
-    char fname[VFS_NAME_MAX + 1]; /**< name of the file (e.g. f_stat uses
-                                       filename instead of FIL) */
+    char fname[FATFS_MAX_ABS_PATH_SIZE]; /**< name of the file (e.g. f_stat
+                                              uses filename instead of FIL) */
+    fatfs_readahead_t *ra;        /**< read-ahead state, NULL until used */
+    uint32_t ra_window;           /**< read-ahead window in bytes, 0 disables it */
+    uint32_t ra_seq_reads;        /**< number of reads since the last seek */
+    DWORD *clmt;                  /**< cluster link map table, NULL until built */
+    bool clmt_disabled;           /**< the map is not built (again) for this file */
+    bool direct;                  /**< opened with O_DIRECT */
 } fatfs_file_desc_t;
 
 /** The FatFs vfs driver, a pointer to a fatfs_desc_t must be
@@ -88,6 +88,11 @@ void sdcard_d1_pin_deinit(void);
 void sdcard_d0_pin_deinit(void);
 int  sdcard_cd_pin_init(void (*exti_callback_fn)(void));
 int  sdcard_cd_pin_deinit(void);
+int  sdcard_d0_pin_exti_init(void (*exti_callback_fn)(void));
+int  sdcard_d0_pin_exti_deinit(void);
+void sdcard_d0_pin_exti_enable(void);
+void sdcard_d0_pin_exti_disable(void);
+int  sdcard_d0_pin_read(void);
 /** @} */
 
 /** @defgroup USB_Host_GPIO_Functions USB Host GPIO Management Functions
@@ -72,6 +72,12 @@
  * This MTD API currently does not specify which value will be read from an
  * erased sector.
  *
+ * Every device keeps I/O statistics of the operations issued through
+ * @ref mtd_read_page, @ref mtd_write_page_raw, @ref mtd_erase_sector and
+ * @ref mtd_flush: the number of operations, errors and bytes, the distribution
+ * of the request sizes and a log2 latency histogram. A stacked device (e.g. a
+ * cache) and the device below it are accounted separately.
+ *
  * @file        mtd.h
  *
  */
@@ -83,6 +89,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "mtd_config.h"
 #include "xfa.h"
 
 #ifdef __cplusplus
@@ -109,6 +116,37 @@ enum mtd_power_state {
  */
 typedef struct mtd_desc mtd_desc_t;
 
+/**
+ * @brief   Operations accounted in the MTD I/O statistics
+ */
+typedef enum {
+    MTD_STATS_READ,     /**< @ref mtd_read_page */
+    MTD_STATS_WRITE,    /**< @ref mtd_write_page_raw */
+    MTD_STATS_ERASE,    /**< @ref mtd_erase_sector */
+    MTD_STATS_FLUSH,    /**< @ref mtd_flush */
+    MTD_STATS_TRIM,     /**< ranges freed by the file system */
+    MTD_STATS_OP_NUMOF, /**< number of accounted operations */
+} mtd_stats_op_t;
+
+/**
+ * @brief   I/O statistics of one operation type
+ */
+typedef struct {
+    uint32_t ops;                                       /**< number of operations */
+    uint32_t errors;                                    /**< operations that failed */
+    uint64_t bytes;                                     /**< bytes read, written or erased */
+    uint32_t latency_max;                               /**< slowest operation in microseconds */
+    uint32_t size_hist[MTD_STATS_SIZE_BUCKETS];         /**< operations by log2 of their size */
+    uint32_t latency_hist[MTD_STATS_LATENCY_BUCKETS];   /**< operations by log2 of their latency */
+} mtd_op_stats_t;
+
+/**
+ * @brief   I/O statistics of a MTD device
+ */
+typedef struct {
+    mtd_op_stats_t op[MTD_STATS_OP_NUMOF];  /**< statistics by @ref mtd_stats_op_t */
+} mtd_stats_t;
+
 /**
  * @brief   MTD device descriptor
  *
@@ -124,6 +162,7 @@ typedef struct {
 #if defined(MODULE_MTD_WRITE_PAGE) || DOXYGEN
     void *work_area;           /**< sector-sized buffer (only present when @ref mtd_write_page is enabled) */
 #endif
+    mtd_stats_t stats;         /**< I/O statistics */
 } mtd_dev_t;
 
 /**
@@ -320,6 +359,19 @@ struct mtd_desc {
      */
     int (*power)(mtd_dev_t *dev, enum mtd_power_state power);
 
+    /**
+     * @brief   Write back data buffered by the Memory Technology Device (MTD)
+     *
+     * Optional, drivers that complete every write within write_page leave
+     * this NULL.
+     *
+     * @param[in] dev       Pointer to the selected driver
+     *
+     * @retval 0 on success
+     * @retval <0 value on error
+     */
+    int (*flush)(mtd_dev_t *dev);
+
     /**
      * @brief   Properties of the MTD driver
      */
@@ -530,6 +582,80 @@ int mtd_write_sector(mtd_dev_t *mtd, const void *src, uint32_t sector, uint32_t
  */
 int mtd_power(mtd_dev_t *mtd, enum mtd_power_state power);
 
+/**
+ * @brief   Write back all data buffered by a MTD device
+ *
+ * @param      mtd      the device to flush
+ *
+ * @retval 0 on success or if the driver does not buffer writes
+ * @retval -ENODEV if no device if given or no driver is set
+ * @retval <0 value on error
+ */
+int mtd_flush(mtd_dev_t *mtd);
+
+/**
+ * @brief   Get a timestamp for @ref mtd_stats_record
+ *
+ * @return  current value of the FreeRTOS run time statistics counter
+ */
+uint32_t mtd_stats_start(void);
+
+/**
+ * @brief   Account an operation in the I/O statistics of a MTD device
+ *
+ * Used by the layers above the MTD API to account the operations it does not
+ * see, e.g. the ranges trimmed by the file system.
+ *
+ * @param      mtd      the device the operation was issued to
+ * @param[in]  op       type of the operation
+ * @param[in]  size     size of the operation in bytes
+ * @param[in]  start    timestamp taken with @ref mtd_stats_start before the
+ *                      operation was started
+ * @param[in]  res      result of the operation, <0 if it failed
+ */
+void mtd_stats_record(mtd_dev_t *mtd, mtd_stats_op_t op, uint32_t size,
+                      uint32_t start, int res);
+
+/**
+ * @brief   Get a consistent copy of the I/O statistics of a MTD device
+ *
+ * @param      mtd      the device
+ * @param[out] stats    the statistics
+ */
+void mtd_stats_get(const mtd_dev_t *mtd, mtd_stats_t *stats);
+
+/**
+ * @brief   Clear the I/O statistics of a MTD device
+ *
+ * @param      mtd      the device
+ */
+void mtd_stats_reset(mtd_dev_t *mtd);
+
+/**
+ * @brief   Estimate a latency percentile from the latency histogram
+ *
+ * The result is the upper limit of the histogram bucket holding the
+ * percentile, limited to the slowest operation.
+ *
+ * @param[in]  stats    statistics of an operation type
+ * @param[in]  percent  the percentile, 1 to 100
+ *
+ * @return  the latency in microseconds, 0 if no operation was accounted
+ */
+uint32_t mtd_stats_latency_percentile(const mtd_op_stats_t *stats, unsigned percent);
+
+/**
+ * @brief   Get an initialized MTD device for listing its statistics
+ *
+ * Devices are listed in the order they were first initialized with
+ * @ref mtd_init, at most @ref MTD_STATS_DEVS_NUMOF of them.
+ *
+ * @param[in] idx   Index of the device
+ *
+ * @return  the device, NULL if there is no device for the given index
+ */
+mtd_dev_t *mtd_stats_dev_get(unsigned idx);
+
 /**
  * @brief   Get an MTD device by index
  *
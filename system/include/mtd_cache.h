@@ -0,0 +1,170 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     system_mtd_cache
+ * @brief       Set-associative write-back block cache for MTD devices
+ *
+ * The cache is a MTD device itself that wraps another (parent) MTD device.
+ * A cache line holds one sector of the parent device. Lines are grouped into
+ * sets selected by the sector number, within a set the least recently used
+ * line is replaced. Writes only modify the cached line, the dirty lines are
+ * written back on replacement and on mtd_flush(). A dirty line is written
+ * back together with the dirty lines caching the neighbouring sectors, up to
+ * @ref MTD_CACHE_WRITE_COMBINE_SECTORS sectors with one multi-block write.
+ *
+ * Transfers of at least @ref MTD_CACHE_BYPASS_THRESHOLD sectors bypass the
+ * cache, overlapping dirty lines are written back (read) or dropped (write)
+ * first to keep the cache coherent.
+ *
+ * mtd_init() always starts with an empty cache, the parent device may hold a
+ * different medium since the previous initialization. Flush the cache before
+ * initializing it again.
+ *
+ * @{
+ *
+ * @file        mtd_cache.h
+ * @brief       Interface definition for the mtd_cache driver
+ *
+ */
+#ifndef __MTD_CACHE_H__
+#define __MTD_CACHE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mtd.h"
+#include "mtd_cache_config.h"
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief   Cache line metadata
+ */
+typedef struct {
+    uint32_t sector;    /**< cached sector of the parent device */
+    uint32_t last_use;  /**< value of the access counter on the last access */
+    bool valid;         /**< line holds a sector */
+    bool dirty;         /**< line was modified and not written back yet */
+} mtd_cache_line_t;
+
+/**
+ * @brief   Cache statistics
+ */
+typedef struct {
+    uint32_t hits;          /**< sector accesses served from the cache */
+    uint32_t misses;        /**< sector accesses that had to fill a line */
+    uint32_t write_backs;   /**< dirty lines written to the parent device */
+    uint32_t write_runs;    /**< writes to the parent device the dirty lines
+                                 were combined into */
+    uint32_t bypasses;      /**< transfers passed through to the parent device */
+} mtd_cache_stats_t;
+
+/**
+ * @brief   Device descriptor for mtd_cache device
+ *
+ * This is an extension of the @c mtd_dev_t struct. @c parent, @c sets and
+ * @c ways have to be set before the device is initialized, the rest is
+ * managed by the driver.
+ */
+typedef struct {
+    mtd_dev_t base;                 /**< inherit from mtd_dev_t object */
+    mtd_dev_t *parent;              /**< cached MTD device */
+    uint16_t sets;                  /**< number of sets, power of two */
+    uint16_t ways;                  /**< number of lines per set */
+    mtd_cache_line_t *lines;        /**< line metadata, sets * ways entries */
+    uint8_t *data;                  /**< line data, sets * ways sectors */
+    uint8_t *staging;               /**< buffer to combine the written back lines */
+    uint32_t access_counter;        /**< LRU clock */
+    mtd_cache_stats_t stats;        /**< hit / miss counters */
+    SemaphoreHandle_t lock;         /**< serializes the cache accesses */
+    StaticSemaphore_t lock_storage; /**< storage of the lock */
+} mtd_cache_t;
+
+/**
+ * @brief   Static initializer for a cache with the default geometry
+ *
+ * @param   parent_dev  Pointer to the cached MTD device
+ */
+#define MTD_CACHE_INIT(parent_dev)                  \
+    {                                               \
+        .base = { .driver = &mtd_cache_driver },    \
+        .parent = (parent_dev),                     \
+        .sets = MTD_CACHE_NUMOF_SETS,               \
+        .ways = MTD_CACHE_NUMOF_WAYS,               \
+    }
+
+/**
+ * @brief   mtd_cache device operations table for mtd
+ */
+extern const mtd_desc_t mtd_cache_driver;
+
+/**
+ * @brief   Writes back the dirty lines and releases the cache memory
+ *
+ * The cache can be initialized again with mtd_init() afterwards. The dirty
+ * lines are dropped even if they could not be written back, i.e. when the
+ * parent device has been removed.
+ *
+ * @param[in] cache  Pointer to the cache device
+ *
+ * @retval 0 on success
+ * @retval <0 if the dirty lines could not be written back
+ */
+int mtd_cache_deinit(mtd_cache_t *cache);
+
+/**
+ * @brief   Drops every cached line without writing the dirty ones back
+ *
+ * Used when the medium of the parent device has been removed or replaced,
+ * the dirty lines belong to the previous one.
+ *
+ * @param[in] cache  Pointer to the cache device
+ */
+void mtd_cache_discard(mtd_cache_t *cache);
+
+/**
+ * @brief   Returns a snapshot of the cache statistics
+ *
+ * @param[in]  cache  Pointer to the cache device
+ * @param[out] stats  Statistics
+ */
+void mtd_cache_get_stats(mtd_cache_t *cache, mtd_cache_stats_t *stats);
+
+/**
+ * @brief   Clears the cache statistics
+ *
+ * @param[in] cache  Pointer to the cache device
+ */
+void mtd_cache_reset_stats(mtd_cache_t *cache);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __MTD_CACHE_H__ */
+/** @} */
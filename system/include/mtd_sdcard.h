@@ -52,11 +52,11 @@ typedef struct {
  * @brief   Enable SDCard Erase
  * @note    SDCards handle sector erase internally so it's
  *          possible to directly write to the card without erasing
- *          the sector first.
- *          Attention: an erase call will therefore NOT touch the content,
- *          so enable this feature to ensure overriding the data.
- *
- *          This feature requires the `mtd_write_page` module.
+ *          the sector first, the driver sets @ref MTD_DRIVER_FLAG_DIRECT_WRITE.
+ *          With this feature an erase call discards the blocks using the
+ *          erase commands of the card (CMD32 / CMD33 / CMD38), the content
+ *          of the erased blocks is 0x00 or 0xFF depending on the card.
+ *          Without it an erase call does NOT touch the content.
  */
 #ifdef DOXYGEN
 #define CONFIG_MTD_SDCARD_ERASE
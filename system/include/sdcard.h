@@ -34,13 +34,56 @@ extern "C" {
 
 #include <stdint.h>
 
+#include "FreeRTOS.h"
+#include "task.h"
+
 #define SDCARD_SDHC_BLOCK_SIZE   (512ul)
 
+/**
+ * @brief   Type of an asynchronous SD Card request
+ */
+typedef enum {
+    SDCARD_REQUEST_READ,                /**< read blocks into data */
+    SDCARD_REQUEST_WRITE,               /**< write blocks from data */
+    SDCARD_REQUEST_ERASE,               /**< erase blocks, data is not used */
+} sdcard_request_type_t;
+
+/**
+ * @brief   Forward declaration for the SD Card request
+ */
+typedef struct sdcard_request sdcard_request_t;
+
+/**
+ * @brief   Completion callback of an SD Card request
+ *
+ * Called from the context of the SD Card I/O task, it must not block and must
+ * not call the synchronous sdcard_*_blocks() functions.
+ */
+typedef void (*sdcard_request_cb_t)(sdcard_request_t *req);
+
+/**
+ * @brief   Asynchronous SD Card request
+ *
+ * The request is owned by the driver from sdcard_submit() until it is
+ * completed, it must stay valid and must not be modified in this time.
+ */
+struct sdcard_request {
+    sdcard_request_type_t type;         /**< type of the request */
+    uint32_t block_addr;                /**< start address given as block address */
+    uint16_t block_num;                 /**< number of blocks */
+    void *data;                         /**< data buffer, NULL for erase */
+    sdcard_request_cb_t callback;       /**< completion callback, may be NULL */
+    TaskHandle_t notify_task;           /**< task to notify on completion, may be NULL */
+    void *arg;                          /**< user argument, not used by the driver */
+    volatile int result;                /**< -EINPROGRESS while pending, the
+                                             result of the transfer afterwards */
+};
+
 /**
  * @brief Initialize the SDIO peripheral and the SD card
  *
- * Initializes the GPIO, DMA and the SDIO and creates binary semaphores
- * for the transmission and reception
+ * Initializes the GPIO, DMA and the SDIO, creates binary semaphores
+ * for the transmission and reception and starts the SD Card I/O task
  *
  * @return 0 on success
  * @return < 0 on error
@@ -50,14 +93,35 @@ int sdcard_init(void);
 /**
  * @brief De-initialize the SDIO peripheral
  *
- * De-initializes the GPIO, DMA and the SDIO and deletes the binary
- * semaphores
+ * Stops the SD Card I/O task, de-initializes the GPIO, DMA and the SDIO
+ * and deletes the binary semaphores. The request in progress completes,
+ * the queued requests complete with -ENODEV and new requests are refused.
  *
  * @return 0 on success
  * @return < 0 on error
  */
 int sdcard_deinit(void);
 
+/**
+ * @brief   Submit an asynchronous request
+ *
+ * Queues @p req for the SD Card I/O task and returns immediately. The requests
+ * are served in submission order. On completion @p req->result is set, then
+ * @p req->callback is called (if set) and @p req->notify_task is notified on
+ * the notification index @ref SDCARD_TASK_NOTIFICATION_INDEX (if set).
+ *
+ * Blocks while the request queue is full.
+ *
+ * @pre @p req must not be NULL, @p req->block_num has to be greater than 0.
+ *
+ * @param[in]   req         Request to submit
+ *
+ * @return  0           on success, the request is queued
+ * @return  -ENODEV     if the driver is not initialized or is being de-initialized
+ * @return  -EAGAIN     if the request could not be queued
+ */
+int sdcard_submit(sdcard_request_t *req);
+
 /**
  * @brief   Read a number of blocks
  *
@@ -66,6 +130,14 @@ int sdcard_deinit(void);
  *
  * @pre @p data must not be NULL. @p block_num has to be greater than 0.
  *
+ * The request is served by the SD Card I/O task, the calling task is blocked
+ * until it is completed. Must not be called from the I/O task (i.e. from a
+ * request callback).
+ *
+ * @note Word-aligned buffers are used by the DMA directly. Other buffers are
+ *       read through the internal bounce buffer in multi-block chunks of
+ *       @ref SDCARD_BOUNCE_BUFFER_SIZE bytes.
+ *
  * @param[in]   block_addr  Start address to read from given as block address
  * @param[in]   block_num   Number of blocks
  * @param[out]  data        Buffer for read data
@@ -90,6 +162,14 @@ int sdcard_read_blocks(uint32_t block_addr, uint16_t block_num, void *data);
  *
  * @pre @p data must not be NULL. @p block_num has to be greater than 0.
  *
+ * The request is served by the SD Card I/O task, the calling task is blocked
+ * until it is completed. Must not be called from the I/O task (i.e. from a
+ * request callback).
+ *
+ * @note Word-aligned buffers are used by the DMA directly. Other buffers are
+ *       written through the internal bounce buffer in multi-block chunks of
+ *       @ref SDCARD_BOUNCE_BUFFER_SIZE bytes.
+ *
  * @param[in]   block_addr  Start address to write to given as block address
  * @param[in]   block_num   Number of blocks
  * @param[in]   data        Buffer with data to write
@@ -110,7 +190,8 @@ int sdcard_write_blocks(uint32_t block_addr, uint16_t block_num, const void *dat
  * @brief   Erase a number of blocks
  *
  * Erase @p block_num blocks starting at block address @p block_addr on the
- * SD Card.
+ * SD Card. The calling task is blocked until the SD Card I/O task has
+ * completed the request.
  *
  * @pre @p block_num has to be greater than 0.
  *
@@ -29,17 +29,26 @@
 #ifndef STDIO_BASE_H
 #define STDIO_BASE_H
 
+#include <stdint.h>
 #include <unistd.h>
 
 #include "modules.h"
 
-#include "FreeRTOS.h"
-#include "queue.h"
-
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Receive statistics of the stdio backend
+ */
+typedef struct
+{
+    uint32_t rx_bytes;      /**< Number of received bytes */
+    uint32_t rx_dropped;    /**< Number of bytes overwritten in the receive buffer before they were processed */
+    uint32_t rx_overruns;   /**< Number of overrun errors reported by the receiver */
+    uint32_t rx_errors;     /**< Number of framing, noise and parity errors */
+} stdio_stats_t;
+
 /**
  * @brief Initialize the module
  */
@@ -51,19 +60,16 @@ void stdio_init(void);
 void stdio_deinit(void);
 
 /**
- * @brief Adds the given queue handle to the listeners list
- *
- * @param[in] hqueue handle to be added to the listeners list
+ * @brief Gets a snapshot of the receive statistics
  *
- * @return 0 on success
- * @return < 0 on error
- *
- * @note The CLI adds its input queue handle to the listeners list to
- *       receive the characters when the stdin is not used by other tasks
- *       If a task uses a function which relies on stdin then the received bytes
- *       are passed to the stdin queue bypassing the CLI input queue
+ * @param[out] stats Pointer to the structure to fill
  */
-int stdio_add_stdin_listener(const QueueHandle_t hqueue);
+void stdio_stats_get(stdio_stats_t *stats);
+
+/**
+ * @brief Clears the receive statistics
+ */
+void stdio_stats_reset(void);
 
 #if IS_USED(MODULE_STDIO_AVAILABLE) || DOXYGEN
 /**
@@ -78,7 +84,12 @@ int stdio_available(void);
 #endif
 
 /**
- * @brief read @p len bytes from stdio uart into @p buffer
+ * @brief read up to @p max_len bytes from stdio uart into @p buffer
+ *
+ * Waits for the received bytes as set by stdio_rx_set_timing(), by default
+ * until the first byte arrives, then returns every byte received so far.
+ * The bytes received while a task is blocked in this function are passed to
+ * that task only, the stdin listeners (see stdio_rx.h) skip them.
  *
  * @param[out]  buffer  buffer to read into
  * @param[in]   max_len nr of bytes to read
@@ -0,0 +1,194 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     system_stdio
+ *
+ * @brief       Receive ring shared by the stdin listeners
+ *
+ * The stdio backend appends the received bytes to a single ring. Every
+ * listener reads the ring through its own cursor, so a slow listener only
+ * falls behind instead of stalling the backend and the other listeners.
+ * When a listener is a full ring behind, its overflow policy decides
+ * whether its oldest unread bytes are dropped or the backend waits until
+ * it catches up. A listener is woken with one task notification per burst
+ * of received bytes and reads them with @ref stdio_rx_listener_read.
+ *
+ * While a task is blocked in stdio_read() or the stdin is in non-blocking
+ * mode the received bytes are passed to the stdin readers only, the
+ * listeners skip them.
+ *
+ * @{
+ *
+ * @file        stdio_rx.h
+ * @brief       STDIO receive ring API
+ *
+ */
+#ifndef __STDIO_RX_H__
+#define __STDIO_RX_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Behavior when a listener falls a full ring behind
+ */
+typedef enum
+{
+    STDIO_RX_DROP_OLDEST,   /**< the oldest unread bytes of the listener are dropped */
+    STDIO_RX_BLOCK,         /**< the backend waits until the listener reads */
+} stdio_rx_overflow_t;
+
+/**
+ * @brief stdin listener
+ *
+ * The structure is owned by the caller and must stay valid while the
+ * listener is added. @p task, @p notify_index and @p overflow are set by
+ * @ref stdio_rx_listener_add, @p dropped may be read by the owner, the
+ * other fields are private.
+ */
+typedef struct stdio_rx_listener
+{
+    TaskHandle_t task;                  /**< task notified when bytes are received */
+    UBaseType_t notify_index;           /**< index of the task notification */
+    stdio_rx_overflow_t overflow;       /**< overflow policy */
+    uint32_t dropped;                   /**< number of bytes dropped for this listener */
+    struct stdio_rx_listener *next;     /**< next listener */
+    uint32_t cursor;                    /**< ring position of the next byte to read */
+    uint32_t skip_start;                /**< first byte of the stdio_read() range to skip */
+    uint32_t skip_end;                  /**< end of the range, valid if closed */
+    bool skip;                          /**< there is a range to skip */
+    bool skip_open;                     /**< stdio_read() is still receiving into the range */
+} stdio_rx_listener_t;
+
+/**
+ * @brief Initializes the receive ring, called by the stdio backend
+ */
+void stdio_rx_init(void);
+
+/**
+ * @brief De-initializes the receive ring, called by the stdio backend
+ */
+void stdio_rx_deinit(void);
+
+/**
+ * @brief Appends received bytes to the ring and notifies the listeners,
+ *        called by the stdio backend
+ *
+ * @param[in] data pointer to the received bytes
+ * @param[in] len  number of bytes
+ *
+ * @note  Blocks while a listener with the @ref STDIO_RX_BLOCK policy is a
+ *        full ring behind
+ */
+void stdio_rx_write(const uint8_t *data, size_t len);
+
+/**
+ * @brief Adds a listener, it receives the bytes arriving from now on
+ *
+ * @param[in] listener     listener to add
+ * @param[in] task         task to notify when bytes are received
+ * @param[in] notify_index index of the task notification
+ * @param[in] overflow     overflow policy
+ *
+ * @return 0 on success
+ * @return -EALREADY if the listener has already been added
+ */
+int stdio_rx_listener_add(stdio_rx_listener_t *listener, TaskHandle_t task,
+                          UBaseType_t notify_index, stdio_rx_overflow_t overflow);
+
+/**
+ * @brief Removes a listener, its unread bytes are discarded
+ *
+ * @param[in] listener listener to remove
+ */
+void stdio_rx_listener_remove(stdio_rx_listener_t *listener);
+
+/**
+ * @brief Copies the unread bytes of a listener without blocking
+ *
+ * @param[in]  listener listener to read for
+ * @param[out] buffer   buffer to copy to
+ * @param[in]  max_len  size of the buffer
+ *
+ * @return number of bytes copied, 0 if there is nothing to read
+ */
+size_t stdio_rx_listener_read(stdio_rx_listener_t *listener, void *buffer, size_t max_len);
+
+/**
+ * @brief Reads the received bytes of the stdin
+ *
+ * Works as stdio_read() when @p nonblock is false. Otherwise the bytes
+ * already received are returned without waiting.
+ *
+ * @param[out] buffer   buffer to read into
+ * @param[in]  max_len  size of the buffer
+ * @param[in]  nonblock do not wait for bytes
+ *
+ * @return number of bytes read
+ * @return -EAGAIN if @p nonblock is set and there is nothing to read
+ */
+ssize_t stdio_rx_read(void *buffer, size_t max_len, bool nonblock);
+
+/**
+ * @brief Switches the stdin between blocking and non-blocking mode
+ *
+ * In non-blocking mode the received bytes are kept for the stdin readers
+ * between the reads, the listeners skip them until the stdin is switched
+ * back to blocking mode.
+ *
+ * @param[in] nonblock true to switch to non-blocking mode
+ */
+void stdio_rx_set_nonblock(bool nonblock);
+
+/**
+ * @brief Sets the timing of stdio_read(), see @ref STDIO_RX_VMIN and
+ *        @ref STDIO_RX_VTIME
+ *
+ * @param[in] vmin  minimum number of bytes to wait for
+ * @param[in] vtime timeout in tenths of a second, 0 for none
+ */
+void stdio_rx_set_timing(uint8_t vmin, uint8_t vtime);
+
+/**
+ * @brief Gets the timing of stdio_read()
+ *
+ * @param[out] vmin  minimum number of bytes to wait for
+ * @param[out] vtime timeout in tenths of a second
+ */
+void stdio_rx_get_timing(uint8_t *vmin, uint8_t *vtime);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __STDIO_RX_H__ */
+/** @} */
@@ -58,6 +58,7 @@
 #ifndef VFS_H
 #define VFS_H
 
+#include <fcntl.h> /* for O_DIRECT */
 #include <stdint.h>
 /* The stdatomic.h in GCC gives compilation errors with C++
  * see: https://gcc.gnu.org/bugzilla/show_bug.cgi?id=60932
@@ -70,6 +71,7 @@
 #include <sys/stat.h> /* for struct stat */
 #include <sys/types.h> /* for off_t etc. */
 #include <sys/statvfs.h> /* for struct statvfs */
+#include <sys/uio.h> /* for struct iovec */
 
 #include "clist.h"
 #include "iolist.h"
@@ -109,27 +111,9 @@ extern "C" {
 #ifdef MODULE_FATFS_VFS
 #include "ffconf.h"
 
-#  if FF_FS_TINY
-#    define _FATFS_FILE_CACHE              (0)
-#  else
-#    define _FATFS_FILE_CACHE              FF_MAX_SS
-#  endif
-
-#  if FF_USE_FASTSEEK
-#    if (__SIZEOF_POINTER__ == 8)
-#      define _FATFS_FILE_SEEK_PTR         (8)
-#    else
-#      define _FATFS_FILE_SEEK_PTR         (4)
-#    endif
-#  else
-#    define _FATFS_FILE_SEEK_PTR           (0)
-#  endif
-
 #  if FF_FS_EXFAT
-#    define _FATFS_FILE_EXFAT              (44)
 #    define _FATFS_DIR_EXFAT               (32)
 #  else
-#    define _FATFS_FILE_EXFAT              (0)
 #    define _FATFS_DIR_EXFAT               (0)
 #  endif
 
@@ -143,18 +127,14 @@ extern "C" {
 #    define _FATFS_DIR_LFN                 (0)
 #  endif
 
+/* the driver keeps the error of a partial batch read after the DIR */
 #  if (__SIZEOF_POINTER__ == 8)
-#    define FATFS_VFS_DIR_BUFFER_SIZE      (64 + _FATFS_DIR_LFN + _FATFS_DIR_EXFAT)
-#    define FATFS_VFS_FILE_BUFFER_SIZE     (57 + VFS_NAME_MAX + _FATFS_FILE_CACHE + \
-                                           _FATFS_FILE_SEEK_PTR + _FATFS_FILE_EXFAT)
+#    define FATFS_VFS_DIR_BUFFER_SIZE      (64 + _FATFS_DIR_LFN + _FATFS_DIR_EXFAT + 8)
 #  else
-#    define FATFS_VFS_DIR_BUFFER_SIZE      (44 + _FATFS_DIR_LFN + _FATFS_DIR_EXFAT)
-#    define FATFS_VFS_FILE_BUFFER_SIZE     (41 + VFS_NAME_MAX + _FATFS_FILE_CACHE + \
-                                           _FATFS_FILE_SEEK_PTR + _FATFS_FILE_EXFAT)
+#    define FATFS_VFS_DIR_BUFFER_SIZE      (44 + _FATFS_DIR_LFN + _FATFS_DIR_EXFAT + 4)
 #  endif
 #else
 #  define FATFS_VFS_DIR_BUFFER_SIZE        (1)
-#  define FATFS_VFS_FILE_BUFFER_SIZE       (1)
 #endif
 /** @} */
 
@@ -165,14 +145,11 @@ extern "C" {
 #ifdef MODULE_LITTLEFS
 #  if (__SIZEOF_POINTER__ == 8)
 #    define LITTLEFS_VFS_DIR_BUFFER_SIZE   (48)
-#    define LITTLEFS_VFS_FILE_BUFFER_SIZE  (72)
 #  else
 #    define LITTLEFS_VFS_DIR_BUFFER_SIZE   (44)
-#    define LITTLEFS_VFS_FILE_BUFFER_SIZE  (56)
 #  endif
 #else
 #  define LITTLEFS_VFS_DIR_BUFFER_SIZE     (1)
-#  define LITTLEFS_VFS_FILE_BUFFER_SIZE    (1)
 #endif
 /** @} */
 
@@ -183,14 +160,11 @@ extern "C" {
 #ifdef MODULE_LITTLEFS2
 #  if (__SIZEOF_POINTER__ == 8)
 #    define LITTLEFS2_VFS_DIR_BUFFER_SIZE  (56)
-#    define LITTLEFS2_VFS_FILE_BUFFER_SIZE (104)
 #  else
 #    define LITTLEFS2_VFS_DIR_BUFFER_SIZE  (52)
-#    define LITTLEFS2_VFS_FILE_BUFFER_SIZE (84)
 #  endif
 #else
 #  define LITTLEFS2_VFS_DIR_BUFFER_SIZE    (1)
-#  define LITTLEFS2_VFS_FILE_BUFFER_SIZE   (1)
 #endif
 /** @} */
 
@@ -200,10 +174,8 @@ extern "C" {
  */
 #ifdef MODULE_SPIFFS
 #  define SPIFFS_VFS_DIR_BUFFER_SIZE       (12)
-#  define SPIFFS_VFS_FILE_BUFFER_SIZE      (1)
 #else
 #  define SPIFFS_VFS_DIR_BUFFER_SIZE       (1)
-#  define SPIFFS_VFS_FILE_BUFFER_SIZE      (1)
 #endif
 /** @} */
 
@@ -213,20 +185,119 @@ extern "C" {
  */
 #if defined(MODULE_LWEXT4) || DOXYGEN
 #  define LWEXT4_VFS_DIR_BUFFER_SIZE       (308)   /**< sizeof(ext4_dir)  */
-#  define LWEXT4_VFS_FILE_BUFFER_SIZE      (32)    /**< sizeof(ext4_file) */
 #else
 #  define LWEXT4_VFS_DIR_BUFFER_SIZE       (1)
-#  define LWEXT4_VFS_FILE_BUFFER_SIZE      (1)
 #endif
 /** @} */
 
 #ifndef VFS_MAX_OPEN_FILES
 /**
  * @brief Maximum number of simultaneous open files
+ *
+ * The table of open files grows up to this size in chunks of
+ * @ref VFS_FD_TABLE_CHUNK entries as files are opened, an unused chunk only
+ * costs a pointer.
  */
 #define VFS_MAX_OPEN_FILES (16)
 #endif
 
+#ifndef VFS_FD_TABLE_CHUNK
+/**
+ * @brief Number of entries the table of open files grows by
+ *
+ * The first chunk is allocated statically, it holds the stdio file
+ * descriptors. Chunks are allocated from the FreeRTOS heap when all the
+ * allocated entries are in use, and they are never freed.
+ */
+#define VFS_FD_TABLE_CHUNK (8)
+#endif
+
+#ifndef VFS_MAX_MOUNTS
+/**
+ * @brief Maximum number of simultaneously mounted file systems
+ *
+ * Path lookups search a snapshot of the mounted file systems without locking,
+ * two snapshots of this many mounts are allocated statically.
+ */
+#define VFS_MAX_MOUNTS (4)
+#endif
+
+#ifndef VFS_MOUNT_MAX_OPEN_FILES
+/**
+ * @brief Default number of files that can be open simultaneously on a mount
+ *
+ * The private data of the open files of a file system is allocated from the
+ * file slab of its mount, which grows up to this many objects unless
+ * vfs_mount_t::max_open_files is set.
+ *
+ * @note FatFs limits the number of open files and directories of all its
+ * volumes with FF_FS_LOCK too.
+ */
+#define VFS_MOUNT_MAX_OPEN_FILES VFS_MAX_OPEN_FILES
+#endif
+
+#ifndef VFS_FILE_SLAB_CHUNK
+/**
+ * @brief Number of objects a file slab grows by
+ *
+ * The chunks are allocated from the FreeRTOS heap when all the allocated
+ * objects are in use, and they are freed when the slab is released.
+ */
+#define VFS_FILE_SLAB_CHUNK (4)
+#endif
+
+#ifndef VFS_DCACHE_SETS
+/**
+ * @brief Number of sets of the dentry cache
+ *
+ * vfs_stat caches the results of the file systems that set
+ * @ref VFS_FS_FLAG_DCACHE. The set of an entry is selected by the hash of its
+ * mount and path, each set holds @ref VFS_DCACHE_WAYS entries.
+ */
+#define VFS_DCACHE_SETS (8)
+#endif
+
+#ifndef VFS_DCACHE_WAYS
+/**
+ * @brief Number of entries in a set of the dentry cache, the least recently
+ *        used one is replaced
+ */
+#define VFS_DCACHE_WAYS (4)
+#endif
+
+#ifndef VFS_DCACHE_PATH_MAX
+/**
+ * @brief Maximum length of a path in the dentry cache (not including the
+ *        terminating null), the status of longer paths is not cached
+ */
+#define VFS_DCACHE_PATH_MAX (48)
+#endif
+
+#ifndef VFS_FCACHE_ENTRIES
+/**
+ * @brief Number of files that can be pinned in the file cache
+ */
+#define VFS_FCACHE_ENTRIES (4)
+#endif
+
+#ifndef VFS_FCACHE_BUDGET
+/**
+ * @brief Maximum number of bytes of file contents held by the file cache
+ *
+ * The contents of the least recently opened pinned files are dropped to make
+ * room, they are read again on their next open.
+ */
+#define VFS_FCACHE_BUDGET (4096)
+#endif
+
+#ifndef VFS_FCACHE_PATH_MAX
+/**
+ * @brief Maximum length of the path of a pinned file (not including the
+ *        terminating null)
+ */
+#define VFS_FCACHE_PATH_MAX (48)
+#endif
+
 #ifndef VFS_DIR_BUFFER_SIZE
 /**
  * @brief Size of buffer space in vfs_DIR
@@ -263,33 +334,6 @@ extern "C" {
                                 )
 #endif
 
-#ifndef VFS_FILE_BUFFER_SIZE
-/**
- * @brief Size of buffer space in vfs_file_t
- *
- * Same as with VFS_DIR_BUFFER_SIZE some file systems (e.g. FatFs) require more space
- * to store data about their files.
- *
- *
- * Guidelines are same as with VFS_DIR_BUFFER_SIZE, so add the following snippet
- * to your fs header:
- *
- * @attention @code
- * #if VFS_FILE_BUFFER_SIZE < 123
- * #error VFS_FILE_BUFFER_SIZE is too small, at least 123 bytes is required
- * #endif
- * @endcode
- *
- * @attention Put the check in the public header file (.h), do not put the check in the
- * implementation (.c) file.
- */
-#define VFS_FILE_BUFFER_SIZE MAX5(FATFS_VFS_FILE_BUFFER_SIZE,    \
-                                  LITTLEFS_VFS_FILE_BUFFER_SIZE, \
-                                  LITTLEFS2_VFS_FILE_BUFFER_SIZE,\
-                                  SPIFFS_VFS_FILE_BUFFER_SIZE,   \
-                                  LWEXT4_VFS_FILE_BUFFER_SIZE    \
-                                 )
-#endif
 
 #ifndef VFS_NAME_MAX
 /**
@@ -307,6 +351,42 @@ extern "C" {
  */
 #define VFS_ANY_FD (-1)
 
+/**
+ * @brief   File system specific vfs_fcntl() commands
+ *
+ * The values are chosen above the range of the standard fcntl commands.
+ * @{
+ */
+/**
+ * @brief Set the read-ahead window of a file in bytes (posix_fadvise() like
+ *        hint), 0 disables read-ahead (POSIX_FADV_RANDOM)
+ */
+#define VFS_F_SETRA (0x1000)
+/**
+ * @brief Get the read-ahead window of a file in bytes
+ */
+#define VFS_F_GETRA (0x1001)
+/** @} */
+
+/**
+ * @brief   vfs_open() flag for unbuffered file I/O
+ *
+ * The data of reads and writes moves directly between the buffer of the
+ * caller and the storage device, bypassing the sector buffer of the file and
+ * the read-ahead. File systems that support it require the file offset and
+ * the length of every transfer to be multiples of the sector size and the
+ * buffer to be word aligned, and fail the transfer with -EINVAL otherwise.
+ * The FatFs driver transfers each contiguous part of the file with a single
+ * multi-block command of the SD Card (one per cluster on the buffered path).
+ */
+#ifndef O_DIRECT
+#  if defined(_FDIRECT)     /* newlib without __BSD_VISIBLE */
+#    define O_DIRECT    _FDIRECT
+#  elif defined(__O_DIRECT) /* glibc without _GNU_SOURCE */
+#    define O_DIRECT    __O_DIRECT
+#  endif
+#endif
+
 /**
  * @brief Helper macro for VFS_AUTO_MOUNT
  *
@@ -369,6 +449,15 @@ extern const vfs_file_ops_t mtd_vfs_ops;
  */
 #define VFS_FS_FLAG_WANT_ABS_PATH   (1 << 0)
 
+/**
+ * @brief   The results of @c fs_op::stat can be cached by the VFS
+ *
+ * The file system only fills st_mode, st_size and st_mtim, and the files
+ * are only modified through the VFS. The files of such a file system can be
+ * pinned in the file cache too.
+ */
+#define VFS_FS_FLAG_DCACHE          (1 << 1)
+
 /**
  * @brief A file system driver
  */
@@ -377,8 +466,25 @@ typedef struct {
     const vfs_dir_ops_t *d_op;          /**< Directory operations table */
     const vfs_file_system_ops_t *fs_op; /**< File system operations table */
     const uint32_t flags;               /**< File system flags */
+    const size_t file_data_size;        /**< Size of the private data of an open file,
+                                             0 if the driver manages it on its own */
 } vfs_file_system_t;
 
+/**
+ * @brief A pool of fixed size objects
+ *
+ * Holds the private data of the open files of a mount, see
+ * @ref vfs_file_system_t::file_data_size.
+ */
+typedef struct {
+    void *chunks;                /**< Allocated chunks of objects, linked through their first word */
+    void *free_list;             /**< First free object, the free objects are linked */
+    size_t obj_size;             /**< Size of an object, 0 if the slab is not initialized */
+    unsigned numof;              /**< Maximum number of objects */
+    unsigned capacity;           /**< Number of objects in the allocated chunks */
+    unsigned used;               /**< Number of objects in use */
+} vfs_slab_t;
+
 /**
  * @brief A mounted file system
  */
@@ -388,6 +494,10 @@ struct vfs_mount_struct {
     const char *mount_point;     /**< Mount point, e.g. "/mnt/cdrom" */
     size_t mount_point_len;      /**< Length of mount_point string (set by vfs_mount) */
     atomic_int open_files;       /**< Number of currently open files and directories */
+    unsigned max_open_files;     /**< Number of files that can be open at the same time,
+                                      0 for @ref VFS_MOUNT_MAX_OPEN_FILES */
+    vfs_slab_t file_slab;        /**< Private data of the open files (set by vfs_mount) */
+    atomic_uint dcache_gen;      /**< Generation of the dentry cache entries of the mount */
     void *private_data;          /**< File system driver private data, implementation defined */
 };
 
@@ -402,10 +512,12 @@ typedef struct {
     int flags;                  /**< File flags */
     off_t pos;                  /**< Current position in the file */
     uint32_t task_id;           /**< ID of the task that opened the file */
+    uint64_t file_id;           /**< Identifies the file on its mount whatever path it was
+                                     opened with, set by the driver on open, 0 if unknown */
     union {
-        void *ptr;              /**< pointer to private data */
+        void *ptr;              /**< pointer to private data, allocated from the file slab
+                                     of the mount if the file system sets file_data_size */
         int value;              /**< alternatively, you can use private_data as an int */
-        uint8_t buffer[VFS_FILE_BUFFER_SIZE]; /**< Buffer space, in case a single pointer is not enough */
     } private_data;             /**< File system driver private data, implementation defined */
 } vfs_file_t;
 
@@ -440,6 +552,21 @@ typedef struct {
     char  d_name[VFS_NAME_MAX + 1]; /**< file name, relative to its containing directory */
 } vfs_dirent_t;
 
+/**
+ * @brief Directory entry with the file status attached
+ *
+ * Used to hold the output from readdir_batch. File systems that keep the
+ * attributes in the directory itself report them here, which saves a
+ * @c vfs_stat per entry.
+ */
+typedef struct {
+    ino_t           d_ino;      /**< file serial number, unique for the file system */
+    mode_t          d_mode;     /**< file type and permissions, 0 if unknown */
+    off_t           d_size;     /**< file size in bytes */
+    struct timespec d_mtim;     /**< time of last modification */
+    char            d_name[VFS_NAME_MAX + 1]; /**< file name, relative to its containing directory */
+} vfs_dirent_stat_t;
+
 /**
  * @brief Operations on open files
  *
@@ -516,8 +643,10 @@ struct vfs_file_ops {
      *
      * The VFS layer will initialize the contents of @p *filp so that
      * @c filp->f_op points to the mounted file system's @c vfs_file_ops_t.
-     * @c filp->private_data.ptr will be initialized to NULL, @c filp->pos will
-     * be set to 0.
+     * @c filp->private_data.ptr will point to a zeroed object of
+     * @c file_data_size bytes from the file slab of the mount if the file
+     * system sets @ref vfs_file_system_t::file_data_size, otherwise it will be
+     * initialized to NULL. @c filp->pos will be set to 0.
      *
      * @note @p name is an absolute path inside the file system, @p abs_path is
      * the path to the file in the VFS, example:
@@ -560,6 +689,34 @@ struct vfs_file_ops {
      */
     ssize_t (*write) (vfs_file_t *filp, const void *src, size_t nbytes);
 
+    /**
+     * @brief Read bytes from an open file into several buffers
+     *
+     * Optional, the VFS calls @c read for each buffer if it is NULL.
+     *
+     * @param[in]  filp     pointer to open file
+     * @param[in]  iov      buffers to fill in order
+     * @param[in]  iovcnt   number of buffers
+     *
+     * @return number of bytes read on success
+     * @return <0 on error
+     */
+    ssize_t (*readv) (vfs_file_t *filp, const struct iovec *iov, int iovcnt);
+
+    /**
+     * @brief Write bytes from several buffers to an open file
+     *
+     * Optional, the VFS calls @c write for each buffer if it is NULL.
+     *
+     * @param[in]  filp     pointer to open file
+     * @param[in]  iov      buffers to write in order
+     * @param[in]  iovcnt   number of buffers
+     *
+     * @return number of bytes written on success
+     * @return <0 on error
+     */
+    ssize_t (*writev) (vfs_file_t *filp, const struct iovec *iov, int iovcnt);
+
     /**
      * @brief Synchronize a file on storage
      *        Any pending writes are written out to storage.
@@ -570,6 +727,21 @@ struct vfs_file_ops {
      * @return <0 on error
      */
     int (*fsync) (vfs_file_t *filp);
+
+    /**
+     * @brief Allocate storage for a file
+     *
+     * Ensures that the storage for the bytes in the range [@p offset,
+     * @p offset + @p len) is allocated, extending the file if needed.
+     *
+     * @param[in]  filp     pointer to open file
+     * @param[in]  offset   start of the range
+     * @param[in]  len      length of the range, greater than 0
+     *
+     * @return 0 on success
+     * @return <0 on error
+     */
+    int (*fallocate) (vfs_file_t *filp, off_t offset, off_t len);
 };
 
 /**
@@ -608,6 +780,22 @@ struct vfs_dir_ops {
      */
     int (*readdir) (vfs_DIR *dirp, vfs_dirent_t *entry);
 
+    /**
+     * @brief Read up to @p n entries, including their status, from the open
+     * directory dirp and advance the read position past them
+     *
+     * This operation is optional, @c vfs_readdir_batch falls back to
+     * @c readdir and reports the entries without status if it is missing.
+     *
+     * @param[in]  dirp     pointer to open directory
+     * @param[out] entries  array of at least @p n entries
+     * @param[in]  n        maximum number of entries to read
+     *
+     * @return number of entries read, 0 if the end of the directory was reached
+     * @return <0 on error
+     */
+    ssize_t (*readdir_batch) (vfs_DIR *dirp, vfs_dirent_stat_t *entries, size_t n);
+
     /**
      * @brief Close an open directory
      *
@@ -770,6 +958,9 @@ void vfs_bind_stdio(void);
 /**
  * @brief Close an open file
  *
+ * The asynchronous requests queued on @p fd are cancelled, the ones being
+ * serviced are waited for.
+ *
  * @param[in]  fd    fd number to close
  *
  * @return 0 on success
@@ -781,7 +972,7 @@ int vfs_close(int fd);
  * @brief Query/set options on an open file
  *
  * @param[in]  fd    fd number to operate on
- * @param[in]  cmd   fcntl command, see man 3p fcntl
+ * @param[in]  cmd   fcntl command, see man 3p fcntl and @ref VFS_F_SETRA
  * @param[in]  arg   argument to fcntl command, see man 3p fcntl
  *
  * @return 0 on success
@@ -844,11 +1035,15 @@ off_t vfs_lseek(int fd, off_t off, int whence);
 /**
  * @brief Open a file
  *
+ * Read-only opens of a file pinned with @ref vfs_fcache_pin are served from
+ * memory, without calling the file system.
+ *
  * @param[in]  name    file name to open
- * @param[in]  flags   flags for opening, see man 3p open
+ * @param[in]  flags   flags for opening, see man 3p open and @ref O_DIRECT
  * @param[in]  mode    file mode
  *
  * @return fd number on success (>= 0)
+ * @return -ENFILE if the table of open files or the file slab of the mount is full
  * @return <0 on error
  */
 int vfs_open(const char *name, int flags, mode_t mode);
@@ -883,9 +1078,41 @@ ssize_t vfs_read(int fd, void *dest, size_t count);
  */
 ssize_t vfs_write(int fd, const void *src, size_t count);
 
+/**
+ * @brief Read bytes from an open file into several buffers
+ *
+ * The buffers are filled in order, the next one is only used if the previous
+ * one was filled completely.
+ *
+ * @param[in]  fd       fd number obtained from vfs_open
+ * @param[in]  iov      buffers to fill
+ * @param[in]  iovcnt   number of buffers
+ *
+ * @return number of bytes read on success
+ * @return <0 on error
+ */
+ssize_t vfs_readv(int fd, const struct iovec *iov, int iovcnt);
+
+/**
+ * @brief Write bytes from several buffers to an open file
+ *
+ * The file system may write the buffers as a single request, e.g. FatFs
+ * holds the volume once and merges small buffers into whole sectors.
+ *
+ * @param[in]  fd       fd number obtained from vfs_open
+ * @param[in]  iov      buffers to write
+ * @param[in]  iovcnt   number of buffers
+ *
+ * @return number of bytes written on success
+ * @return <0 on error
+ */
+ssize_t vfs_writev(int fd, const struct iovec *iov, int iovcnt);
+
 /**
  * @brief Write bytes from an iolist to an open file
  *
+ * The iolist is written with vfs_writev, in batches of a few snippets.
+ *
  * @param[in]  fd       fd number obtained from vfs_open
  * @param[in]  iolist   iolist to read from
  *
@@ -905,6 +1132,26 @@ ssize_t vfs_write_iol(int fd, const iolist_t *iolist);
  */
 int vfs_fsync(int fd);
 
+/**
+ * @brief Allocate storage for a file, like posix_fallocate()
+ *
+ * After a successful call, writes into the range [@p offset, @p offset +
+ * @p len) do not fail for lack of space. The file is extended to
+ * @p offset + @p len bytes if it is shorter, the content of the extension is
+ * unspecified.
+ *
+ * @param[in]  fd       fd number obtained from vfs_open
+ * @param[in]  offset   start of the range
+ * @param[in]  len      length of the range
+ *
+ * @return 0 on success
+ * @return -EBADF if the file is not open for writing
+ * @return -EINVAL if @p offset is negative or @p len is not positive
+ * @return -ENOTSUP if the file system does not support the allocation
+ * @return <0 on other errors
+ */
+int vfs_fallocate(int fd, off_t offset, off_t len);
+
 /**
  * @brief Open a directory for reading with readdir
  *
@@ -937,6 +1184,31 @@ int vfs_opendir(vfs_DIR *dirp, const char *dirname);
  */
 int vfs_readdir(vfs_DIR *dirp, vfs_dirent_t *entry);
 
+/**
+ * @brief Read several entries from the open directory dirp, together with
+ * their size, mode and modification time
+ *
+ * Unlike calling @ref vfs_readdir followed by @ref vfs_stat for each entry,
+ * the attributes are taken from the directory itself, so listing a
+ * directory costs a single pass over it.
+ * File systems that can not report the status of the entries return them
+ * with @c d_mode set to 0.
+ *
+ * @attention Calling vfs_readdir_batch on an uninitialized @c vfs_DIR is
+ * forbidden and may lead to file system corruption and random system failures.
+ *
+ * @param[in]  dirp     pointer to open directory
+ * @param[out] entries  array of at least @p n entries
+ * @param[in]  n        maximum number of entries to read
+ *
+ * @return number of entries read, less than @p n at the end of the directory
+ *         or if an error stopped the batch, the error is then returned by the
+ *         next call
+ * @return 0 if @p dirp has reached the end of the directory index
+ * @return <0 on error
+ */
+ssize_t vfs_readdir_batch(vfs_DIR *dirp, vfs_dirent_stat_t *entries, size_t n);
+
 /**
  * @brief Close an open directory
  *
@@ -986,9 +1258,14 @@ int vfs_format_by_path(const char *path);
  * @p mountp should have been populated in advance with a file system driver,
  * a mount point, and private_data (if the file system driver uses one).
  *
+ * The file slab of the mount, which holds the private data of its open files,
+ * is set up here for @ref vfs_mount_t::max_open_files objects. Its memory is
+ * allocated in chunks of @ref VFS_FILE_SLAB_CHUNK objects as files are opened.
+ *
  * @param[in]  mountp    pointer to the mount structure of the file system to mount
  *
  * @return 0 on success
+ * @return -ENOMEM if @ref VFS_MAX_MOUNTS file systems are already mounted
  * @return <0 on error
  */
 int vfs_mount(vfs_mount_t *mountp);
@@ -1085,6 +1362,12 @@ int vfs_rmdir(const char *name);
 /**
  * @brief Get file status
  *
+ * The status of normalized paths of at most @ref VFS_DCACHE_PATH_MAX
+ * characters is kept in the dentry cache if the file system sets
+ * @ref VFS_FS_FLAG_DCACHE, including the -ENOENT result of missing files.
+ * Every call that modifies a file system invalidates the cached entries of
+ * its mount.
+ *
  * @param[in]  path    path to file being queried
  * @param[out] buf     pointer to stat struct to fill
  *
@@ -1093,6 +1376,96 @@ int vfs_rmdir(const char *name);
  */
 int vfs_stat(const char *restrict path, struct stat *restrict buf);
 
+/**
+ * @brief Dentry cache statistics
+ */
+typedef struct {
+    uint32_t hits;              /**< Lookups answered with the cached status of a file */
+    uint32_t negative_hits;     /**< Lookups answered with a cached -ENOENT */
+    uint32_t misses;            /**< Cacheable lookups passed to the file system */
+    uint32_t invalidations;     /**< Calls that invalidated the entries of a mount */
+    uint32_t evictions;         /**< Valid entries replaced by a new one */
+} vfs_dcache_stats_t;
+
+/**
+ * @brief Get the statistics of the dentry cache
+ *
+ * @param[out] stats   statistics since the start or the last reset
+ */
+void vfs_dcache_stats_get(vfs_dcache_stats_t *stats);
+
+/**
+ * @brief Clear the statistics of the dentry cache
+ */
+void vfs_dcache_stats_reset(void);
+
+/**
+ * @brief Pin a file in the file cache
+ *
+ * The whole file is read into memory. Until it is unpinned, opening it
+ * read-only with the same normalized path returns a file descriptor that
+ * reads the copy in memory.
+ *
+ * The copy is dropped when the file is opened for writing, with any path,
+ * written, synced or closed after writing, and when a file on the same
+ * mount is unlinked or renamed. It is not read while the file is open for
+ * writing, read-only opens then go to the file system. It is read
+ * again on the next read-only open. Descriptors already open keep reading
+ * the contents at the time they were opened. The contents of all pinned
+ * files share @ref VFS_FCACHE_BUDGET bytes, the least recently opened ones
+ * are dropped to make room. Unmounting the file system unpins its files.
+ *
+ * Pinning a file again increments its pin count.
+ *
+ * @param[in]  path    absolute path of the file
+ *
+ * @return 0 on success
+ * @return -ENAMETOOLONG if the normalized path is longer than @ref VFS_FCACHE_PATH_MAX
+ * @return -ENOSPC if @ref VFS_FCACHE_ENTRIES files are already pinned
+ * @return -ENOTSUP if the file system does not set @ref VFS_FS_FLAG_DCACHE
+ * @return -EBUSY if the file is open for writing
+ * @return -EFBIG if the file is larger than @ref VFS_FCACHE_BUDGET
+ * @return -ENOMEM if the contents can not be allocated
+ * @return <0 on other errors, from opening and reading the file
+ */
+int vfs_fcache_pin(const char *path);
+
+/**
+ * @brief Unpin a file from the file cache
+ *
+ * The copy in memory is freed once the pin count drops to zero and the
+ * descriptors reading it are closed.
+ *
+ * @param[in]  path    absolute path of the file, as passed to @ref vfs_fcache_pin
+ *
+ * @return 0 on success
+ * @return -ENOENT if the file is not pinned
+ */
+int vfs_fcache_unpin(const char *path);
+
+/**
+ * @brief File cache statistics
+ */
+typedef struct {
+    uint32_t hits;              /**< Opens served from memory */
+    uint32_t loads;             /**< Reads of the contents of a pinned file */
+    uint32_t invalidations;     /**< Contents dropped because the file may have changed */
+    uint32_t evictions;         /**< Contents dropped to stay within the budget */
+    uint32_t bytes;             /**< Bytes of file contents currently held */
+} vfs_fcache_stats_t;
+
+/**
+ * @brief Get the statistics of the file cache
+ *
+ * @param[out] stats   statistics since the start or the last reset
+ */
+void vfs_fcache_stats_get(vfs_fcache_stats_t *stats);
+
+/**
+ * @brief Clear the statistics of the file cache, except the held bytes
+ */
+void vfs_fcache_stats_reset(void);
+
 /**
  * @brief Get file system status
  *
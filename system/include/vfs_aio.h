@@ -0,0 +1,217 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     system_vfs_aio
+ * @brief       Asynchronous file I/O on top of the VFS
+ *
+ * Reads, writes and syncs are queued with a caller owned control block and
+ * serviced by a pool of worker tasks calling @ref vfs_read, @ref vfs_write
+ * and @ref vfs_fsync, so the submitting task keeps running while the
+ * storage device is busy. Requests on the same file descriptor complete in
+ * submission order, requests on different file descriptors may be serviced
+ * in parallel.
+ *
+ * The completion is reported by a callback run in the worker task, by a
+ * task notification and through @ref vfs_aio_return / @ref vfs_aio_wait.
+ *
+ * @{
+ *
+ * @file        vfs_aio.h
+ * @brief       Asynchronous file I/O API
+ *
+ */
+#ifndef __VFS_AIO_H__
+#define __VFS_AIO_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Use the current file position instead of an explicit offset
+ */
+#define VFS_AIO_OFFSET_CURRENT  ((off_t)-1)
+
+/**
+ * @brief Asynchronous request types
+ */
+typedef enum {
+    VFS_AIO_OP_READ,    /**< vfs_read into vfs_aiocb_t::buf */
+    VFS_AIO_OP_WRITE,   /**< vfs_write from vfs_aiocb_t::buf */
+    VFS_AIO_OP_FSYNC,   /**< vfs_fsync */
+} vfs_aio_op_t;
+
+/**
+ * @brief struct @c vfs_aiocb typedef
+ */
+typedef struct vfs_aiocb vfs_aiocb_t;
+
+/**
+ * @brief Completion callback
+ *
+ * Runs in the worker task before the request is marked done, it must not
+ * block for long, resubmit or release @p cb.
+ *
+ * @param[in]  cb       the completed request, the result is already set
+ */
+typedef void (*vfs_aio_callback_t)(vfs_aiocb_t *cb);
+
+/**
+ * @brief Asynchronous I/O control block
+ *
+ * Owned by the caller, it must be zero initialized before its first
+ * submission, stay valid and must not be modified from submission until the
+ * request is done.
+ */
+struct vfs_aiocb {
+    int fd;                         /**< file descriptor */
+    off_t offset;                   /**< file offset, or @ref VFS_AIO_OFFSET_CURRENT */
+    void *buf;                      /**< data buffer, not used by fsync */
+    size_t nbytes;                  /**< number of bytes to transfer */
+    vfs_aio_callback_t callback;    /**< completion callback, may be NULL */
+    void *arg;                      /**< user argument for the callback */
+    TaskHandle_t notify;            /**< task notified at @ref VFS_AIO_NOTIFY_INDEX on completion, may be NULL */
+
+    /* private, set by the asynchronous I/O module */
+    vfs_aiocb_t *next;              /**< next request in the queue */
+    vfs_aio_op_t op;                /**< request type */
+    volatile uint8_t state;         /**< request state */
+    ssize_t result;                 /**< transferred bytes or negative errno */
+    SemaphoreHandle_t done;         /**< given once the request is done */
+    StaticSemaphore_t done_storage; /**< storage of the done semaphore */
+};
+
+/**
+ * @brief Creates the I/O worker tasks
+ */
+void vfs_aio_init(void);
+
+/**
+ * @brief Queues an asynchronous read
+ *
+ * Reads up to @c nbytes bytes from @c fd at @c offset into @c buf, short
+ * reads only happen at the end of the file.
+ *
+ * @param[in]  cb       control block of the request
+ *
+ * @return 0 on success
+ * @return -EINVAL if the control block is invalid
+ * @return -EBUSY if @p cb is still queued or in progress
+ * @return -EAGAIN if @ref VFS_AIO_QUEUE_LENGTH requests are already queued
+ */
+int vfs_aio_read(vfs_aiocb_t *cb);
+
+/**
+ * @brief Queues an asynchronous write
+ *
+ * Writes @c nbytes bytes from @c buf to @c fd at @c offset, the request only
+ * completes short if the file system reports an error or runs out of space.
+ *
+ * @param[in]  cb       control block of the request
+ *
+ * @return 0 on success
+ * @return -EINVAL if the control block is invalid
+ * @return -EBUSY if @p cb is still queued or in progress
+ * @return -EAGAIN if @ref VFS_AIO_QUEUE_LENGTH requests are already queued
+ */
+int vfs_aio_write(vfs_aiocb_t *cb);
+
+/**
+ * @brief Queues an asynchronous fsync
+ *
+ * Completes after every request queued before it on @c fd.
+ *
+ * @param[in]  cb       control block of the request
+ *
+ * @return 0 on success
+ * @return -EBUSY if @p cb is still queued or in progress
+ * @return -EAGAIN if @ref VFS_AIO_QUEUE_LENGTH requests are already queued
+ */
+int vfs_aio_fsync(vfs_aiocb_t *cb);
+
+/**
+ * @brief Polls the status of a request
+ *
+ * @param[in]  cb       submitted control block
+ *
+ * @return -EINPROGRESS while the request is queued or in progress
+ * @return -EINVAL if @p cb was never submitted
+ * @return number of bytes transferred (0 for fsync) once done
+ * @return <0 on error, -ECANCELED if the request was cancelled
+ */
+ssize_t vfs_aio_return(const vfs_aiocb_t *cb);
+
+/**
+ * @brief Waits for a request to complete
+ *
+ * Only one task may wait for the same request.
+ *
+ * @param[in]  cb       submitted control block
+ * @param[in]  timeout  maximum time to wait in ticks
+ *
+ * @return -EINVAL if @p cb was never submitted
+ * @return -ETIMEDOUT if the request is not done within @p timeout
+ * @return the result as returned by @ref vfs_aio_return otherwise
+ */
+ssize_t vfs_aio_wait(vfs_aiocb_t *cb, TickType_t timeout);
+
+/**
+ * @brief Cancels a queued request
+ *
+ * A cancelled request completes with -ECANCELED, the callback and the
+ * notification are delivered from the calling task.
+ *
+ * @param[in]  cb       submitted control block
+ *
+ * @return 0 if the request was cancelled
+ * @return -EINPROGRESS if a worker is already servicing the request
+ * @return -EALREADY if the request is already done
+ */
+int vfs_aio_cancel(vfs_aiocb_t *cb);
+
+/**
+ * @brief Cancels every queued request on a file descriptor
+ *
+ * Returns once the requests already being serviced are done, unless it is
+ * called from a completion callback. @ref vfs_close calls it.
+ *
+ * @param[in]  fd       file descriptor
+ *
+ * @return number of requests cancelled
+ */
+int vfs_aio_cancel_fd(int fd);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __VFS_AIO_H__ */
+/** @} */
@@ -41,6 +41,28 @@ struct iovec {
     size_t iov_len;     /**< Length of data.    */
 };
 
+/**
+ * @brief Read from a file into several buffers.
+ *
+ * @param[in]  fd       file descriptor
+ * @param[in]  iov      buffers to fill in order
+ * @param[in]  iovcnt   number of buffers
+ *
+ * @return number of bytes read, -1 on error with errno set
+ */
+ssize_t readv(int fd, const struct iovec *iov, int iovcnt);
+
+/**
+ * @brief Write several buffers to a file.
+ *
+ * @param[in]  fd       file descriptor
+ * @param[in]  iov      buffers to write in order
+ * @param[in]  iovcnt   number of buffers
+ *
+ * @return number of bytes written, -1 on error with errno set
+ */
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt);
+
 #ifdef __cplusplus
 }
 #endif
@@ -41,6 +41,7 @@
 #include <stdint.h>
 #include <sys/time.h>
 #include <sys/times.h>
+#include <sys/uio.h>
 
 #include "FreeRTOS.h"
 #include "task.h"
@@ -307,6 +308,52 @@ _ssize_t _write_r(struct _reent *r, int fd, const void *src, size_t count)
     return res;
 }
 
+/**
+ * @brief  Read bytes from an open file into several buffers
+ *
+ * This is a wrapper around @c vfs_readv
+ *
+ * @param  fd      open file descriptor obtained from @c open()
+ * @param  iov     buffers to fill in order
+ * @param  iovcnt  number of buffers
+ *
+ * @return number of bytes read on success
+ * @return -1 on error, @c errno set to a constant from errno.h to indicate the error
+ */
+ssize_t readv(int fd, const struct iovec *iov, int iovcnt)
+{
+    ssize_t res = vfs_readv(fd, iov, iovcnt);
+    if (res < 0) {
+        /* vfs returns negative error codes */
+        errno = -res;
+        return -1;
+    }
+    return res;
+}
+
+/**
+ * @brief  Write bytes from several buffers to an open file
+ *
+ * This is a wrapper around @c vfs_writev
+ *
+ * @param  fd      open file descriptor obtained from @c open()
+ * @param  iov     buffers to write in order
+ * @param  iovcnt  number of buffers
+ *
+ * @return number of bytes written on success
+ * @return -1 on error, @c errno set to a constant from errno.h to indicate the error
+ */
+ssize_t writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    ssize_t res = vfs_writev(fd, iov, iovcnt);
+    if (res < 0) {
+        /* vfs returns negative error codes */
+        errno = -res;
+        return -1;
+    }
+    return res;
+}
+
 /**
  * @brief  Close an open file
  *
@@ -34,6 +34,7 @@
 #include <string.h>
 
 #include "bitarithm.h"
+#include "macros/utils.h"
 #include "mtd.h"
 #include "xfa.h"
 
@@ -45,6 +46,29 @@ XFA_INIT_CONST(mtd_dev_t *, mtd_dev_xfa);
 #include "queue.h"
 #include "semphr.h"
 
+static mtd_dev_t *_stats_devs[MTD_STATS_DEVS_NUMOF];
+
+static int _read_page(mtd_dev_t *mtd, void *dest, uint32_t page, uint32_t offset,
+                      uint32_t count);
+static int _write_page_raw(mtd_dev_t *mtd, const void *src, uint32_t page,
+                           uint32_t offset, uint32_t count);
+static int _erase_sector(mtd_dev_t *mtd, uint32_t sector, uint32_t count);
+
+static void _stats_register(mtd_dev_t *mtd)
+{
+    taskENTER_CRITICAL();
+    for (unsigned i = 0; i < MTD_STATS_DEVS_NUMOF; i++) {
+        if (_stats_devs[i] == mtd) {
+            break;
+        }
+        if (_stats_devs[i] == NULL) {
+            _stats_devs[i] = mtd;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
 static bool out_of_bounds(mtd_dev_t *mtd, uint32_t page, uint32_t offset, uint32_t len)
 {
     const uint32_t page_shift = bitarithm_msb(mtd->page_size);
@@ -95,6 +119,10 @@ int mtd_init(mtd_dev_t *mtd)
     }
 #endif
 
+    if (res >= 0) {
+        _stats_register(mtd);
+    }
+
     return res;
 }
 
@@ -121,6 +149,16 @@ int mtd_read(mtd_dev_t *mtd, void *dest, uint32_t addr, uint32_t count)
 
 int mtd_read_page(mtd_dev_t *mtd, void *dest, uint32_t page, uint32_t offset,
                   uint32_t count)
+{
+    const uint32_t start = mtd_stats_start();
+    int res = _read_page(mtd, dest, page, offset, count);
+    mtd_stats_record(mtd, MTD_STATS_READ, count, start, res);
+
+    return res;
+}
+
+static int _read_page(mtd_dev_t *mtd, void *dest, uint32_t page, uint32_t offset,
+                      uint32_t count)
 {
     if (!mtd || !mtd->driver) {
         return -ENODEV;
@@ -295,6 +333,16 @@ int mtd_write_page(mtd_dev_t *mtd, const void *data, uint32_t page,
 
 int mtd_write_page_raw(mtd_dev_t *mtd, const void *src, uint32_t page, uint32_t offset,
                        uint32_t count)
+{
+    const uint32_t start = mtd_stats_start();
+    int res = _write_page_raw(mtd, src, page, offset, count);
+    mtd_stats_record(mtd, MTD_STATS_WRITE, count, start, res);
+
+    return res;
+}
+
+static int _write_page_raw(mtd_dev_t *mtd, const void *src, uint32_t page,
+                           uint32_t offset, uint32_t count)
 {
     if (!mtd || !mtd->driver) {
         return -ENODEV;
@@ -368,6 +416,19 @@ int mtd_erase(mtd_dev_t *mtd, uint32_t addr, uint32_t count)
 }
 
 int mtd_erase_sector(mtd_dev_t *mtd, uint32_t sector, uint32_t count)
+{
+    const uint32_t start = mtd_stats_start();
+    int res = _erase_sector(mtd, sector, count);
+    if (mtd) {
+        /* erasing a whole card does not fit into the size of a request */
+        const uint64_t size = (uint64_t)count * mtd->pages_per_sector * mtd->page_size;
+        mtd_stats_record(mtd, MTD_STATS_ERASE, MIN(size, UINT32_MAX), start, res);
+    }
+
+    return res;
+}
+
+static int _erase_sector(mtd_dev_t *mtd, uint32_t sector, uint32_t count)
 {
     if (!mtd || !mtd->driver) {
         return -ENODEV;
@@ -425,4 +486,114 @@ int mtd_power(mtd_dev_t *mtd, enum mtd_power_state power)
     }
 }
 
+int mtd_flush(mtd_dev_t *mtd)
+{
+    if (!mtd || !mtd->driver) {
+        return -ENODEV;
+    }
+
+    if (mtd->driver->flush == NULL) {
+        return 0;
+    }
+
+    const uint32_t start = mtd_stats_start();
+    int res = mtd->driver->flush(mtd);
+    mtd_stats_record(mtd, MTD_STATS_FLUSH, 0, start, res);
+
+    return res;
+}
+
+uint32_t mtd_stats_start(void)
+{
+    return portGET_RUN_TIME_COUNTER_VALUE();
+}
+
+void mtd_stats_record(mtd_dev_t *mtd, mtd_stats_op_t op, uint32_t size,
+                      uint32_t start, int res)
+{
+    if (!mtd || op >= MTD_STATS_OP_NUMOF) {
+        return;
+    }
+
+    /* the counter wraps around, only the difference is meaningful */
+    const uint32_t latency = (mtd_stats_start() - start) * MTD_STATS_RUN_TIME_COUNTER_US;
+
+    unsigned size_bucket = (size == 0) ? 0 : bitarithm_msb(size);
+    if (size_bucket >= MTD_STATS_SIZE_BUCKETS) {
+        size_bucket = MTD_STATS_SIZE_BUCKETS - 1;
+    }
+
+    unsigned latency_bucket = (latency == 0) ? 0 : bitarithm_msb(latency) + 1;
+    if (latency_bucket >= MTD_STATS_LATENCY_BUCKETS) {
+        latency_bucket = MTD_STATS_LATENCY_BUCKETS - 1;
+    }
+
+    mtd_op_stats_t *stats = &mtd->stats.op[op];
+
+    taskENTER_CRITICAL();
+    stats->ops++;
+    if (res < 0) {
+        stats->errors++;
+    }
+    else {
+        stats->bytes += size;
+    }
+    if (latency > stats->latency_max) {
+        stats->latency_max = latency;
+    }
+    stats->size_hist[size_bucket]++;
+    stats->latency_hist[latency_bucket]++;
+    taskEXIT_CRITICAL();
+}
+
+void mtd_stats_get(const mtd_dev_t *mtd, mtd_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = mtd->stats;
+    taskEXIT_CRITICAL();
+}
+
+void mtd_stats_reset(mtd_dev_t *mtd)
+{
+    taskENTER_CRITICAL();
+    memset(&mtd->stats, 0, sizeof(mtd->stats));
+    taskEXIT_CRITICAL();
+}
+
+uint32_t mtd_stats_latency_percentile(const mtd_op_stats_t *stats, unsigned percent)
+{
+    if (stats->ops == 0) {
+        return 0;
+    }
+
+    /* rank of the operation at the percentile, rounded up */
+    const uint64_t rank = ((uint64_t)stats->ops * percent + 99) / 100;
+    uint64_t seen = 0;
+    unsigned bucket;
+
+    for (bucket = 0; bucket < MTD_STATS_LATENCY_BUCKETS - 1; bucket++) {
+        seen += stats->latency_hist[bucket];
+        if (seen >= rank) {
+            break;
+        }
+    }
+
+    if (bucket == MTD_STATS_LATENCY_BUCKETS - 1) {
+        return stats->latency_max;
+    }
+
+    const uint32_t limit = (bucket == 0) ? 0 : (1ul << bucket) - 1;
+
+    return (limit < stats->latency_max) ? limit : stats->latency_max;
+}
+
+mtd_dev_t *mtd_stats_dev_get(unsigned idx)
+{
+    if (idx >= MTD_STATS_DEVS_NUMOF) {
+        return NULL;
+    }
+
+    return _stats_devs[idx];
+}
+
 /** @} */
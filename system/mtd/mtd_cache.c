@@ -0,0 +1,489 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     system_mtd_cache
+ * @{
+ *
+ * @file        mtd_cache.c
+ * @brief       Set-associative write-back block cache for MTD devices
+ * @}
+ */
+#define ENABLE_DEBUG 0
+#include "debug.h"
+#include "container.h"
+#include "macros/utils.h"
+#include "mtd.h"
+#include "mtd_cache.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+static inline uint32_t _sector_size(const mtd_cache_t *cache)
+{
+    return cache->base.pages_per_sector * cache->base.page_size;
+}
+
+static inline uint8_t *_line_data(const mtd_cache_t *cache, unsigned idx)
+{
+    return cache->data + idx * _sector_size(cache);
+}
+
+static void _invalidate_all(mtd_cache_t *cache)
+{
+    for (unsigned i = 0; i < (unsigned)cache->sets * cache->ways; i++) {
+        cache->lines[i].valid = false;
+        cache->lines[i].dirty = false;
+    }
+}
+
+static int _lookup_dirty(const mtd_cache_t *cache, uint32_t sector)
+{
+    const unsigned first = (sector & (cache->sets - 1)) * cache->ways;
+
+    for (unsigned i = first; i < first + cache->ways; i++) {
+        const mtd_cache_line_t *line = &cache->lines[i];
+        if (line->valid && line->dirty && line->sector == sector) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief   Writes back a dirty line together with the dirty lines caching the
+ *          neighbouring sectors in a single multi-block write
+ */
+static int _write_back(mtd_cache_t *cache, unsigned idx)
+{
+    const uint32_t sector_size = _sector_size(cache);
+    uint32_t first = cache->lines[idx].sector;
+    uint32_t count = 1;
+    int res;
+
+    while (count < MTD_CACHE_WRITE_COMBINE_SECTORS && first > 0 &&
+           _lookup_dirty(cache, first - 1) >= 0) {
+        first--;
+        count++;
+    }
+    while (count < MTD_CACHE_WRITE_COMBINE_SECTORS &&
+           _lookup_dirty(cache, first + count) >= 0) {
+        count++;
+    }
+
+    DEBUG("mtd_cache: write back sector %" PRIu32 " count %" PRIu32 "\n", first, count);
+
+    if (count == 1) {
+        res = mtd_write_sector(cache->parent, _line_data(cache, idx), first, 1);
+    }
+    else {
+        for (uint32_t i = 0; i < count; i++) {
+            memcpy(cache->staging + i * sector_size,
+                   _line_data(cache, _lookup_dirty(cache, first + i)), sector_size);
+        }
+        res = mtd_write_sector(cache->parent, cache->staging, first, count);
+    }
+
+    if (res < 0) {
+        return res;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        cache->lines[_lookup_dirty(cache, first + i)].dirty = false;
+    }
+
+    cache->stats.write_backs += count;
+    cache->stats.write_runs++;
+
+    return 0;
+}
+
+/**
+ * @brief   Writes back the dirty lines caching a sector of [sector, sector + count)
+ */
+static int _write_back_range(mtd_cache_t *cache, uint32_t sector, uint32_t count)
+{
+    int ret = 0;
+
+    for (unsigned i = 0; i < (unsigned)cache->sets * cache->ways; i++) {
+        const mtd_cache_line_t *line = &cache->lines[i];
+        if (line->valid && line->dirty &&
+            (line->sector - sector) < count) {
+            int res = _write_back(cache, i);
+            if (res < 0 && ret == 0) {
+                ret = res;
+            }
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief   Drops the lines caching a sector of [sector, sector + count)
+ */
+static void _invalidate_range(mtd_cache_t *cache, uint32_t sector, uint32_t count)
+{
+    for (unsigned i = 0; i < (unsigned)cache->sets * cache->ways; i++) {
+        mtd_cache_line_t *line = &cache->lines[i];
+        if (line->valid && (line->sector - sector) < count) {
+            line->valid = false;
+            line->dirty = false;
+        }
+    }
+}
+
+/**
+ * @brief   Returns the index of the line caching @p sector
+ *
+ * On a miss the least recently used line of the set is replaced, it is
+ * written back first if it is dirty. The new line is only read from the
+ * parent device if @p fill is set, i.e. it is not going to be overwritten
+ * completely.
+ */
+static int _get_line(mtd_cache_t *cache, uint32_t sector, bool fill)
+{
+    const unsigned first = (sector & (cache->sets - 1)) * cache->ways;
+    unsigned victim = first;
+
+    cache->access_counter++;
+
+    for (unsigned i = first; i < first + cache->ways; i++) {
+        mtd_cache_line_t *line = &cache->lines[i];
+
+        if (line->valid && line->sector == sector) {
+            line->last_use = cache->access_counter;
+            cache->stats.hits++;
+            return i;
+        }
+
+        /* prefer a free line, otherwise the least recently used one */
+        if (!cache->lines[victim].valid) {
+            continue;
+        }
+        if (!line->valid ||
+            (cache->access_counter - line->last_use) >
+            (cache->access_counter - cache->lines[victim].last_use)) {
+            victim = i;
+        }
+    }
+
+    cache->stats.misses++;
+
+    mtd_cache_line_t *line = &cache->lines[victim];
+
+    if (line->valid && line->dirty) {
+        int res = _write_back(cache, victim);
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    line->valid = false;
+
+    if (fill) {
+        int res = mtd_read_page(cache->parent, _line_data(cache, victim),
+                                sector * cache->base.pages_per_sector, 0,
+                                _sector_size(cache));
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    line->sector = sector;
+    line->last_use = cache->access_counter;
+    line->valid = true;
+    line->dirty = false;
+
+    return victim;
+}
+
+static int mtd_cache_init(mtd_dev_t *dev)
+{
+    mtd_cache_t *cache = container_of(dev, mtd_cache_t, base);
+
+    DEBUG("mtd_cache_init\n");
+
+    assert(cache->parent);
+    assert(cache->sets && ((cache->sets & (cache->sets - 1)) == 0));
+    assert(cache->ways);
+
+    int res = mtd_init(cache->parent);
+    if (res < 0) {
+        return res;
+    }
+
+    if (cache->lock == NULL) {
+        cache->lock = xSemaphoreCreateMutexStatic(&cache->lock_storage);
+        assert(cache->lock);
+    }
+
+    xSemaphoreTake(cache->lock, portMAX_DELAY);
+
+    /* FatFs initializes the disk on every mount and the parent device may hold
+       a different medium since the last one, nothing cached is kept. The
+       memory is reused if the geometry did not change. */
+    if (cache->lines != NULL &&
+        (dev->sector_count != cache->parent->sector_count ||
+         dev->pages_per_sector != cache->parent->pages_per_sector ||
+         dev->page_size != cache->parent->page_size)) {
+        vPortFree(cache->lines);
+        vPortFree(cache->data);
+        cache->lines = NULL;
+        cache->data = NULL;
+        cache->staging = NULL;
+    }
+
+    dev->sector_count = cache->parent->sector_count;
+    dev->pages_per_sector = cache->parent->pages_per_sector;
+    dev->page_size = cache->parent->page_size;
+    dev->write_size = cache->parent->write_size;
+
+    if (cache->lines == NULL) {
+        const unsigned numof = (unsigned)cache->sets * cache->ways;
+
+        cache->lines = pvPortMalloc(numof * sizeof(mtd_cache_line_t));
+        cache->data = pvPortMalloc((numof + MTD_CACHE_WRITE_COMBINE_SECTORS) * _sector_size(cache));
+        cache->staging = cache->data + numof * _sector_size(cache);
+
+        if (cache->lines == NULL || cache->data == NULL) {
+            vPortFree(cache->lines);
+            vPortFree(cache->data);
+            cache->lines = NULL;
+            cache->data = NULL;
+            cache->staging = NULL;
+            xSemaphoreGive(cache->lock);
+            return -ENOMEM;
+        }
+    }
+
+    _invalidate_all(cache);
+    cache->access_counter = 0;
+
+    xSemaphoreGive(cache->lock);
+
+    return 0;
+}
+
+static int mtd_cache_read_page(mtd_dev_t *dev, void *buff, uint32_t page,
+                               uint32_t offset, uint32_t size)
+{
+    mtd_cache_t *cache = container_of(dev, mtd_cache_t, base);
+    const uint32_t sector_size = _sector_size(cache);
+    const uint32_t sector = page / dev->pages_per_sector;
+    int res;
+
+    offset += (page % dev->pages_per_sector) * dev->page_size;
+
+    DEBUG("mtd_cache_read_page: sector:%" PRIu32 " offset:%" PRIu32 " size:%" PRIu32 "\n",
+          sector, offset, size);
+
+    xSemaphoreTake(cache->lock, portMAX_DELAY);
+
+    if (offset == 0 && size >= MTD_CACHE_BYPASS_THRESHOLD * sector_size) {
+        const uint32_t count = size / sector_size;
+
+        cache->stats.bypasses++;
+
+        res = _write_back_range(cache, sector, count);
+        if (res == 0) {
+            res = mtd_read_page(cache->parent, buff, sector * dev->pages_per_sector,
+                                0, count * sector_size);
+        }
+
+        xSemaphoreGive(cache->lock);
+        return (res < 0) ? res : (int)(count * sector_size);
+    }
+
+    size = MIN(size, sector_size - offset);
+
+    res = _get_line(cache, sector, true);
+    if (res >= 0) {
+        memcpy(buff, _line_data(cache, res) + offset, size);
+        res = size;
+    }
+
+    xSemaphoreGive(cache->lock);
+    return res;
+}
+
+static int mtd_cache_write_page(mtd_dev_t *dev, const void *buff, uint32_t page,
+                                uint32_t offset, uint32_t size)
+{
+    mtd_cache_t *cache = container_of(dev, mtd_cache_t, base);
+    const uint32_t sector_size = _sector_size(cache);
+    const uint32_t sector = page / dev->pages_per_sector;
+    int res;
+
+    offset += (page % dev->pages_per_sector) * dev->page_size;
+
+    DEBUG("mtd_cache_write_page: sector:%" PRIu32 " offset:%" PRIu32 " size:%" PRIu32 "\n",
+          sector, offset, size);
+
+    xSemaphoreTake(cache->lock, portMAX_DELAY);
+
+    if (offset == 0 && size >= MTD_CACHE_BYPASS_THRESHOLD * sector_size) {
+        const uint32_t count = size / sector_size;
+
+        cache->stats.bypasses++;
+
+        /* the cached copies, dirty or not, are overwritten */
+        _invalidate_range(cache, sector, count);
+        res = mtd_write_sector(cache->parent, buff, sector, count);
+
+        xSemaphoreGive(cache->lock);
+        return (res < 0) ? res : (int)(count * sector_size);
+    }
+
+    size = MIN(size, sector_size - offset);
+
+    res = _get_line(cache, sector, (offset != 0) || (size != sector_size));
+    if (res >= 0) {
+        memcpy(_line_data(cache, res) + offset, buff, size);
+        cache->lines[res].dirty = true;
+        res = size;
+    }
+
+    xSemaphoreGive(cache->lock);
+    return res;
+}
+
+static int mtd_cache_erase_sector(mtd_dev_t *dev, uint32_t sector, uint32_t count)
+{
+    mtd_cache_t *cache = container_of(dev, mtd_cache_t, base);
+
+    DEBUG("mtd_cache_erase_sector: sector: %" PRIu32 " count: %" PRIu32 "\n",
+          sector, count);
+
+    xSemaphoreTake(cache->lock, portMAX_DELAY);
+
+    _invalidate_range(cache, sector, count);
+    int res = mtd_erase_sector(cache->parent, sector, count);
+
+    xSemaphoreGive(cache->lock);
+    return res;
+}
+
+static int mtd_cache_power(mtd_dev_t *dev, enum mtd_power_state power)
+{
+    mtd_cache_t *cache = container_of(dev, mtd_cache_t, base);
+
+    if (power == MTD_POWER_DOWN) {
+        int res = mtd_flush(dev);
+        if (res < 0) {
+            return res;
+        }
+    }
+
+    return mtd_power(cache->parent, power);
+}
+
+static int mtd_cache_flush(mtd_dev_t *dev)
+{
+    mtd_cache_t *cache = container_of(dev, mtd_cache_t, base);
+
+    if (cache->lock == NULL) {
+        return 0;
+    }
+
+    xSemaphoreTake(cache->lock, portMAX_DELAY);
+
+    int res = 0;
+    if (cache->lines != NULL) {
+        res = _write_back_range(cache, 0, UINT32_MAX);
+        if (res == 0) {
+            res = mtd_flush(cache->parent);
+        }
+    }
+
+    xSemaphoreGive(cache->lock);
+    return res;
+}
+
+void mtd_cache_discard(mtd_cache_t *cache)
+{
+    if (cache->lock == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(cache->lock, portMAX_DELAY);
+
+    if (cache->lines != NULL) {
+        _invalidate_all(cache);
+    }
+
+    xSemaphoreGive(cache->lock);
+}
+
+int mtd_cache_deinit(mtd_cache_t *cache)
+{
+    int res = mtd_cache_flush(&cache->base);
+
+    if (cache->lock != NULL) {
+        xSemaphoreTake(cache->lock, portMAX_DELAY);
+    }
+
+    vPortFree(cache->lines);
+    vPortFree(cache->data);
+    cache->lines = NULL;
+    cache->data = NULL;
+    cache->staging = NULL;
+
+    if (cache->lock != NULL) {
+        xSemaphoreGive(cache->lock);
+        vSemaphoreDelete(cache->lock);
+        cache->lock = NULL;
+    }
+
+    return res;
+}
+
+void mtd_cache_get_stats(mtd_cache_t *cache, mtd_cache_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = cache->stats;
+    taskEXIT_CRITICAL();
+}
+
+void mtd_cache_reset_stats(mtd_cache_t *cache)
+{
+    taskENTER_CRITICAL();
+    memset(&cache->stats, 0, sizeof(cache->stats));
+    taskEXIT_CRITICAL();
+}
+
+const mtd_desc_t mtd_cache_driver = {
+    .init = mtd_cache_init,
+    .read_page = mtd_cache_read_page,
+    .write_page = mtd_cache_write_page,
+    .erase_sector = mtd_cache_erase_sector,
+    .power = mtd_cache_power,
+    .flush = mtd_cache_flush,
+    .flags = MTD_DRIVER_FLAG_DIRECT_WRITE,
+};
@@ -37,12 +37,24 @@
 #include <errno.h>
 #include <string.h>
 
+#include "FreeRTOS.h"
+
 static int mtd_sdcard_init(mtd_dev_t *dev)
 {
     DEBUG("mtd_sdcard_init\n");
 
     if (sdcard_init() == 0) {
-    	
+#if IS_USED(MODULE_MTD_WRITE_PAGE)
+        /* the card is written directly so mtd_init() does not allocate the
+           work area, it is still needed for accesses smaller than a block */
+        if (dev->work_area == NULL) {
+            dev->work_area = pvPortMalloc(SDCARD_SDHC_BLOCK_SIZE);
+            if (dev->work_area == NULL) {
+                return -ENOMEM;
+            }
+        }
+#endif
+
         /* erasing whole sectors is handled internally by the card so you can
            delete single blocks (i.e. pages) */
         dev->pages_per_sector = 1;
@@ -146,28 +158,22 @@ static int mtd_sdcard_write_page(mtd_dev_t *dev, const void *buff, uint32_t page
 
 static int mtd_sdcard_erase_sector(mtd_dev_t *dev, uint32_t sector, uint32_t count)
 {
-#if IS_ACTIVE(CONFIG_MTD_SDCARD_ERASE) && IS_USED(MODULE_MTD_WRITE_PAGE)
-
+#if IS_ACTIVE(CONFIG_MTD_SDCARD_ERASE)
+    (void)dev;
 
     DEBUG("mtd_sdcard_erase_sector: sector: %" PRIu32 " count: %" PRIu32 "\n",
           sector, count);
 
-    if (dev->work_area == NULL) {
-        DEBUG("mtd_sdcard_erase_sector: no work area\n");
-        return -ENOTSUP;
-    }
-    memset(dev->work_area, 0, SDCARD_SDHC_BLOCK_SIZE);
+    /* one erase command (CMD32 / CMD33 / CMD38) per UINT16_MAX blocks */
     while (count) {
-        int err;
-        err = sdcard_write_blocks(sector, 
-                                  1, 
-                                  dev->work_area);
+        const uint16_t num = MIN(count, UINT16_MAX);
+        int err = sdcard_erase_blocks(sector, num);
         if (err != 0) {
             DEBUG("mtd_sdcard_erase_sector: error %d\n", err);
             return -EIO;
         }
-        --count;
-        ++sector;
+        count -= num;
+        sector += num;
     }
 #else
     (void)dev;
@@ -209,6 +215,7 @@ const mtd_desc_t mtd_sdcard_driver = {
     .write_page = mtd_sdcard_write_page,
     .erase_sector = mtd_sdcard_erase_sector,
     .power = mtd_sdcard_power,
+    .flags = MTD_DRIVER_FLAG_DIRECT_WRITE,
 };
 
 #if IS_USED(MODULE_MTD_SDCARD_DEFAULT)
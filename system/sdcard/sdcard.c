@@ -36,6 +36,7 @@
 #include "dma.h"
 #include "gpio.h"
 
+#include <assert.h>
 #include <errno.h>
 #include <limits.h>
 #include <stdbool.h>
@@ -53,39 +54,195 @@ static SemaphoreHandle_t _tx_cplt_semphr = NULL;
 static StaticSemaphore_t _tx_cplt_semphr_storage;
 static SemaphoreHandle_t _rx_cplt_semphr = NULL;
 static StaticSemaphore_t _rx_cplt_semphr_storage;
+static SemaphoreHandle_t _busy_end_semphr = NULL;
+static StaticSemaphore_t _busy_end_semphr_storage;
+static volatile bool _busy_end_armed = false;
+
+static StaticQueue_t _request_queue_struct;
+static uint8_t _request_queue_storage[SDCARD_REQUEST_QUEUE_LENGTH * sizeof(sdcard_request_t *)];
+static QueueHandle_t _request_queue = NULL;
+
+static StackType_t _io_task_stack[SDCARD_IO_TASK_STACKSIZE];
+static StaticTask_t _io_task_tcb;
+static TaskHandle_t h_io_task = NULL;
+
+/* set by sdcard_deinit(), the I/O task completes the requests with -ENODEV
+   and the new requests are refused */
+static volatile bool _stopping = false;
+/* number of tasks in sdcard_submit() that may still put a request in the queue */
+static volatile unsigned _submitters = 0;
+/* task waiting in sdcard_deinit() for the I/O task to reach the stop request */
+static TaskHandle_t _stop_task = NULL;
 
 static HAL_StatusTypeDef _error = HAL_OK;
+static volatile uint32_t _transfer_error = HAL_SD_ERROR_NONE;
+static SemaphoreHandle_t _active_semphr = NULL;
+static bool _high_speed = false;
+
+/**
+ * Bounce buffer for transfers from / to buffers that are not word-aligned
+ * and therefore can not be used by the SDIO DMA directly. It is placed in
+ * .bss (SRAM), the CCM RAM is not accessible by the DMA controller.
+ */
+static uint8_t _bounce_buffer[SDCARD_BOUNCE_BUFFER_SIZE] __attribute__((aligned(4)));
+
+#define SDCARD_BOUNCE_BUFFER_BLOCKS    (SDCARD_BOUNCE_BUFFER_SIZE / SDCARD_SDHC_BLOCK_SIZE)
+
+static_assert((0 == (SDCARD_BOUNCE_BUFFER_SIZE % SDCARD_SDHC_BLOCK_SIZE)) && (SDCARD_BOUNCE_BUFFER_BLOCKS > 0),
+              "SDCARD_BOUNCE_BUFFER_SIZE must be a non-zero multiple of SDCARD_SDHC_BLOCK_SIZE");
 
 static int sdio_init(void);
+static int sdio_card_init(void);
+static int sdio_bus_init(void);
 static int sdio_deinit(void);
 static void sdio_msp_init(SD_HandleTypeDef *h_sd);
 static void sdio_msp_deinit(SD_HandleTypeDef *h_sd);
 static void sdio_tx_cplt_callback(SD_HandleTypeDef *h_sd);
 static void sdio_rx_cplt_callback(SD_HandleTypeDef *h_sd);
 static void sdio_error_callback(SD_HandleTypeDef *h_sd);
+static void sdio_busy_end_callback(void);
 static void error_handler(void);
+static void sdcard_io_task(void *params);
+static void sdcard_complete(sdcard_request_t *req, int result);
+static int sdcard_transfer(sdcard_request_t *req);
+static int sdio_read_blocks(uint32_t block_addr, uint16_t block_num, void *data);
+static int sdio_write_blocks(uint32_t block_addr, uint16_t block_num, const void *data);
+static int sdio_erase_blocks(uint32_t block_addr, uint16_t block_num);
+static int wait_for_transfer_state(void);
+static int wait_for_busy_end(void);
+static int sdio_read_blocks_dma(uint32_t block_addr, uint16_t block_num, void *data);
+static int sdio_write_blocks_dma(uint32_t block_addr, uint16_t block_num, const void *data);
+static void sdio_set_write_block_erase_count(uint16_t block_num);
+static int sdio_execute(const sdcard_request_t *req);
+static bool sdio_is_bus_error(int err);
+static void sdio_high_speed_init(void);
+static void sdio_set_bus_clock(bool high_speed);
+static uint32_t sdio_read_scr(uint32_t *scr);
+static uint32_t sdio_switch_function(uint32_t argument, uint32_t *status);
+static uint32_t sdio_read_data(uint32_t *data, uint32_t num_of_words);
 static bool is_word_aligned(const void *pbuf);
 static int sd_error_to_errno(const uint32_t error);
 
 int sdcard_init(void)
 {
+    /* FatFs initializes the disk on every mount and format. The I/O task and
+       its kernel objects are created once, but the card is identified again
+       each time, it may have been replaced since the last initialization. */
+    if (NULL != h_io_task)
+    {
+        return sdio_card_init();
+    }
+
     _tx_cplt_semphr = xSemaphoreCreateBinaryStatic(&_tx_cplt_semphr_storage);
     assert(_tx_cplt_semphr);
     _rx_cplt_semphr = xSemaphoreCreateBinaryStatic(&_rx_cplt_semphr_storage);
     assert(_rx_cplt_semphr);
+    _busy_end_semphr = xSemaphoreCreateBinaryStatic(&_busy_end_semphr_storage);
+    assert(_busy_end_semphr);
+
+    int ret = sdio_init();
+    if (ret < 0)
+    {
+        return ret;
+    }
 
-    return sdio_init();
+    _request_queue = xQueueCreateStatic(SDCARD_REQUEST_QUEUE_LENGTH,
+                                        sizeof(sdcard_request_t *),
+                                        _request_queue_storage,
+                                        &_request_queue_struct);
+    assert(_request_queue);
+
+    _stopping = false;
+    h_io_task = xTaskCreateStatic(sdcard_io_task,
+                                  "SDCARD IO",
+                                  SDCARD_IO_TASK_STACKSIZE,
+                                  NULL,
+                                  SDCARD_IO_TASK_PRIORITY,
+                                  _io_task_stack,
+                                  &_io_task_tcb);
+    assert(h_io_task);
+
+    return 0;
 }
 
 int sdcard_deinit(void)
 {
+    if (NULL != h_io_task)
+    {
+        assert(xTaskGetCurrentTaskHandle() != h_io_task);
+
+        /* refuse the new requests and wait until the submitters blocked on a
+           full queue got their requests in, the I/O task keeps draining it */
+        _stopping = true;
+        while (_submitters > 0)
+        {
+            vTaskDelay(1);
+        }
+
+        /* the requests queued before the stop request complete with -ENODEV,
+           the one in progress completes normally */
+        sdcard_request_t *stop = NULL;
+        _stop_task = xTaskGetCurrentTaskHandle();
+        xQueueSend(_request_queue, &stop, portMAX_DELAY);
+        ulTaskNotifyTakeIndexed(SDCARD_TASK_NOTIFICATION_INDEX, pdTRUE, portMAX_DELAY);
+        _stop_task = NULL;
+
+        vTaskDelete(h_io_task);
+        h_io_task = NULL;
+    }
+
+    if (NULL != _request_queue)
+    {
+        vQueueDelete(_request_queue);
+        _request_queue = NULL;
+    }
+
+    int ret = sdio_deinit();
+
     vSemaphoreDelete(_tx_cplt_semphr);
     vSemaphoreDelete(_rx_cplt_semphr);
+    vSemaphoreDelete(_busy_end_semphr);
 
     _tx_cplt_semphr = NULL;
     _rx_cplt_semphr = NULL;
+    _busy_end_semphr = NULL;
 
-    return sdio_deinit();
+    return ret;
+}
+
+int sdcard_submit(sdcard_request_t *req)
+{
+    assert(req);
+    assert(req->block_num);
+    assert((SDCARD_REQUEST_ERASE == req->type) || (NULL != req->data));
+
+    taskENTER_CRITICAL();
+    const bool stopped = (NULL == _request_queue) || (true == _stopping);
+    if (false == stopped)
+    {
+        _submitters++;
+    }
+    taskEXIT_CRITICAL();
+
+    if (true == stopped)
+    {
+        return -ENODEV;
+    }
+
+    req->result = -EINPROGRESS;
+
+    const BaseType_t sent = xQueueSend(_request_queue, &req, portMAX_DELAY);
+
+    taskENTER_CRITICAL();
+    _submitters--;
+    taskEXIT_CRITICAL();
+
+    if (pdTRUE != sent)
+    {
+        return -EAGAIN;
+    }
+
+    return 0;
 }
 
 int sdcard_read_blocks(uint32_t block_addr, uint16_t block_num, void *data)
@@ -93,146 +250,323 @@ int sdcard_read_blocks(uint32_t block_addr, uint16_t block_num, void *data)
     assert(data);
     assert(block_num);
 
+    sdcard_request_t req = {
+        .type = SDCARD_REQUEST_READ,
+        .block_addr = block_addr,
+        .block_num = block_num,
+        .data = data,
+    };
+
+    return sdcard_transfer(&req);
+}
+
+int sdcard_write_blocks(uint32_t block_addr, uint16_t block_num, const void *data)
+{
+    assert(data);
+    assert(block_num);
+
+    sdcard_request_t req = {
+        .type = SDCARD_REQUEST_WRITE,
+        .block_addr = block_addr,
+        .block_num = block_num,
+        .data = (void *)data,
+    };
+
+    return sdcard_transfer(&req);
+}
+
+int sdcard_erase_blocks(uint32_t block_addr, uint16_t block_num)
+{
+    assert(block_num);
+
+    sdcard_request_t req = {
+        .type = SDCARD_REQUEST_ERASE,
+        .block_addr = block_addr,
+        .block_num = block_num,
+    };
+
+    return sdcard_transfer(&req);
+}
+
+uint64_t sdcard_get_capacity(void)
+{
+    HAL_SD_CardInfoTypeDef ci = {0};
     HAL_StatusTypeDef hal_status;
-    TimeOut_t timeout;
-    TickType_t ticks_to_wait = pdMS_TO_TICKS(2 * SDCARD_DMA_BLOCK_TRANSFER_TIMEOUT_MS);
-    vTaskSetTimeOutState(&timeout);
-    BaseType_t timedout = xTaskCheckForTimeOut(&timeout, &ticks_to_wait);
 
-    while ((HAL_SD_CARD_TRANSFER != HAL_SD_GetCardState(&h_sdio)) && (pdFALSE == timedout))
+    hal_status = HAL_SD_GetCardInfo(&h_sdio, &ci);
+    if (HAL_OK != hal_status)
     {
-        vTaskDelay(pdMS_TO_TICKS(1));
-        timedout = xTaskCheckForTimeOut(&timeout, &ticks_to_wait);
+        return 0;
     }
 
-    if (pdTRUE == timedout)
-    {
-        return -ETIMEDOUT;
-    }
+    uint64_t capacity = ((uint64_t)ci.BlockNbr) * ((uint64_t)ci.BlockSize);
+    return capacity;
+}
 
-    if (true == is_word_aligned(data))
+/**
+ * @brief SD Card I/O task.
+ *
+ * This task serves the requests submitted with sdcard_submit() in FIFO order.
+ * The next request is taken from the queue as soon as the previous transfer
+ * has completed, so the card is not left idle while the submitters prepare
+ * their next request.
+ *
+ * @param params Pointer to task parameters (not used).
+ */
+static void sdcard_io_task(void *params)
+{
+    (void)params;
+
+    for ( ;; )
     {
-        hal_status = HAL_SD_ReadBlocks_DMA(&h_sdio, (uint8_t *)data, block_addr, (uint32_t)block_num);
-        if (HAL_OK != hal_status)
-        {
-            return sd_error_to_errno(h_sdio.ErrorCode);
-        }
+        sdcard_request_t *req;
+        xQueueReceive(_request_queue, &req, portMAX_DELAY);
 
-        const TickType_t ticks_to_wait = pdMS_TO_TICKS(SDCARD_DMA_BLOCK_TRANSFER_TIMEOUT_MS * block_num);
-        BaseType_t ret = xSemaphoreTake(_rx_cplt_semphr, ticks_to_wait);
-        if (pdTRUE != ret)
+        if (NULL == req)
         {
-            return -ETIMEDOUT;
+            /* stop request of sdcard_deinit(), every earlier request is
+               completed, wait to be deleted */
+            xTaskNotifyGiveIndexed(_stop_task, SDCARD_TASK_NOTIFICATION_INDEX);
+            vTaskSuspend(NULL);
+            continue;
         }
-    }
-    else
-    {
-        uint8_t *work_area = pvPortMalloc(SDCARD_SDHC_BLOCK_SIZE);
-        if (NULL == work_area)
+
+        if (true == _stopping)
         {
-            return -ENOMEM;
+            sdcard_complete(req, -ENODEV);
+            continue;
         }
 
-        for (uint32_t block = 0; block < (uint32_t)block_num; block++)
+        int result = sdio_execute(req);
+
+        /* the bus is not reliable at the High-Speed clock, fall back to the
+           default speed and retry the transfer once */
+        if ((true == sdio_is_bus_error(result)) && (true == _high_speed))
         {
-            uint32_t address = block_addr + block;
-            hal_status = HAL_SD_ReadBlocks_DMA(&h_sdio, work_area, address, 1);
-            if (HAL_OK != hal_status)
-            {
-                vPortFree(work_area);
-                return sd_error_to_errno(h_sdio.ErrorCode);
-            }
-
-            const TickType_t ticks_to_wait = pdMS_TO_TICKS(SDCARD_DMA_BLOCK_TRANSFER_TIMEOUT_MS);
-            BaseType_t ret = xSemaphoreTake(_rx_cplt_semphr, ticks_to_wait);
-            if (pdTRUE != ret)
-            {
-                return -ETIMEDOUT;
-            }
-
-            memcpy(data + SDCARD_SDHC_BLOCK_SIZE * block, work_area, SDCARD_SDHC_BLOCK_SIZE);
+            sdio_set_bus_clock(false);
+            result = sdio_execute(req);
         }
 
-        vPortFree(work_area);
+        sdcard_complete(req, result);
     }
-
-    return 0;
 }
 
-int sdcard_write_blocks(uint32_t block_addr, uint16_t block_num, const void *data)
+/**
+ * @brief Completes a request, sets its result, calls its callback and
+ *        notifies the waiting task.
+ *
+ * @param req    Pointer to the request.
+ * @param result Result of the request.
+ */
+static void sdcard_complete(sdcard_request_t *req, int result)
 {
-    assert(data);
-    assert(block_num);
+    /* the request may be reused or released by its owner once it is completed */
+    sdcard_request_cb_t callback = req->callback;
+    TaskHandle_t notify_task = req->notify_task;
+    req->result = result;
 
-    HAL_StatusTypeDef hal_status;
-    TimeOut_t timeout;
-    TickType_t ticks_to_wait = pdMS_TO_TICKS(2 * SDCARD_DMA_BLOCK_TRANSFER_TIMEOUT_MS);
-    vTaskSetTimeOutState(&timeout);
-    BaseType_t timedout = xTaskCheckForTimeOut(&timeout, &ticks_to_wait);
+    if (NULL != callback)
+    {
+        callback(req);
+    }
 
-    while ((HAL_SD_CARD_TRANSFER != HAL_SD_GetCardState(&h_sdio)) && (pdFALSE == timedout))
+    if (NULL != notify_task)
     {
-        vTaskDelay(pdMS_TO_TICKS(1));
-        timedout = xTaskCheckForTimeOut(&timeout, &ticks_to_wait);
+        xTaskNotifyGiveIndexed(notify_task, SDCARD_TASK_NOTIFICATION_INDEX);
     }
+}
 
-    if (pdTRUE == timedout)
+/**
+ * @brief Executes a request on the card.
+ *
+ * @param  req Pointer to the request.
+ *
+ * @return 0 on success,
+ * @return < 0 on error.
+ */
+static int sdio_execute(const sdcard_request_t *req)
+{
+    switch (req->type)
     {
-        return -ETIMEDOUT;
+        case SDCARD_REQUEST_READ  : return sdio_read_blocks(req->block_addr, req->block_num, req->data);
+        case SDCARD_REQUEST_WRITE : return sdio_write_blocks(req->block_addr, req->block_num, req->data);
+        case SDCARD_REQUEST_ERASE : return sdio_erase_blocks(req->block_addr, req->block_num);
+    }
+
+    return -EINVAL;
+}
+
+/**
+ * @brief Checks if a transfer failed because of a data CRC error or a FIFO
+ *        under / overrun, which are the signs of a too fast bus clock.
+ *
+ * @param  err Result of the transfer.
+ *
+ * @return True on a bus error, false otherwise.
+ */
+static bool sdio_is_bus_error(int err)
+{
+    return ((-EBADMSG == err) || (-ENOMEM == err)) ? true : false;
+}
+
+/**
+ * @brief Submits a request and blocks the calling task until it is completed.
+ *
+ * @param  req Pointer to the request, the completion fields are overwritten.
+ *
+ * @return The result of the request.
+ */
+static int sdcard_transfer(sdcard_request_t *req)
+{
+    assert(xTaskGetCurrentTaskHandle() != h_io_task);
+
+    req->callback = NULL;
+    req->notify_task = xTaskGetCurrentTaskHandle();
+
+    int ret = sdcard_submit(req);
+    if (ret < 0)
+    {
+        return ret;
     }
 
+    ulTaskNotifyTakeIndexed(SDCARD_TASK_NOTIFICATION_INDEX, pdTRUE, portMAX_DELAY);
+
+    return req->result;
+}
+
+/**
+ * @brief Reads blocks from the card, unaligned buffers are served through the
+ *        bounce buffer.
+ *
+ * @param  block_addr Start address given as block address.
+ * @param  block_num  Number of blocks to read.
+ * @param  data       Destination buffer.
+ *
+ * @return 0 on success,
+ * @return < 0 on error.
+ */
+static int sdio_read_blocks(uint32_t block_addr, uint16_t block_num, void *data)
+{
     if (true == is_word_aligned(data))
     {
-        hal_status = HAL_SD_WriteBlocks_DMA(&h_sdio, (uint8_t *)data, block_addr, (uint32_t)block_num);
-        if (HAL_OK != hal_status)
-        {
-            return sd_error_to_errno(h_sdio.ErrorCode);
-        }
+        return sdio_read_blocks_dma(block_addr, block_num, data);
+    }
+
+    uint8_t *dst = data;
 
-        const TickType_t ticks_to_wait = pdMS_TO_TICKS(2 * SDCARD_DMA_BLOCK_TRANSFER_TIMEOUT_MS * block_num);
-        BaseType_t ret = xSemaphoreTake(_tx_cplt_semphr, ticks_to_wait);
-        if (pdTRUE != ret)
+    while (block_num)
+    {
+        const uint16_t chunk = (block_num < SDCARD_BOUNCE_BUFFER_BLOCKS) ? block_num : (uint16_t)SDCARD_BOUNCE_BUFFER_BLOCKS;
+
+        int ret = sdio_read_blocks_dma(block_addr, chunk, _bounce_buffer);
+        if (ret < 0)
         {
-            return -ETIMEDOUT;
+            return ret;
         }
+
+        memcpy(dst, _bounce_buffer, (size_t)chunk * SDCARD_SDHC_BLOCK_SIZE);
+
+        dst += (size_t)chunk * SDCARD_SDHC_BLOCK_SIZE;
+        block_addr += chunk;
+        block_num -= chunk;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Writes blocks to the card, unaligned buffers are served through the
+ *        bounce buffer.
+ *
+ * @param  block_addr Start address given as block address.
+ * @param  block_num  Number of blocks to write.
+ * @param  data       Source buffer.
+ *
+ * @return 0 on success,
+ * @return < 0 on error.
+ */
+static int sdio_write_blocks(uint32_t block_addr, uint16_t block_num, const void *data)
+{
+    if (true == is_word_aligned(data))
+    {
+        return sdio_write_blocks_dma(block_addr, block_num, data);
     }
-    else
+
+    const uint8_t *src = data;
+
+    while (block_num)
     {
-        uint8_t *work_area = pvPortMalloc(SDCARD_SDHC_BLOCK_SIZE);
-        if (NULL == work_area)
-        {
-            return -ENOMEM;
-        }
+        const uint16_t chunk = (block_num < SDCARD_BOUNCE_BUFFER_BLOCKS) ? block_num : (uint16_t)SDCARD_BOUNCE_BUFFER_BLOCKS;
 
-        for (uint32_t block = 0; block < (uint32_t)block_num; block++)
+        memcpy(_bounce_buffer, src, (size_t)chunk * SDCARD_SDHC_BLOCK_SIZE);
+
+        int ret = sdio_write_blocks_dma(block_addr, chunk, _bounce_buffer);
+        if (ret < 0)
         {
-            memcpy(work_area, data + SDCARD_SDHC_BLOCK_SIZE * block, SDCARD_SDHC_BLOCK_SIZE);
-            uint32_t address = block_addr + block;
-            hal_status = HAL_SD_WriteBlocks_DMA(&h_sdio, work_area, address, 1);
-            if (HAL_OK != hal_status)
-            {
-                vPortFree(work_area);
-                return sd_error_to_errno(h_sdio.ErrorCode);
-            }
-
-            const TickType_t ticks_to_wait = pdMS_TO_TICKS(2 * SDCARD_DMA_BLOCK_TRANSFER_TIMEOUT_MS);
-            BaseType_t ret = xSemaphoreTake(_tx_cplt_semphr, ticks_to_wait);
-            if (pdTRUE != ret)
-            {
-                return -ETIMEDOUT;
-            }
+            return ret;
         }
 
-        vPortFree(work_area);
+        src += (size_t)chunk * SDCARD_SDHC_BLOCK_SIZE;
+        block_addr += chunk;
+        block_num -= chunk;
     }
 
     return 0;
 }
 
-int sdcard_erase_blocks(uint32_t block_addr, uint16_t block_num)
+/**
+ * @brief Erases blocks on the card.
+ *
+ * @param  block_addr Start address given as block address.
+ * @param  block_num  Number of blocks to erase.
+ *
+ * @return 0 on success,
+ * @return < 0 on error.
+ */
+static int sdio_erase_blocks(uint32_t block_addr, uint16_t block_num)
 {
-    assert(block_num);
     HAL_StatusTypeDef hal_status;
+
+    int ret = wait_for_transfer_state();
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    /* the end address of CMD33 is inclusive */
+    hal_status = HAL_SD_Erase(&h_sdio, block_addr, block_addr + (uint32_t)block_num - 1);
+    if (HAL_OK != hal_status)
+    {
+        return sd_error_to_errno(h_sdio.ErrorCode);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Waits until the card is in the transfer state and can accept a new
+ *        data transfer command.
+ *
+ * The end of the programming (busy) state is detected on the D0 line, the
+ * card state is confirmed with a single CMD13 afterwards. The card state is
+ * only polled if the card is still not in the transfer state.
+ *
+ * @return 0 on success,
+ * @return -ETIMEDOUT if the card did not become ready in time.
+ */
+static int wait_for_transfer_state(void)
+{
+    int ret = wait_for_busy_end();
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    if (HAL_SD_CARD_TRANSFER == HAL_SD_GetCardState(&h_sdio))
+    {
+        return 0;
+    }
+
     TimeOut_t timeout;
     TickType_t ticks_to_wait = pdMS_TO_TICKS(2 * SDCARD_DMA_BLOCK_TRANSFER_TIMEOUT_MS);
     vTaskSetTimeOutState(&timeout);
@@ -244,33 +578,375 @@ int sdcard_erase_blocks(uint32_t block_addr, uint16_t block_num)
         timedout = xTaskCheckForTimeOut(&timeout, &ticks_to_wait);
     }
 
-    if (pdTRUE == timedout)
+    return (pdTRUE == timedout) ? -ETIMEDOUT : 0;
+}
+
+/**
+ * @brief Waits until the card releases the D0 line.
+ *
+ * The line is sampled @ref SDCARD_BUSY_SPIN_COUNT times first, longer busy
+ * periods (e.g. programming after a write or an erase) are awaited on the
+ * rising edge interrupt of D0, so the next command can be issued right after
+ * the card became ready.
+ *
+ * @return 0 on success,
+ * @return -ETIMEDOUT if the card is still busy after the timeout.
+ */
+static int wait_for_busy_end(void)
+{
+    for (uint32_t i = 0; i < SDCARD_BUSY_SPIN_COUNT; i++)
     {
-        return -ETIMEDOUT;
+        if (0 != sdcard_d0_pin_read())
+        {
+            return 0;
+        }
+    }
+
+    sdcard_d0_pin_exti_enable();
+
+    /* drop the signal of an edge that was not awaited, the callback does not
+       give the semaphore again until the wait is armed */
+    xSemaphoreTake(_busy_end_semphr, 0);
+    _busy_end_armed = true;
+
+    int ret = 0;
+
+    /* the edge may have occurred before the interrupt was enabled */
+    if (0 == sdcard_d0_pin_read())
+    {
+        const TickType_t ticks_to_wait = pdMS_TO_TICKS(2 * SDCARD_DMA_BLOCK_TRANSFER_TIMEOUT_MS);
+        if (pdTRUE != xSemaphoreTake(_busy_end_semphr, ticks_to_wait))
+        {
+            ret = -ETIMEDOUT;
+        }
+    }
+
+    _busy_end_armed = false;
+    sdcard_d0_pin_exti_disable();
+
+    return ret;
+}
+
+/**
+ * @brief Reads blocks from the card into a word-aligned buffer using DMA.
+ *
+ * A single (CMD17) or multiple (CMD18) block read command is issued
+ * by the HAL depending on @p block_num.
+ *
+ * @param  block_addr Start address given as block address.
+ * @param  block_num  Number of blocks to read.
+ * @param  data       Word-aligned, DMA accessible destination buffer.
+ *
+ * @return 0 on success,
+ * @return < 0 on error.
+ */
+static int sdio_read_blocks_dma(uint32_t block_addr, uint16_t block_num, void *data)
+{
+    int ret = wait_for_transfer_state();
+    if (ret < 0)
+    {
+        return ret;
     }
 
-    hal_status = HAL_SD_Erase(&h_sdio, block_addr, block_addr + (uint32_t)block_num);
+    _transfer_error = HAL_SD_ERROR_NONE;
+    _active_semphr = _rx_cplt_semphr;
+
+    HAL_StatusTypeDef hal_status = HAL_SD_ReadBlocks_DMA(&h_sdio, (uint8_t *)data, block_addr, (uint32_t)block_num);
     if (HAL_OK != hal_status)
     {
+        _active_semphr = NULL;
         return sd_error_to_errno(h_sdio.ErrorCode);
     }
 
-    return 0;
+    const TickType_t ticks_to_wait = pdMS_TO_TICKS(SDCARD_DMA_BLOCK_TRANSFER_TIMEOUT_MS * block_num);
+    BaseType_t taken = xSemaphoreTake(_rx_cplt_semphr, ticks_to_wait);
+    _active_semphr = NULL;
+
+    if (pdTRUE != taken)
+    {
+        return -ETIMEDOUT;
+    }
+
+    return sd_error_to_errno(_transfer_error);
 }
 
-uint64_t sdcard_get_capacity(void)
+/**
+ * @brief Writes blocks to the card from a word-aligned buffer using DMA.
+ *
+ * A single (CMD24) or multiple (CMD25) block write command is issued
+ * by the HAL depending on @p block_num. Multiple block writes are preceded
+ * by an ACMD23 so the card can pre-erase the blocks to be written.
+ *
+ * @param  block_addr Start address given as block address.
+ * @param  block_num  Number of blocks to write.
+ * @param  data       Word-aligned, DMA accessible source buffer.
+ *
+ * @return 0 on success,
+ * @return < 0 on error.
+ */
+static int sdio_write_blocks_dma(uint32_t block_addr, uint16_t block_num, const void *data)
 {
-    HAL_SD_CardInfoTypeDef ci = {0};
-    HAL_StatusTypeDef hal_status;
+    int ret = wait_for_transfer_state();
+    if (ret < 0)
+    {
+        return ret;
+    }
 
-    hal_status = HAL_SD_GetCardInfo(&h_sdio, &ci);
+    if (block_num > 1)
+    {
+        sdio_set_write_block_erase_count(block_num);
+    }
+
+    _transfer_error = HAL_SD_ERROR_NONE;
+    _active_semphr = _tx_cplt_semphr;
+
+    HAL_StatusTypeDef hal_status = HAL_SD_WriteBlocks_DMA(&h_sdio, (uint8_t *)data, block_addr, (uint32_t)block_num);
     if (HAL_OK != hal_status)
     {
-        return 0;
+        _active_semphr = NULL;
+        return sd_error_to_errno(h_sdio.ErrorCode);
     }
 
-    uint64_t capacity = ((uint64_t)ci.BlockNbr) * ((uint64_t)ci.BlockSize);
-    return capacity;
+    const TickType_t ticks_to_wait = pdMS_TO_TICKS(2 * SDCARD_DMA_BLOCK_TRANSFER_TIMEOUT_MS * block_num);
+    BaseType_t taken = xSemaphoreTake(_tx_cplt_semphr, ticks_to_wait);
+    _active_semphr = NULL;
+
+    if (pdTRUE != taken)
+    {
+        return -ETIMEDOUT;
+    }
+
+    return sd_error_to_errno(_transfer_error);
+}
+
+/**
+ * @brief Sends the number of blocks to be pre-erased before the next multiple
+ *        block write (ACMD23, SET_WR_BLK_ERASE_COUNT).
+ *
+ * The command is only a performance hint, the write is issued regardless of
+ * its result.
+ *
+ * @param  block_num  Number of blocks the next multiple block write transfers.
+ */
+static void sdio_set_write_block_erase_count(uint16_t block_num)
+{
+    SDIO_CmdInitTypeDef cmd;
+
+    uint32_t error = SDMMC_CmdAppCommand(h_sdio.Instance, (uint32_t)h_sdio.SdCard.RelCardAdd << 16);
+    if (HAL_SD_ERROR_NONE != error)
+    {
+        return;
+    }
+
+    cmd.Argument = (uint32_t)block_num;
+    cmd.CmdIndex = SDMMC_CMD_SET_BLOCK_COUNT;
+    cmd.Response = SDIO_RESPONSE_SHORT;
+    cmd.WaitForInterrupt = SDIO_WAIT_NO;
+    cmd.CPSM = SDIO_CPSM_ENABLE;
+    (void)SDIO_SendCommand(h_sdio.Instance, &cmd);
+
+    (void)SDMMC_GetCmdResp1(h_sdio.Instance, SDMMC_CMD_SET_BLOCK_COUNT, SDIO_CMDTIMEOUT);
+}
+
+/**
+ * @brief Switches the card to High-Speed mode and raises the bus clock if the
+ *        card supports it, the card stays in default speed mode otherwise.
+ *
+ * The SCR tells if the card implements the switch function command (SD 1.10
+ * and later), the function status returned by CMD6 in check mode tells if the
+ * High-Speed function of the access mode group is supported.
+ */
+static void sdio_high_speed_init(void)
+{
+    uint32_t scr[2];
+    uint32_t status[16];
+    const uint8_t *sw = (const uint8_t *)status;
+
+    if (HAL_SD_ERROR_NONE != sdio_read_scr(scr))
+    {
+        return;
+    }
+
+    /* SD_SPEC, SCR[59:56] */
+    if (0 == ((scr[0] >> 24) & 0x0Fu))
+    {
+        return;
+    }
+
+    /* check mode, access mode group: High-Speed. Support bits of group 1 are
+       in bits 415:400 of the status, byte 13 holds bits 407:400 */
+    if ((HAL_SD_ERROR_NONE != sdio_switch_function(0x00FFFFF1u, status)) || (0 == (sw[13] & 0x02u)))
+    {
+        return;
+    }
+
+    /* switch mode, the selected function of group 1 is in bits 379:376 */
+    if ((HAL_SD_ERROR_NONE != sdio_switch_function(0x80FFFFF1u, status)) || (0x01u != (sw[16] & 0x0Fu)))
+    {
+        return;
+    }
+
+    sdio_set_bus_clock(true);
+}
+
+/**
+ * @brief Selects the bus clock.
+ *
+ * @param high_speed True selects the SDIO clock bypass (48 MHz, High-Speed
+ *                   mode), false the SDIO_TRANSFER_CLK_DIV divider (24 MHz).
+ */
+static void sdio_set_bus_clock(bool high_speed)
+{
+    h_sdio.Init.ClockBypass = (true == high_speed) ? SDIO_CLOCK_BYPASS_ENABLE : SDIO_CLOCK_BYPASS_DISABLE;
+    h_sdio.Init.ClockDiv = SDIO_TRANSFER_CLK_DIV;
+
+    (void)SDIO_Init(h_sdio.Instance, h_sdio.Init);
+
+    _high_speed = high_speed;
+}
+
+/**
+ * @brief Reads the SD Configuration Register (ACMD51).
+ *
+ * @param  scr Buffer for the two words of the register, scr[0] holds bits 63:32,
+ *             only written on success.
+ *
+ * @return HAL_SD_ERROR_NONE on success, HAL_SD_ERROR_* otherwise.
+ */
+static uint32_t sdio_read_scr(uint32_t *scr)
+{
+    uint32_t data[2];
+
+    uint32_t error = SDMMC_CmdBlockLength(h_sdio.Instance, 8u);
+    if (HAL_SD_ERROR_NONE != error)
+    {
+        return error;
+    }
+
+    /* the block length is restored on every path from here */
+    error = SDMMC_CmdAppCommand(h_sdio.Instance, (uint32_t)h_sdio.SdCard.RelCardAdd << 16);
+    if (HAL_SD_ERROR_NONE == error)
+    {
+        SDIO_DataInitTypeDef config = {
+            .DataTimeOut = SDMMC_DATATIMEOUT,
+            .DataLength = 8u,
+            .DataBlockSize = SDIO_DATABLOCK_SIZE_8B,
+            .TransferDir = SDIO_TRANSFER_DIR_TO_SDIO,
+            .TransferMode = SDIO_TRANSFER_MODE_BLOCK,
+            .DPSM = SDIO_DPSM_ENABLE,
+        };
+        (void)SDIO_ConfigData(h_sdio.Instance, &config);
+
+        error = SDMMC_CmdSendSCR(h_sdio.Instance);
+    }
+
+    if (HAL_SD_ERROR_NONE == error)
+    {
+        error = sdio_read_data(data, 2);
+    }
+
+    if (HAL_SD_ERROR_NONE == error)
+    {
+        /* the register is sent MSB first */
+        scr[0] = __REV(data[0]);
+        scr[1] = __REV(data[1]);
+    }
+
+    uint32_t restore = SDMMC_CmdBlockLength(h_sdio.Instance, SDCARD_SDHC_BLOCK_SIZE);
+
+    return (HAL_SD_ERROR_NONE != error) ? error : restore;
+}
+
+/**
+ * @brief Sends a switch function command (CMD6) and reads the 512 bit
+ *        function status.
+ *
+ * @param  argument Mode and function selection of the command.
+ * @param  status   Word-aligned buffer for the 64 byte status, in the order
+ *                  it is sent by the card (byte 0 holds bits 511:504).
+ *
+ * @return HAL_SD_ERROR_NONE on success, HAL_SD_ERROR_* otherwise.
+ */
+static uint32_t sdio_switch_function(uint32_t argument, uint32_t *status)
+{
+    uint32_t error = SDMMC_CmdBlockLength(h_sdio.Instance, 64u);
+    if (HAL_SD_ERROR_NONE != error)
+    {
+        return error;
+    }
+
+    SDIO_DataInitTypeDef config = {
+        .DataTimeOut = SDMMC_DATATIMEOUT,
+        .DataLength = 64u,
+        .DataBlockSize = SDIO_DATABLOCK_SIZE_64B,
+        .TransferDir = SDIO_TRANSFER_DIR_TO_SDIO,
+        .TransferMode = SDIO_TRANSFER_MODE_BLOCK,
+        .DPSM = SDIO_DPSM_ENABLE,
+    };
+    (void)SDIO_ConfigData(h_sdio.Instance, &config);
+
+    error = SDMMC_CmdSwitch(h_sdio.Instance, argument);
+    if (HAL_SD_ERROR_NONE == error)
+    {
+        error = sdio_read_data(status, 16);
+    }
+
+    uint32_t restore = SDMMC_CmdBlockLength(h_sdio.Instance, SDCARD_SDHC_BLOCK_SIZE);
+
+    return (HAL_SD_ERROR_NONE != error) ? error : restore;
+}
+
+/**
+ * @brief Reads the data block of a command from the FIFO by polling.
+ *
+ * @param  data         Destination buffer.
+ * @param  num_of_words Number of words in the data block.
+ *
+ * @return HAL_SD_ERROR_NONE on success, HAL_SD_ERROR_* otherwise.
+ */
+static uint32_t sdio_read_data(uint32_t *data, uint32_t num_of_words)
+{
+    const uint32_t tickstart = HAL_GetTick();
+    uint32_t index = 0;
+
+    memset(data, 0, num_of_words * sizeof(uint32_t));
+
+    while (!__HAL_SD_GET_FLAG(&h_sdio, SDIO_FLAG_RXOVERR | SDIO_FLAG_DCRCFAIL | SDIO_FLAG_DTIMEOUT | SDIO_FLAG_DATAEND))
+    {
+        if (__HAL_SD_GET_FLAG(&h_sdio, SDIO_FLAG_RXDAVL) && (index < num_of_words))
+        {
+            data[index++] = SDIO_ReadFIFO(h_sdio.Instance);
+        }
+
+        if ((HAL_GetTick() - tickstart) >= SDCARD_DMA_BLOCK_TRANSFER_TIMEOUT_MS)
+        {
+            return HAL_SD_ERROR_TIMEOUT;
+        }
+    }
+
+    while (__HAL_SD_GET_FLAG(&h_sdio, SDIO_FLAG_RXDAVL) && (index < num_of_words))
+    {
+        data[index++] = SDIO_ReadFIFO(h_sdio.Instance);
+    }
+
+    uint32_t error = HAL_SD_ERROR_NONE;
+
+    if (__HAL_SD_GET_FLAG(&h_sdio, SDIO_FLAG_DTIMEOUT))
+    {
+        error = HAL_SD_ERROR_DATA_TIMEOUT;
+    }
+    else if (__HAL_SD_GET_FLAG(&h_sdio, SDIO_FLAG_DCRCFAIL))
+    {
+        error = HAL_SD_ERROR_DATA_CRC_FAIL;
+    }
+    else if (__HAL_SD_GET_FLAG(&h_sdio, SDIO_FLAG_RXOVERR))
+    {
+        error = HAL_SD_ERROR_RX_OVERRUN;
+    }
+
+    __HAL_SD_CLEAR_FLAG(&h_sdio, SDIO_STATIC_DATA_FLAGS);
+
+    return error;
 }
 
 /**
@@ -295,6 +971,7 @@ static bool is_word_aligned(const void *pbuf)
 static int sdio_init(void)
 {
     _error = HAL_OK;
+    _high_speed = false;
 
     h_sdio.Instance = SDIO;
     h_sdio.Init.ClockEdge = SDIO_CLOCK_EDGE_RISING;
@@ -347,12 +1024,65 @@ static int sdio_init(void)
         return hal_statustypedef_to_errno(ret);
     }
 
-    ret = HAL_SD_ConfigWideBusOperation(&h_sdio, SDIO_BUS_WIDE_4B);
+    ret = sdio_bus_init();
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    return sdcard_d0_pin_exti_init(sdio_busy_end_callback);
+}
+
+/**
+ * @brief Identifies the card again on the initialized SDIO interface.
+ *
+ * @note   The I/O task must not have a request in flight. The card may have
+ *         been replaced, nothing is kept from the previous identification.
+ *
+ * @return 0 on success,
+ * @return < 0 on error.
+ */
+static int sdio_card_init(void)
+{
+    _high_speed = false;
+
+    h_sdio.Init.ClockBypass = SDIO_CLOCK_BYPASS_DISABLE;
+    h_sdio.Init.BusWide = SDIO_BUS_WIDE_1B;
+    h_sdio.Init.ClockDiv = SDIO_TRANSFER_CLK_DIV;
+    h_sdio.ErrorCode = HAL_SD_ERROR_NONE;
+
+    HAL_StatusTypeDef ret = HAL_SD_InitCard(&h_sdio);
+    if (HAL_OK != ret)
+    {
+        return hal_statustypedef_to_errno(ret);
+    }
+
+    return sdio_bus_init();
+}
+
+/**
+ * @brief Switches the identified card to the 4-bit bus and, if enabled, to
+ *        High-Speed mode.
+ *
+ * @return 0 on success,
+ * @return < 0 on error.
+ */
+static int sdio_bus_init(void)
+{
+    HAL_StatusTypeDef ret = HAL_SD_ConfigWideBusOperation(&h_sdio, SDIO_BUS_WIDE_4B);
     if (HAL_OK != ret)
     {
         return hal_statustypedef_to_errno(ret);
     }
 
+    /* the HAL does not store the bus width in the handle */
+    h_sdio.Init.BusWide = SDIO_BUS_WIDE_4B;
+
+    if (0 != SDCARD_HIGH_SPEED_ENABLE)
+    {
+        sdio_high_speed_init();
+    }
+
     return 0;
 }
 
@@ -406,6 +1136,12 @@ static int sdio_deinit(void)
 {
     HAL_StatusTypeDef ret;
 
+    int err = sdcard_d0_pin_exti_deinit();
+    if (err < 0)
+    {
+        return err;
+    }
+
     ret = HAL_SD_UnRegisterCallback(&h_sdio, HAL_SD_TX_CPLT_CB_ID);
     if (HAL_OK != ret)
     {
@@ -526,10 +1262,39 @@ static void sdio_rx_cplt_callback(SD_HandleTypeDef *h_sd)
  */
 static void sdio_error_callback(SD_HandleTypeDef *h_sd)
 {
-    (void)h_sd;
+    _transfer_error = (HAL_SD_ERROR_NONE != h_sd->ErrorCode) ? h_sd->ErrorCode : HAL_SD_ERROR_GENERAL_UNKNOWN_ERR;
+
+    /* release the task waiting for the completion of the failed transfer */
+    if (NULL != _active_semphr)
+    {
+        BaseType_t higher_priority_task_woken = pdFALSE;
+        xSemaphoreGiveFromISR(_active_semphr, &higher_priority_task_woken);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    }
+
     error_handler();
 }
 
+/**
+ * @brief SD Card D0 busy-end (rising edge) Callback
+ */
+static void sdio_busy_end_callback(void)
+{
+    /* the pending bit of the line is set by the data transfers on D0 as well,
+       the shared EXTI handler may call this without a busy wait in progress */
+    if (false == _busy_end_armed)
+    {
+        return;
+    }
+
+    _busy_end_armed = false;
+    sdcard_d0_pin_exti_disable();
+
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    xSemaphoreGiveFromISR(_busy_end_semphr, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
 /**
  * @brief SDIO Error Handler
  */
@@ -596,7 +1361,13 @@ static int sd_error_to_errno(const uint32_t error)
         case HAL_SD_ERROR_ERASE_RESET            : return -EFAULT;  /* not used by HAL */
     }
 
-    return (int)error;
+    /* more than one error flag is set */
+    if (0 != (error & (HAL_SD_ERROR_CMD_CRC_FAIL | HAL_SD_ERROR_DATA_CRC_FAIL)))
+    {
+        return -EBADMSG;
+    }
+
+    return -EIO;
 }
 
 /**
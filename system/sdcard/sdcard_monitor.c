@@ -46,6 +46,7 @@
 #include "vfs.h"
 
 #include "mtd.h"
+#include "mtd_cache.h"
 #include "mtd_sdcard.h"
 
 #define SDCARD_MOUNT_PATH  "/sd"
@@ -57,6 +58,7 @@ static vfs_mount_t _fatfs_sdcard_vfs_mount = {
     .private_data = (void *)&_fatfs_desc,
 };
 static mtd_sdcard_t mtd_sdcard;
+static mtd_cache_t mtd_cache = MTD_CACHE_INIT(&mtd_sdcard.base);
 
 static StackType_t _sdcard_monitor_task_stack[SDCARD_MONITOR_TASK_STACKSIZE];
 static StaticTask_t _sdcard_monitor_task_tcb;
@@ -221,7 +223,7 @@ static int sdcard_mount(void)
     int err;
 
     mtd_sdcard.base.driver = &mtd_sdcard_driver;
-    _fatfs_desc.dev = (mtd_dev_t *)&mtd_sdcard;
+    _fatfs_desc.dev = (mtd_dev_t *)&mtd_cache;
 
     err = vfs_mount(&_fatfs_sdcard_vfs_mount);
     printf("\r\n  sdcard_mount : %s\r\n", strerror(-err));
@@ -246,6 +248,16 @@ static int sdcard_unmount(void)
         return err;
     }
 
+    /* the card has been removed, its dirty lines must not be written to the
+       next one */
+    mtd_cache_discard(&mtd_cache);
+
+    err = mtd_cache_deinit(&mtd_cache);
+    if (err < 0)
+    {
+        printf("\r\n  sdcard_unmount : cache flush failed : %s\r\n", strerror(-err));
+    }
+
     err = sdcard_deinit();
     if (err < 0)
     {
@@ -253,6 +265,7 @@ static int sdcard_unmount(void)
     }
 
     vPortFree(mtd_sdcard.base.work_area);
+    mtd_sdcard.base.work_area = NULL;
 
     mtd_sdcard.base.driver = NULL;
     _fatfs_desc.dev = NULL;
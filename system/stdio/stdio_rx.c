@@ -0,0 +1,607 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     system_stdio
+ * @{
+ *
+ * @file        stdio_rx.c
+ * @brief       Receive ring shared by the stdin listeners and stdio_read()
+ * @}
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "stdio_base.h"
+#include "stdio_rx.h"
+#include "stdio_rx_config.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#define RING_MASK   (STDIO_RX_RING_SIZE - 1ul)
+
+static_assert((STDIO_RX_RING_SIZE & RING_MASK) == 0ul,
+              "STDIO_RX_RING_SIZE must be a power of two");
+
+/*
+ * _head counts the bytes written to the ring, the listener cursors count
+ * the bytes read by the listeners. All of them are free running, the ring
+ * index of a byte is its counter value masked with RING_MASK.
+ */
+static uint8_t _ring[STDIO_RX_RING_SIZE];
+static uint32_t _head = 0ul;
+static stdio_rx_listener_t *_listeners = NULL;
+
+static SemaphoreHandle_t _ring_mutex = NULL;
+static StaticSemaphore_t _ring_mutex_storage;
+
+static SemaphoreHandle_t _space_semphr = NULL;
+static StaticSemaphore_t _space_semphr_storage;
+
+static SemaphoreHandle_t _stdin_mutex = NULL;
+static StaticSemaphore_t _stdin_mutex_storage;
+
+static stdio_rx_listener_t _stdin_listener;
+static bool _stdin_nonblock = false;
+static uint8_t _stdin_vmin = STDIO_RX_VMIN;
+static uint8_t _stdin_vtime = STDIO_RX_VTIME;
+
+static uint32_t listener_cursor(const stdio_rx_listener_t *listener);
+static void listener_normalize(stdio_rx_listener_t *listener);
+static void listener_drop_oldest(stdio_rx_listener_t *listener);
+static void listeners_notify(void);
+static size_t stdin_wait(uint8_t *buf, size_t len, size_t max_len);
+static void stdin_claim(void);
+static void stdin_release(void);
+static inline void ring_lock(void);
+static inline void ring_unlock(void);
+static inline void stdin_lock(void);
+static inline void stdin_unlock(void);
+
+void stdio_rx_init(void)
+{
+    _head = 0ul;
+    _listeners = NULL;
+    _stdin_listener.task = NULL;
+    _stdin_nonblock = false;
+
+    _ring_mutex = xSemaphoreCreateMutexStatic(&_ring_mutex_storage);
+    _space_semphr = xSemaphoreCreateBinaryStatic(&_space_semphr_storage);
+    _stdin_mutex = xSemaphoreCreateMutexStatic(&_stdin_mutex_storage);
+}
+
+void stdio_rx_deinit(void)
+{
+    vSemaphoreDelete(_ring_mutex);
+    vSemaphoreDelete(_space_semphr);
+    vSemaphoreDelete(_stdin_mutex);
+
+    _ring_mutex = NULL;
+    _space_semphr = NULL;
+    _stdin_mutex = NULL;
+    _listeners = NULL;
+}
+
+void stdio_rx_write(const uint8_t *data, size_t len)
+{
+    ring_lock();
+
+    while (len)
+    {
+        uint32_t space = STDIO_RX_RING_SIZE;
+
+        for (const stdio_rx_listener_t *l = _listeners; NULL != l; l = l->next)
+        {
+            if (STDIO_RX_BLOCK == l->overflow)
+            {
+                const uint32_t room = STDIO_RX_RING_SIZE - (_head - listener_cursor(l));
+                if (room < space)
+                {
+                    space = room;
+                }
+            }
+        }
+
+        if (0ul == space)
+        {
+            listeners_notify();
+            ring_unlock();
+            xSemaphoreTake(_space_semphr, portMAX_DELAY);
+            ring_lock();
+            continue;
+        }
+
+        const uint32_t offset = _head & RING_MASK;
+        if (space > STDIO_RX_RING_SIZE - offset)
+        {
+            space = STDIO_RX_RING_SIZE - offset;
+        }
+
+        const uint32_t chunk = (len < space) ? (uint32_t)len : space;
+        memcpy(&_ring[offset], data, chunk);
+        _head += chunk;
+
+        for (stdio_rx_listener_t *l = _listeners; NULL != l; l = l->next)
+        {
+            if (STDIO_RX_DROP_OLDEST == l->overflow)
+            {
+                listener_drop_oldest(l);
+            }
+        }
+
+        data += chunk;
+        len -= chunk;
+    }
+
+    listeners_notify();
+    ring_unlock();
+}
+
+int stdio_rx_listener_add(stdio_rx_listener_t *listener, TaskHandle_t task,
+                          UBaseType_t notify_index, stdio_rx_overflow_t overflow)
+{
+    ring_lock();
+
+    for (const stdio_rx_listener_t *l = _listeners; NULL != l; l = l->next)
+    {
+        if (l == listener)
+        {
+            ring_unlock();
+            return -EALREADY;
+        }
+    }
+
+    const bool stdin_claimed = (NULL != _stdin_listener.task);
+
+    listener->task = task;
+    listener->notify_index = notify_index;
+    listener->overflow = overflow;
+    listener->dropped = 0ul;
+    listener->cursor = _head;
+    listener->skip_start = _head;
+    listener->skip_end = _head;
+    listener->skip = stdin_claimed;
+    listener->skip_open = stdin_claimed;
+
+    listener->next = _listeners;
+    _listeners = listener;
+
+    ring_unlock();
+
+    return 0;
+}
+
+void stdio_rx_listener_remove(stdio_rx_listener_t *listener)
+{
+    ring_lock();
+
+    for (stdio_rx_listener_t **pp = &_listeners; NULL != *pp; pp = &(*pp)->next)
+    {
+        if (*pp == listener)
+        {
+            *pp = listener->next;
+            listener->next = NULL;
+            break;
+        }
+    }
+
+    ring_unlock();
+
+    /* the backend may wait for this listener */
+    xSemaphoreGive(_space_semphr);
+}
+
+size_t stdio_rx_listener_read(stdio_rx_listener_t *listener, void *buffer, size_t max_len)
+{
+    uint8_t *buf = buffer;
+    size_t len = 0;
+
+    ring_lock();
+
+    while (len < max_len)
+    {
+        listener_normalize(listener);
+
+        const uint32_t end = listener->skip ? listener->skip_start : _head;
+        const uint32_t offset = listener->cursor & RING_MASK;
+        uint32_t span = end - listener->cursor;
+
+        if (0ul == span)
+        {
+            break;
+        }
+
+        if (span > STDIO_RX_RING_SIZE - offset)
+        {
+            span = STDIO_RX_RING_SIZE - offset;
+        }
+
+        if (span > max_len - len)
+        {
+            span = max_len - len;
+        }
+
+        memcpy(&buf[len], &_ring[offset], span);
+        listener->cursor += span;
+        len += span;
+    }
+
+    ring_unlock();
+
+    if (len)
+    {
+        xSemaphoreGive(_space_semphr);
+    }
+
+    return len;
+}
+
+ssize_t stdio_read(void *buffer, size_t max_len)
+{
+    return stdio_rx_read(buffer, max_len, false);
+}
+
+ssize_t stdio_rx_read(void *buffer, size_t max_len, bool nonblock)
+{
+    ssize_t ret;
+
+    if (nonblock)
+    {
+        if (pdTRUE != xSemaphoreTake(_stdin_mutex, 0))
+        {
+            return -EAGAIN;
+        }
+    }
+    else
+    {
+        stdin_lock();
+    }
+
+    stdin_claim();
+
+    size_t len = stdio_rx_listener_read(&_stdin_listener, buffer, max_len);
+
+    if (nonblock)
+    {
+        ret = ((0 != len) || (0 == max_len)) ? (ssize_t)len : -EAGAIN;
+    }
+    else
+    {
+        ret = (ssize_t)stdin_wait(buffer, len, max_len);
+    }
+
+    if (!_stdin_nonblock)
+    {
+        stdin_release();
+    }
+
+    stdin_unlock();
+
+    return ret;
+}
+
+void stdio_rx_set_nonblock(bool nonblock)
+{
+    stdin_lock();
+
+    if (nonblock != _stdin_nonblock)
+    {
+        _stdin_nonblock = nonblock;
+
+        if (nonblock)
+        {
+            stdin_claim();
+        }
+        else
+        {
+            stdin_release();
+        }
+    }
+
+    stdin_unlock();
+}
+
+void stdio_rx_set_timing(uint8_t vmin, uint8_t vtime)
+{
+    taskENTER_CRITICAL();
+    _stdin_vmin = vmin;
+    _stdin_vtime = vtime;
+    taskEXIT_CRITICAL();
+}
+
+void stdio_rx_get_timing(uint8_t *vmin, uint8_t *vtime)
+{
+    taskENTER_CRITICAL();
+    *vmin = _stdin_vmin;
+    *vtime = _stdin_vtime;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief  Waits for the bytes of stdio_read() as set by the VMIN and VTIME
+ *         values
+ *
+ * @param  buf     buffer to read into
+ * @param  len     number of bytes already read into the buffer
+ * @param  max_len size of the buffer
+ *
+ * @return number of bytes read into the buffer
+ */
+static size_t stdin_wait(uint8_t *buf, size_t len, size_t max_len)
+{
+    uint8_t vmin;
+    uint8_t vtime;
+    stdio_rx_get_timing(&vmin, &vtime);
+
+    const TickType_t timeout = (0 == vtime) ? portMAX_DELAY : pdMS_TO_TICKS(100ul * vtime);
+
+    if (0 == vmin)
+    {
+        /* the timer runs from the start of the read */
+        TimeOut_t time_out;
+        TickType_t ticks_to_wait = timeout;
+        vTaskSetTimeOutState(&time_out);
+
+        while ((0 == len) && (0 != vtime) && (0 != max_len) &&
+               (pdFALSE == xTaskCheckForTimeOut(&time_out, &ticks_to_wait)))
+        {
+            ulTaskNotifyTakeIndexed(STDIO_RX_NOTIFY_INDEX, pdTRUE, ticks_to_wait);
+            len += stdio_rx_listener_read(&_stdin_listener, &buf[len], max_len - len);
+        }
+
+        return len;
+    }
+
+    const size_t min_len = (vmin < max_len) ? vmin : max_len;
+
+    while (len < min_len)
+    {
+        /* the first byte is waited for without limit, VTIME is an inter-byte timeout */
+        const TickType_t ticks_to_wait = (0 == len) ? portMAX_DELAY : timeout;
+
+        if (0ul == ulTaskNotifyTakeIndexed(STDIO_RX_NOTIFY_INDEX, pdTRUE, ticks_to_wait))
+        {
+            break;
+        }
+
+        len += stdio_rx_listener_read(&_stdin_listener, &buf[len], max_len - len);
+    }
+
+    return len;
+}
+
+/**
+ * @brief  Returns the ring position from which a listener still needs the bytes
+ *
+ * @note   A listener waiting at the start of the open stdio_read() range needs
+ *         nothing, so it does not block the writer and is not dropped from
+ */
+static uint32_t listener_cursor(const stdio_rx_listener_t *listener)
+{
+    if (listener->skip && (listener->cursor == listener->skip_start))
+    {
+        return listener->skip_open ? _head : listener->skip_end;
+    }
+
+    return listener->cursor;
+}
+
+/**
+ * @brief  Moves the cursor of a listener over the closed stdio_read() range
+ *         once all bytes before it have been read
+ */
+static void listener_normalize(stdio_rx_listener_t *listener)
+{
+    if (listener->skip && !listener->skip_open && (listener->cursor == listener->skip_start))
+    {
+        listener->cursor = listener->skip_end;
+        listener->skip = false;
+    }
+}
+
+/**
+ * @brief  Drops the bytes of a listener that have been overwritten by the
+ *         last write to the ring
+ */
+static void listener_drop_oldest(stdio_rx_listener_t *listener)
+{
+    listener_normalize(listener);
+
+    if ((_head - listener_cursor(listener)) <= STDIO_RX_RING_SIZE)
+    {
+        return;
+    }
+
+    const uint32_t oldest = _head - STDIO_RX_RING_SIZE;
+
+    if (listener->skip)
+    {
+        if ((_head - listener->skip_start) < STDIO_RX_RING_SIZE)
+        {
+            listener->dropped += oldest - listener->cursor;
+            listener->cursor = oldest;
+            return;
+        }
+
+        /* every byte before the skipped range is lost */
+        listener->dropped += listener->skip_start - listener->cursor;
+        listener->cursor = listener->skip_start;
+
+        if (listener->skip_open)
+        {
+            return;
+        }
+
+        listener->cursor = listener->skip_end;
+        listener->skip = false;
+
+        if ((_head - listener->cursor) <= STDIO_RX_RING_SIZE)
+        {
+            return;
+        }
+    }
+
+    listener->dropped += oldest - listener->cursor;
+    listener->cursor = oldest;
+}
+
+/**
+ * @brief  Notifies the listeners that have unread bytes
+ */
+static void listeners_notify(void)
+{
+    for (const stdio_rx_listener_t *l = _listeners; NULL != l; l = l->next)
+    {
+        if ((listener_cursor(l) != _head) && (NULL != l->task))
+        {
+            xTaskNotifyGiveIndexed(l->task, l->notify_index);
+        }
+    }
+}
+
+/**
+ * @brief  Passes the bytes received from now on to the stdin readers only
+ *
+ * Every listener gets an open range starting at the current head, which it
+ * skips once the stdin is released. A listener which has not yet reached the
+ * range of the previous claim loses its bytes before that range. If the
+ * stdin is already claimed only the task to notify is updated.
+ */
+static void stdin_claim(void)
+{
+    ring_lock();
+
+    if (NULL == _stdin_listener.task)
+    {
+        for (stdio_rx_listener_t *l = _listeners; NULL != l; l = l->next)
+        {
+            listener_normalize(l);
+
+            if (l->skip)
+            {
+                l->dropped += l->skip_start - l->cursor;
+                l->cursor = l->skip_end;
+            }
+
+            l->skip = true;
+            l->skip_open = true;
+            l->skip_start = _head;
+        }
+
+        _stdin_listener.notify_index = STDIO_RX_NOTIFY_INDEX;
+        _stdin_listener.overflow = STDIO_RX_DROP_OLDEST;
+        _stdin_listener.dropped = 0ul;
+        _stdin_listener.cursor = _head;
+        _stdin_listener.skip = false;
+        _stdin_listener.skip_open = false;
+
+        _stdin_listener.next = _listeners;
+        _listeners = &_stdin_listener;
+    }
+
+    _stdin_listener.task = xTaskGetCurrentTaskHandle();
+
+    ring_unlock();
+
+    xTaskNotifyStateClearIndexed(NULL, STDIO_RX_NOTIFY_INDEX);
+    ulTaskNotifyValueClearIndexed(NULL, STDIO_RX_NOTIFY_INDEX, UINT32_MAX);
+}
+
+/**
+ * @brief  Gives the received bytes back to the listeners
+ *
+ * The bytes left unread by the stdin readers are not skipped by the listeners.
+ */
+static void stdin_release(void)
+{
+    ring_lock();
+
+    for (stdio_rx_listener_t **pp = &_listeners; NULL != *pp; pp = &(*pp)->next)
+    {
+        if (*pp == &_stdin_listener)
+        {
+            *pp = _stdin_listener.next;
+            break;
+        }
+    }
+
+    _stdin_listener.next = NULL;
+    _stdin_listener.task = NULL;
+
+    for (stdio_rx_listener_t *l = _listeners; NULL != l; l = l->next)
+    {
+        if (l->skip && l->skip_open)
+        {
+            /* the range is empty for a listener added after the last byte read */
+            const bool unread = ((int32_t)(_stdin_listener.cursor - l->skip_start) > 0);
+
+            l->skip_open = false;
+            l->skip_end = unread ? _stdin_listener.cursor : l->skip_start;
+            listener_normalize(l);
+        }
+    }
+
+    listeners_notify();
+    ring_unlock();
+
+    xTaskNotifyStateClearIndexed(NULL, STDIO_RX_NOTIFY_INDEX);
+    ulTaskNotifyValueClearIndexed(NULL, STDIO_RX_NOTIFY_INDEX, UINT32_MAX);
+
+    xSemaphoreGive(_space_semphr);
+}
+
+/**
+ * @brief  Locks the ring mutex
+ */
+static inline void ring_lock(void)
+{
+    xSemaphoreTake(_ring_mutex, portMAX_DELAY);
+}
+
+/**
+ * @brief  Unlocks the ring mutex
+ */
+static inline void ring_unlock(void)
+{
+    xSemaphoreGive(_ring_mutex);
+}
+
+/**
+ * @brief  Locks the stdin mutex
+ */
+static inline void stdin_lock(void)
+{
+    xSemaphoreTake(_stdin_mutex, portMAX_DELAY);
+}
+
+/**
+ * @brief  Unlocks the stdin mutex
+ */
+static inline void stdin_unlock(void)
+{
+    xSemaphoreGive(_stdin_mutex);
+}
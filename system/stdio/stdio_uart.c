@@ -32,10 +32,13 @@
  * @}
  */
 
+#include <assert.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <string.h>
 
 #include "stdio_base.h"
+#include "stdio_rx.h"
 #include "stdio_uart_config.h"
 #include "stm32f4xx_hal.h"
 #include "hal_errno.h"
@@ -46,29 +49,30 @@
 
 #include "FreeRTOS.h"
 #include "task.h"
-#include "queue.h"
 #include "semphr.h"
 
-typedef struct
-{
-    uint8_t *pbuf;
-    uint16_t size;
-} uart_tx_data_t;
+#define TX_RING_MASK    (STDIO_UART_TX_RING_SIZE - 1ul)
+
+static_assert((STDIO_UART_TX_RING_SIZE & TX_RING_MASK) == 0ul,
+              "STDIO_UART_TX_RING_SIZE must be a power of two");
+static_assert(STDIO_UART_TX_RING_SIZE <= 32768ul,
+              "STDIO_UART_TX_RING_SIZE exceeds the DMA transfer length");
+
+#define RX_BUFFER_MASK  (STDIO_UART_RX_DMA_BUFFER_SIZE - 1ul)
+
+static_assert((STDIO_UART_RX_DMA_BUFFER_SIZE & RX_BUFFER_MASK) == 0ul,
+              "STDIO_UART_RX_DMA_BUFFER_SIZE must be a power of two");
+static_assert(STDIO_UART_RX_DMA_BUFFER_SIZE <= 32768ul,
+              "STDIO_UART_RX_DMA_BUFFER_SIZE exceeds the DMA transfer length");
 
 static SemaphoreHandle_t _tx_cplt_semphr = NULL;
 static StaticSemaphore_t _tx_cplt_semphr_storage;
 
-static StaticQueue_t _rx_queue_struct;
-static uint8_t _rx_queue_storage[STDIO_UART_RX_QUEUE_LENGTH * sizeof(uint8_t)];
-static QueueHandle_t _rx_queue = NULL;
+static SemaphoreHandle_t _tx_space_semphr = NULL;
+static StaticSemaphore_t _tx_space_semphr_storage;
 
-static StaticQueue_t _tx_avail_queue_struct;
-static uint8_t _tx_avail_queue_storage[STDIO_UART_TX_AVAIL_QUEUE_LENGTH * sizeof(uint8_t *)];
-static QueueHandle_t _tx_avail_queue = NULL;
-
-static StaticQueue_t _tx_ready_queue_struct;
-static uint8_t _tx_ready_queue_storage[STDIO_UART_TX_READY_QUEUE_LENGTH * sizeof(uart_tx_data_t)];
-static QueueHandle_t _tx_ready_queue = NULL;
+static SemaphoreHandle_t _tx_mutex = NULL;
+static StaticSemaphore_t _tx_mutex_storage;
 
 static StackType_t _write_task_stack[STDIO_UART_WRITE_TASK_STACKSIZE];
 static StaticTask_t _write_task_tcb;
@@ -78,25 +82,34 @@ static StackType_t _read_task_stack[STDIO_UART_READ_TASK_STACKSIZE];
 static StaticTask_t _read_task_tcb;
 static TaskHandle_t h_read_task = NULL;
 
-static SemaphoreHandle_t _stdin_mutex = NULL;
-static StaticSemaphore_t _stdin_mutex_storage;
+static UART_HandleTypeDef h_stdio_uart;
 
-static StaticQueue_t _stdin_queue_struct;
-static uint8_t _stdin_queue_storage[STDIO_UART_STDIN_QUEUE_LENGTH * sizeof(uint8_t)];
-static QueueHandle_t _stdin_queue = NULL;
+/*
+ * The head is only advanced by the writers (serialized by _tx_mutex) and the
+ * tail only by the write task, both are free running and wrap at 2^32.
+ */
+static uint8_t _tx_ring[STDIO_UART_TX_RING_SIZE];
+static volatile uint32_t _tx_head = 0ul;
+static volatile uint32_t _tx_tail = 0ul;
 
-static UART_HandleTypeDef h_stdio_uart;
+/*
+ * The DMA fills the Rx buffer continuously. _rx_received counts the bytes
+ * written by the DMA as reported by the Rx events, _rx_consumed the bytes
+ * forwarded by the read task. Both are free running, the buffer index of a
+ * byte is its counter value masked with RX_BUFFER_MASK.
+ */
+static uint8_t _rx_buffer[STDIO_UART_RX_DMA_BUFFER_SIZE];
+static volatile uint32_t _rx_received = 0ul;
+static uint32_t _rx_consumed = 0ul;
+static uint16_t _rx_dma_pos = 0u;
+static volatile bool _rx_restart = false;
 
-static uint8_t _tx_buffer[STDIO_UART_TX_BUFFER_DEPTH * STDIO_UART_TX_AVAIL_QUEUE_LENGTH];
-static uint8_t _rx_buffer;
+static stdio_stats_t _stats;
 
-static const TickType_t dma_tx_max_time_ms = (TickType_t)((1000.0f * (((float)(10 * STDIO_UART_TX_BUFFER_DEPTH)) / 115200.0f)) + 0.5f);
+static const TickType_t dma_tx_max_time_ms = (TickType_t)((1000.0f * (((float)(10 * STDIO_UART_TX_RING_SIZE)) / 115200.0f)) + 0.5f);
 
 static HAL_StatusTypeDef _error = HAL_OK;
 
-static QueueHandle_t _stdin_listeners_list[STDIO_UART_MAX_NUM_OF_STDIN_LISTENERS];
-static uint32_t _stdin_listeners = 0ul;
-
 static void uart_rtos_init(void);
 static void uart_rtos_deinit(void);
 static int uart_periph_init(void);
@@ -104,15 +117,16 @@ static int uart_periph_deinit(void);
 static void uart_msp_init(UART_HandleTypeDef *huart);
 static void uart_msp_deinit(UART_HandleTypeDef *huart);
 static void uart_tx_cplt_callback(UART_HandleTypeDef *huart);
-static void uart_rx_cplt_callback(UART_HandleTypeDef *huart);
+static void uart_rx_event_callback(UART_HandleTypeDef *huart, uint16_t pos);
 static void uart_error_callback(UART_HandleTypeDef *huart);
 static void error_handler(void);
 
 static int uart_write(const uint8_t *data, size_t len);
 static void uart_write_task(void *params);
 static void uart_read_task(void *params);
-static inline void stdin_lock(void);
-static inline void stdin_unlock(void);
+static void uart_rx_start(void);
+static inline void tx_lock(void);
+static inline void tx_unlock(void);
 
 void stdio_init(void)
 {
@@ -126,44 +140,26 @@ void stdio_deinit(void)
     uart_periph_deinit();
 }
 
-int stdio_add_stdin_listener(const QueueHandle_t hqueue)
+void stdio_stats_get(stdio_stats_t *stats)
 {
-    int ret;
-
-    if (_stdin_listeners < STDIO_UART_MAX_NUM_OF_STDIN_LISTENERS)
-    {
-        _stdin_listeners_list[_stdin_listeners] = hqueue;
-        _stdin_listeners++;
-        ret = 0;
-    }
-    else
-    {
-        ret = -ENOMEM;
-    }
-
-    return ret;
+    taskENTER_CRITICAL();
+    *stats = _stats;
+    taskEXIT_CRITICAL();
 }
 
-ssize_t stdio_read(void *buffer, size_t max_len)
+void stdio_stats_reset(void)
 {
-    uint8_t *buf = buffer;
-
-    stdin_lock();
-
-    for (size_t i = 0; i < max_len; i++)
-    {
-        xQueueReceive(_stdin_queue, &buf[i], portMAX_DELAY);
-    }
-
-    stdin_unlock();
-
-    return max_len;
+    taskENTER_CRITICAL();
+    memset(&_stats, 0, sizeof(_stats));
+    taskEXIT_CRITICAL();
 }
 
 ssize_t stdio_write(const void *buffer, size_t len)
 {
     ssize_t result = len;
 
+    tx_lock();
+
     if (IS_USED(MODULE_STDIO_UART_ONLCR))
     {
         static const uint8_t crlf[2] = { (uint8_t)'\r', (uint8_t)'\n' };
@@ -178,7 +174,8 @@ ssize_t stdio_write(const void *buffer, size_t len)
             int ret = uart_write(buf, chunk_len);
             if (ret < 0)
             {
-                return ret;
+                result = ret;
+                break;
             }
 
             buf += chunk_len;
@@ -189,7 +186,8 @@ ssize_t stdio_write(const void *buffer, size_t len)
                 ret = uart_write(crlf, sizeof(crlf));
                 if (ret < 0)
                 {
-                    return ret;
+                    result = ret;
+                    break;
                 }
 
                 buf++;
@@ -202,19 +200,24 @@ ssize_t stdio_write(const void *buffer, size_t len)
         int ret = uart_write((const uint8_t *)buffer, len);
         if (ret < 0)
         {
-            return ret;
+            result = ret;
         }
     }
+
+    tx_unlock();
+
     return result;
 }
 
 /**
  * @brief UART write (gate-keeper) task.
  *
- * This task is responsible for transmitting data over UART using DMA.
- * It waits for data to be available in the transmission ready queue, then
- * transmits it using DMA. Once the transmission is complete, it signals
- * the availability of the buffer back to the transmission available queue.
+ * This task is responsible for transmitting the content of the Tx ring over
+ * UART using DMA. Each transfer covers the largest contiguous span of the
+ * pending bytes, so everything written while a transfer is in progress goes
+ * out with the next one. When the line is idle and only a few bytes are
+ * pending (e.g. a CLI echo) the task waits a short time for more data before
+ * starting the transfer.
  *
  * @param params Pointer to task parameters (not used).
  */
@@ -223,38 +226,69 @@ static void uart_write_task(void *params)
     (void)params;
 
     HAL_StatusTypeDef hal_status;
-    uint8_t *_tx_pending = NULL;
-
-    uart_tx_data_t uart_tx_data = {
-        .pbuf = NULL,
-        .size = 0,
-    };
+    bool line_idle = true;
 
     const TickType_t ticks_to_wait = pdMS_TO_TICKS(2ul * dma_tx_max_time_ms);
+    const TickType_t flush_timeout = pdMS_TO_TICKS(STDIO_UART_TX_FLUSH_TIMEOUT_MS);
 
     for ( ;; )
     {
-        xQueueReceive(_tx_ready_queue, &uart_tx_data, portMAX_DELAY);
+        uint32_t pending = _tx_head - _tx_tail;
 
-        hal_status = HAL_UART_Transmit_DMA(&h_stdio_uart, uart_tx_data.pbuf, uart_tx_data.size);
+        if (0ul == pending)
+        {
+            line_idle = true;
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        if (line_idle)
+        {
+            const TickType_t start = xTaskGetTickCount();
+
+            while (pending < STDIO_UART_TX_FLUSH_THRESHOLD)
+            {
+                const TickType_t elapsed = xTaskGetTickCount() - start;
+                if ((elapsed >= flush_timeout) ||
+                    (0ul == ulTaskNotifyTake(pdTRUE, flush_timeout - elapsed)))
+                {
+                    break;
+                }
+
+                pending = _tx_head - _tx_tail;
+            }
+        }
+
+        const uint32_t offset = _tx_tail & TX_RING_MASK;
+        uint32_t span = STDIO_UART_TX_RING_SIZE - offset;
+        if (span > pending)
+        {
+            span = pending;
+        }
+
+        hal_status = HAL_UART_Transmit_DMA(&h_stdio_uart, &_tx_ring[offset], (uint16_t)span);
         if (HAL_OK != hal_status)
         {
             error_handler();
         }
 
-        _tx_pending = uart_tx_data.pbuf;
+        line_idle = false;
 
         xSemaphoreTake(_tx_cplt_semphr, ticks_to_wait);
-        xQueueSend(_tx_avail_queue, &_tx_pending, 0);
+
+        _tx_tail += span;
+        xSemaphoreGive(_tx_space_semphr);
     }
 }
 
 /**
  * @brief UART read task.
  *
- * This task is responsible for receiving data from UART using interrupt-driven mode.
- * It waits for data to be received, and forwards it to the appropriate queue
- * based on whether it's intended for the application or for stdin listeners.
+ * This task is responsible for forwarding the bytes received by the circular
+ * Rx DMA. It is woken up by the half transfer, transfer complete and idle
+ * line events and appends everything received since the previous wake-up to
+ * the stdin receive ring. Bytes overwritten by the DMA before they could be
+ * forwarded are counted as dropped.
  *
  * @param params Pointer to task parameters (not used).
  */
@@ -262,34 +296,69 @@ static void uart_read_task(void *params)
 {
     (void)params;
 
-    HAL_StatusTypeDef hal_status = HAL_UART_Receive_IT(&h_stdio_uart, &_rx_buffer, 1);
-    if (HAL_OK != hal_status)
-    {
-        error_handler();
-    }
+    uart_rx_start();
 
     for ( ;; )
     {
-        uint8_t rx_data;
-        xQueueReceive(_rx_queue, &rx_data, portMAX_DELAY);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-        hal_status = HAL_UART_Receive_IT(&h_stdio_uart, &_rx_buffer, 1);
-        if (HAL_OK != hal_status)
-        {
-            error_handler();
-        }
+        const uint32_t received = _rx_received;
+        uint32_t pending = received - _rx_consumed;
 
-        if (NULL != xSemaphoreGetMutexHolder(_stdin_mutex))
+        if (pending > STDIO_UART_RX_DMA_BUFFER_SIZE)
         {
-            xQueueSend(_stdin_queue, &rx_data, portMAX_DELAY);
+            taskENTER_CRITICAL();
+            _stats.rx_dropped += pending - STDIO_UART_RX_DMA_BUFFER_SIZE;
+            taskEXIT_CRITICAL();
+
+            _rx_consumed = received - STDIO_UART_RX_DMA_BUFFER_SIZE;
+            pending = STDIO_UART_RX_DMA_BUFFER_SIZE;
         }
-        else
+
+        while (pending)
         {
-            for (uint32_t i = 0; i < _stdin_listeners; i++)
+            const uint32_t offset = _rx_consumed & RX_BUFFER_MASK;
+            uint32_t span = STDIO_UART_RX_DMA_BUFFER_SIZE - offset;
+            if (span > pending)
             {
-                xQueueSend(_stdin_listeners_list[i], &rx_data, portMAX_DELAY);
+                span = pending;
             }
+
+            stdio_rx_write(&_rx_buffer[offset], span);
+
+            _rx_consumed += span;
+            pending -= span;
         }
+
+        if (_rx_restart)
+        {
+            _rx_restart = false;
+            uart_rx_start();
+        }
+    }
+}
+
+/**
+ * @brief Starts the circular DMA reception into the Rx buffer
+ *
+ * @note  The reception is started at the beginning of the buffer, so the
+ *        receive counters are moved to the next buffer boundary
+ */
+static void uart_rx_start(void)
+{
+    taskENTER_CRITICAL();
+    _rx_received = (_rx_received + RX_BUFFER_MASK) & ~RX_BUFFER_MASK;
+    _rx_dma_pos = 0u;
+    taskEXIT_CRITICAL();
+
+    _rx_consumed = _rx_received;
+
+    HAL_StatusTypeDef hal_status = HAL_UARTEx_ReceiveToIdle_DMA(&h_stdio_uart,
+                                                                _rx_buffer,
+                                                                STDIO_UART_RX_DMA_BUFFER_SIZE);
+    if (HAL_OK != hal_status)
+    {
+        error_handler();
     }
 }
 
@@ -297,43 +366,23 @@ static void uart_read_task(void *params)
  * @brief  Initializes the STDIO UART RTOS related objects
  *
  * @note   This function creates the UART reader / writer tasks and the
- *         corresponding queues, semaphores and mutexes
+ *         corresponding semaphores and mutexes
  * @note   stdio_uart_config.h contains necessary informations for
  *         task priority, task length, stack sizes, etc
  */
 static void uart_rtos_init(void)
 {
-    _stdin_listeners = 0ul;
+    stdio_rx_init();
 
-    _tx_cplt_semphr = xSemaphoreCreateBinaryStatic(&_tx_cplt_semphr_storage);
-
-    _tx_avail_queue = xQueueCreateStatic(STDIO_UART_TX_AVAIL_QUEUE_LENGTH,
-                                         sizeof(uint8_t *),
-                                         _tx_avail_queue_storage,
-                                         &_tx_avail_queue_struct);
-
-    _tx_ready_queue = xQueueCreateStatic(STDIO_UART_TX_READY_QUEUE_LENGTH,
-                                         sizeof(uart_tx_data_t),
-                                         _tx_ready_queue_storage,
-                                         &_tx_ready_queue_struct);
-
-    _rx_queue = xQueueCreateStatic(STDIO_UART_RX_QUEUE_LENGTH,
-                                   sizeof(uint8_t),
-                                   _rx_queue_storage,
-                                   &_rx_queue_struct);
+    _tx_head = 0ul;
+    _tx_tail = 0ul;
+    _rx_received = 0ul;
+    _rx_consumed = 0ul;
+    _rx_restart = false;
 
-    _stdin_mutex = xSemaphoreCreateMutexStatic(&_stdin_mutex_storage);
-
-    _stdin_queue = xQueueCreateStatic(STDIO_UART_STDIN_QUEUE_LENGTH,
-                                      sizeof(uint8_t),
-                                      _stdin_queue_storage,
-                                      &_stdin_queue_struct);
-
-    for (uint8_t i = 0; i < STDIO_UART_TX_AVAIL_QUEUE_LENGTH; i++)
-    {
-        uint8_t *buffer_address = &_tx_buffer[i * STDIO_UART_TX_BUFFER_DEPTH];
-        xQueueSend(_tx_avail_queue, &buffer_address, 0);
-    }
+    _tx_cplt_semphr = xSemaphoreCreateBinaryStatic(&_tx_cplt_semphr_storage);
+    _tx_space_semphr = xSemaphoreCreateBinaryStatic(&_tx_space_semphr_storage);
+    _tx_mutex = xSemaphoreCreateMutexStatic(&_tx_mutex_storage);
 
     h_write_task = xTaskCreateStatic(uart_write_task,
                                      "STDIO UART Write",
@@ -405,7 +454,7 @@ static int uart_periph_init(void)
         return hal_statustypedef_to_errno(ret);
     }
 
-    ret = HAL_UART_RegisterCallback(&h_stdio_uart, HAL_UART_RX_COMPLETE_CB_ID, uart_rx_cplt_callback);
+    ret = HAL_UART_RegisterRxEventCallback(&h_stdio_uart, uart_rx_event_callback);
     if (HAL_OK != ret)
     {
         return hal_statustypedef_to_errno(ret);
@@ -424,27 +473,23 @@ static int uart_periph_init(void)
  * @brief  De-initializes the STDIO UART RTOS related objects
  *
  * @note   This function deletes the UART reader / writer tasks and the
- *         corresponding queues, semaphores and mutexes
+ *         corresponding semaphores and mutexes
  */
 static void uart_rtos_deinit(void)
 {
     vTaskDelete(h_write_task);
     vTaskDelete(h_read_task);
-    vQueueDelete(_tx_avail_queue);
-    vQueueDelete(_tx_ready_queue);
-    vQueueDelete(_rx_queue);
-    vQueueDelete(_stdin_queue);
     vSemaphoreDelete(_tx_cplt_semphr);
-    vSemaphoreDelete(_stdin_mutex);
+    vSemaphoreDelete(_tx_space_semphr);
+    vSemaphoreDelete(_tx_mutex);
 
     h_write_task = NULL;
     h_read_task = NULL;
-    _tx_avail_queue = NULL;
-    _tx_ready_queue = NULL;
-    _rx_queue = NULL;
-    _stdin_queue = NULL;
     _tx_cplt_semphr = NULL;
-    _stdin_mutex = NULL;
+    _tx_space_semphr = NULL;
+    _tx_mutex = NULL;
+
+    stdio_rx_deinit();
 }
 
 /**
@@ -475,7 +520,7 @@ static int uart_periph_deinit(void)
         return hal_statustypedef_to_errno(ret);
     }
 
-    ret = HAL_UART_UnRegisterCallback(&h_stdio_uart, HAL_UART_RX_COMPLETE_CB_ID);
+    ret = HAL_UART_UnRegisterRxEventCallback(&h_stdio_uart);
     if (HAL_OK != ret)
     {
         return hal_statustypedef_to_errno(ret);
@@ -577,19 +622,30 @@ static void uart_tx_cplt_callback(UART_HandleTypeDef *huart)
 }
 
 /**
- * @brief UART Receive complete callback
+ * @brief UART Reception event callback
  *
  * @param huart pointer to a UART_HandleTypeDef structure that contains
  *        the configuration information for the stdio UART peripheral (unused).
+ * @param pos   position in the Rx buffer up to which the DMA has written
  *
- * @note  This function is called by the HAL library
- *        when a character is arrived.
+ * @note  This function is called by the HAL library on the half transfer
+ *        and transfer complete events of the Rx DMA and when the line
+ *        becomes idle after a received character.
  */
-static void uart_rx_cplt_callback(UART_HandleTypeDef *huart)
+static void uart_rx_event_callback(UART_HandleTypeDef *huart, uint16_t pos)
 {
     (void)huart;
     portBASE_TYPE higher_priority_task_woken = pdFALSE;
-    xQueueSendFromISR(_rx_queue, &_rx_buffer, &higher_priority_task_woken);
+
+    /* the transfer complete event reports the size of the buffer */
+    pos &= RX_BUFFER_MASK;
+
+    const uint32_t len = (uint32_t)(pos - _rx_dma_pos) & RX_BUFFER_MASK;
+    _rx_dma_pos = pos;
+    _rx_received += len;
+    _stats.rx_bytes += len;
+
+    vTaskNotifyGiveFromISR(h_read_task, &higher_priority_task_woken);
     portYIELD_FROM_ISR(higher_priority_task_woken);
 }
 
@@ -597,14 +653,40 @@ static void uart_rx_cplt_callback(UART_HandleTypeDef *huart)
  * @brief UART Error callback
  *
  * @param huart pointer to a UART_HandleTypeDef structure that contains
- *        the configuration information for the stdio UART peripheral (unused).
+ *        the configuration information for the stdio UART peripheral
  *
  * @note  This function is called when the UART peripheral generates an error interrupt
+ *        The HAL library aborts the DMA reception on overrun, framing, noise and
+ *        parity errors, these are counted and the read task restarts the reception
+ *        Any other error is handled by the error handler
  */
 static void uart_error_callback(UART_HandleTypeDef *huart)
 {
-    (void)huart;
-    error_handler();
+    const uint32_t error = HAL_UART_GetError(huart);
+
+    if (HAL_UART_ERROR_DMA & error)
+    {
+        error_handler();
+        return;
+    }
+
+    if (HAL_UART_ERROR_ORE & error)
+    {
+        _stats.rx_overruns++;
+    }
+
+    if ((HAL_UART_ERROR_FE | HAL_UART_ERROR_NE | HAL_UART_ERROR_PE) & error)
+    {
+        _stats.rx_errors++;
+    }
+
+    if (HAL_UART_STATE_READY == huart->RxState)
+    {
+        portBASE_TYPE higher_priority_task_woken = pdFALSE;
+        _rx_restart = true;
+        vTaskNotifyGiveFromISR(h_read_task, &higher_priority_task_woken);
+        portYIELD_FROM_ISR(higher_priority_task_woken);
+    }
 }
 
 /**
@@ -635,7 +717,7 @@ static void error_handler(void)
 }
 
 /**
- * @brief     Sends the formatted data over UART
+ * @brief     Appends the data to the Tx ring
  *
  * @param[in] data pointer to the data buffer
  * @param[in] len the size of the data in bytes
@@ -643,50 +725,62 @@ static void error_handler(void)
  * @return    0 on success
  * @return    < 0 on error
  *
- * @note      This function only sends the data to the tx ready queue
- *            If the queue is full than this function will block the caller task
+ * @note      The caller must hold the Tx mutex
+ * @note      This function only copies the data to the Tx ring and wakes up
+ *            the write task. If the ring is full then this function will block
+ *            the caller task until the write task frees up space
  */
 static int uart_write(const uint8_t *data, size_t len)
 {
     const TickType_t ticks_to_wait = pdMS_TO_TICKS(2ul * dma_tx_max_time_ms);
-    BaseType_t ret;
-    uart_tx_data_t tx_data = {
-        .pbuf = NULL,
-        .size = 0,
-    };
-
-    ret = xQueueReceive(_tx_avail_queue, &tx_data.pbuf, ticks_to_wait);
-    if (pdTRUE != ret)
+
+    while (len)
     {
-        return -ETIMEDOUT;
-    }
+        const uint32_t head = _tx_head;
+        uint32_t space = STDIO_UART_TX_RING_SIZE - (head - _tx_tail);
+
+        if (0ul == space)
+        {
+            if (pdTRUE != xSemaphoreTake(_tx_space_semphr, ticks_to_wait))
+            {
+                return -ETIMEDOUT;
+            }
+            continue;
+        }
 
-    memcpy(tx_data.pbuf, (uint8_t *)data, len);
-    tx_data.size = len;
+        const uint32_t offset = head & TX_RING_MASK;
+        if (space > STDIO_UART_TX_RING_SIZE - offset)
+        {
+            space = STDIO_UART_TX_RING_SIZE - offset;
+        }
 
-    ret = xQueueSend(_tx_ready_queue, &tx_data, ticks_to_wait);
-    if (pdTRUE != ret)
-    {
-        return -ETIMEDOUT;
+        const uint32_t chunk = (len < space) ? (uint32_t)len : space;
+        memcpy(&_tx_ring[offset], data, chunk);
+
+        _tx_head = head + chunk;
+        xTaskNotifyGive(h_write_task);
+
+        data += chunk;
+        len -= chunk;
     }
 
     return 0;
 }
 
 /**
- * @brief  Locks the stdin mutex
+ * @brief  Locks the Tx mutex
  */
-static inline void stdin_lock(void)
+static inline void tx_lock(void)
 {
-    xSemaphoreTake(_stdin_mutex, portMAX_DELAY);
+    xSemaphoreTake(_tx_mutex, portMAX_DELAY);
 }
 
 /**
- * @brief  Unlocks the stdin mutex
+ * @brief  Unlocks the Tx mutex
  */
-static inline void stdin_unlock(void)
+static inline void tx_unlock(void)
 {
-    xSemaphoreGive(_stdin_mutex);
+    xSemaphoreGive(_tx_mutex);
 }
 
 /**
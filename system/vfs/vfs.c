@@ -34,6 +34,7 @@
 #include "container.h"
 #include "modules.h"
 #include "vfs.h"
+#include "vfs_aio.h"
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
@@ -64,13 +65,36 @@ XFA_INIT(vfs_mount_t, vfs_mountpoints_xfa);
 
 /**
  * @internal
- * @brief Array of all currently open files
- *
- * This table maps POSIX fd numbers to vfs_file_t instances
+ * @brief Number of iolist snippets vfs_write_iol passes to vfs_writev at once
+ */
+#define VFS_WRITE_IOL_BATCH (8)
+
+/**
+ * @internal
+ * @brief Number of chunks in the table of open files
+ */
+#define VFS_FD_TABLE_CHUNKS ((VFS_MAX_OPEN_FILES + VFS_FD_TABLE_CHUNK - 1) / VFS_FD_TABLE_CHUNK)
+
+static_assert(VFS_FD_TABLE_CHUNK > STDERR_FILENO,
+              "the stdio file descriptors must fit into the first chunk");
+
+/**
+ * @internal
+ * @brief First chunk of the table of open files
  *
  * @attention STDIN, STDOUT, STDERR will use the three first items in this array.
  */
-static vfs_file_t _vfs_open_files[VFS_MAX_OPEN_FILES];
+static vfs_file_t _vfs_open_files_first[VFS_FD_TABLE_CHUNK];
+
+/**
+ * @internal
+ * @brief Table of all currently open files
+ *
+ * This table maps POSIX fd numbers to vfs_file_t instances, see _filp. The
+ * chunks after the first one are allocated by _allocate_fd when needed and
+ * are never freed, so an entry can be accessed without locking the table.
+ */
+static vfs_file_t *_vfs_open_files[VFS_FD_TABLE_CHUNKS] = { _vfs_open_files_first };
 
 /**
  * @internal
@@ -83,7 +107,114 @@ static clist_node_t _vfs_mounts_list;
 
 /**
  * @internal
- * @brief Find an unused entry in the _vfs_open_files array and mark it as used
+ * @brief Snapshot of the mounted file systems searched by path lookups
+ *
+ * The mounts of a published snapshot do not change, vfs_mount and vfs_umount
+ * fill the other snapshot and swap them. The readers counter tells the writer
+ * when the lookups that may still use a replaced snapshot are finished.
+ */
+typedef struct {
+    atomic_int readers;                     /**< Number of lookups using the snapshot */
+    unsigned numof;                         /**< Number of mounts */
+    vfs_mount_t *mounts[VFS_MAX_MOUNTS];    /**< Mounts, the longest mount point first */
+} vfs_mount_snapshot_t;
+
+/**
+ * @internal
+ * @brief Storage of the current and the previous mount snapshot
+ */
+static vfs_mount_snapshot_t _mount_snapshots[2];
+
+/**
+ * @internal
+ * @brief The mount snapshot used by new lookups
+ */
+static _Atomic(vfs_mount_snapshot_t *) _mount_snapshot = &_mount_snapshots[0];
+
+/**
+ * @internal
+ * @brief Cached status of a path
+ */
+typedef struct {
+    const vfs_mount_t *mp;                  /**< Mount of the path, NULL if the entry is unused */
+    unsigned gen;                           /**< Generation of the mount when the status was read */
+    uint32_t hash;                          /**< Hash of the mount and the path */
+    uint32_t last_use;                      /**< Value of _dcache_clock at the last use */
+    int res;                                /**< Result of stat, 0 or -ENOENT */
+    mode_t mode;                            /**< File mode */
+    off_t size;                             /**< File size */
+    struct timespec mtim;                   /**< Time of the last modification */
+    char path[VFS_DCACHE_PATH_MAX + 1];     /**< Absolute path */
+} vfs_dentry_t;
+
+/**
+ * @internal
+ * @brief Dentry cache
+ *
+ * An entry is valid while the dcache_gen counter of its mount is unchanged,
+ * the calls that modify a file system increment the counter of its mount. The
+ * entries of a whole mount are invalidated, because the short names and the
+ * case insensitivity of FAT allow many paths of the same file.
+ */
+static vfs_dentry_t _dcache[VFS_DCACHE_SETS][VFS_DCACHE_WAYS];
+static uint32_t _dcache_clock;
+static vfs_dcache_stats_t _dcache_stats;
+
+/**
+ * @internal
+ * @brief Contents of a pinned file, shared by its file cache entry and the
+ *        descriptors reading it
+ */
+typedef struct {
+    unsigned refs;                          /**< References of the entry and the open descriptors */
+    size_t size;                            /**< File size */
+    struct timespec mtim;                   /**< Time of the last modification */
+    uint8_t data[];                         /**< File contents */
+} vfs_fcache_blob_t;
+
+/**
+ * @internal
+ * @brief Pinned file
+ */
+typedef struct {
+    vfs_mount_t *mp;                        /**< Mount of the file, NULL if the entry is unused */
+    vfs_fcache_blob_t *blob;                /**< Contents, NULL if not loaded */
+    const char *rel_path;                   /**< Path relative to the mount, points into path */
+    uint64_t file_id;                       /**< vfs_file_t::file_id of the file when loaded */
+    uint32_t last_use;                      /**< Value of _fcache_clock at the last open */
+    unsigned pins;                          /**< Pin count */
+    char path[VFS_FCACHE_PATH_MAX + 1];     /**< Normalized absolute path */
+} vfs_fcache_entry_t;
+
+/**
+ * @internal
+ * @brief File cache, protected by _fcache_mutex
+ *
+ * A copy is dropped when the file it was read from is opened for writing,
+ * written, synced, and when a descriptor writing it is closed. It is not
+ * loaded while the file is open for writing. The file is recognized by
+ * vfs_file_t::file_id rather than by its path, since FAT reaches the same
+ * file with many paths. A rename or unlink may move the directory entry of
+ * another file, so it drops the copies of the whole mount.
+ */
+static vfs_fcache_entry_t _fcache[VFS_FCACHE_ENTRIES];
+static volatile unsigned _fcache_numof;     /* pinned files, read without the mutex */
+static uint32_t _fcache_clock;
+static vfs_fcache_stats_t _fcache_stats;
+
+/**
+ * @internal
+ * @brief Get the entry of an fd in the _vfs_open_files table
+ *
+ * @param[in]  fd  fd number, the chunk of the entry must be allocated
+ *
+ * @return pointer to the entry
+ */
+static inline vfs_file_t *_filp(int fd);
+
+/**
+ * @internal
+ * @brief Find an unused entry in the _vfs_open_files table and mark it as used
  *
  * If the @p fd argument is non-negative, the allocation fails if the
  * corresponding slot in the open files table is already occupied, no iteration
@@ -93,6 +224,9 @@ static clist_node_t _vfs_mounts_list;
  * open files table until it find an unused slot and return the number of that
  * slot.
  *
+ * The chunk of the slot is allocated if it was not used yet, the table only
+ * grows when all the entries of the allocated chunks are in use.
+ *
  * @param[in]  fd  Desired fd number, use VFS_ANY_FD for any free fd
  *
  * @return fd on success
@@ -102,7 +236,9 @@ static inline int _allocate_fd(int fd);
 
 /**
  * @internal
- * @brief Mark an allocated entry as unused in the _vfs_open_files array
+ * @brief Mark an allocated entry as unused in the _vfs_open_files table
+ *
+ * The private data of the file is returned to the file slab of its mount.
  *
  * @param[in]  fd     fd to free
  */
@@ -110,7 +246,7 @@ static inline void _free_fd(int fd);
 
 /**
  * @internal
- * @brief Initialize an entry in the _vfs_open_files array and mark it as used.
+ * @brief Initialize an entry in the _vfs_open_files table and mark it as used.
  *
  * @param[in]  fd           desired fd number, passed to _allocate_fd
  * @param[in]  f_op         pointer to file operations table
@@ -128,6 +264,8 @@ static inline int _init_fd(int fd, const vfs_file_ops_t *f_op, vfs_mount_t *moun
  * @brief Find the file system associated with the file name @p name, and
  * increment the open_files counter
  *
+ * The lookup does not lock, it searches the current mount snapshot.
+ *
  * A pointer to the vfs_mount_t associated with the found mount will be written to @p mountpp.
  * A pointer to the mount point-relative file name will be written to @p rel_path.
  *
@@ -151,10 +289,207 @@ static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const cha
  */
 static inline int _fd_is_valid(int fd);
 
+/**
+ * @internal
+ * @brief Get the current mount snapshot for a lookup, never blocks
+ *
+ * @return the snapshot, release it with _mount_snapshot_put
+ */
+static inline vfs_mount_snapshot_t *_mount_snapshot_get(void);
+
+/**
+ * @internal
+ * @brief Release a mount snapshot obtained with _mount_snapshot_get
+ *
+ * @param[in]  snap  snapshot to release
+ */
+static inline void _mount_snapshot_put(vfs_mount_snapshot_t *snap);
+
+/**
+ * @internal
+ * @brief Publish a new mount snapshot from the _vfs_mounts_list list
+ *
+ * Must be called with _mount_mutex held. When this returns no lookup uses
+ * the previous snapshot anymore, so the mounts left out can not be found
+ * and their open_files counter can only decrease.
+ *
+ * @param[in]  exclude  mount to leave out of the snapshot, may be NULL
+ */
+static void _mount_snapshot_publish(const vfs_mount_t *exclude);
+
+/**
+ * @internal
+ * @brief Check that the status of a path can be cached and compute its hash
+ *
+ * @param[in]  mountp  mount of the path
+ * @param[in]  path    absolute path
+ * @param[out] hash    hash of the mount and the path
+ *
+ * @return true if the file system allows caching and the path is normalized
+ *         and short enough
+ */
+static bool _dcache_key(const vfs_mount_t *mountp, const char *path, uint32_t *hash);
+
+/**
+ * @internal
+ * @brief Look up the cached status of a path
+ *
+ * @param[in]  mountp  mount of the path
+ * @param[in]  path    absolute path
+ * @param[in]  hash    hash from _dcache_key
+ * @param[in]  gen     current generation of the mount
+ * @param[out] buf     status of the file, only set on a positive hit
+ * @param[out] res     cached result of stat
+ *
+ * @return true on a hit
+ */
+static bool _dcache_lookup(const vfs_mount_t *mountp, const char *path, uint32_t hash,
+                           unsigned gen, struct stat *buf, int *res);
+
+/**
+ * @internal
+ * @brief Cache the status of a path
+ *
+ * Only successful and -ENOENT results are cached. The entry is stale right
+ * away if the mount was modified since @p gen was read.
+ *
+ * @param[in]  mountp  mount of the path
+ * @param[in]  path    absolute path
+ * @param[in]  hash    hash from _dcache_key
+ * @param[in]  gen     generation of the mount before the file system call
+ * @param[in]  res     result of stat
+ * @param[in]  buf     status of the file
+ */
+static void _dcache_insert(const vfs_mount_t *mountp, const char *path, uint32_t hash,
+                           unsigned gen, int res, const struct stat *buf);
+
+/**
+ * @internal
+ * @brief Invalidate the cached entries of a mount
+ *
+ * @param[in]  mountp  mount that is modified
+ */
+static inline void _dcache_invalidate(vfs_mount_t *mountp);
+
+/**
+ * @internal
+ * @brief Drop the entries of an unmounted file system, so that the cache
+ *        does not refer to its mount anymore
+ *
+ * @param[in]  mountp  mount that is unmounted
+ */
+static void _dcache_forget(const vfs_mount_t *mountp);
+
+/**
+ * @internal
+ * @brief Open a file with the driver of its mount
+ *
+ * The caller must have incremented the open_files count of the mount, it is
+ * decremented on failure.
+ *
+ * @param[in]  mountp    mount of the file
+ * @param[in]  rel_path  path relative to the mount
+ * @param[in]  flags     flags for opening
+ * @param[in]  mode      file mode
+ *
+ * @return fd number on success
+ * @return <0 on error
+ */
+static int _open_fs(vfs_mount_t *mountp, const char *rel_path, int flags, mode_t mode);
+
+/**
+ * @internal
+ * @brief Open a pinned file from the file cache
+ *
+ * @param[in]  mountp  mount of the file, its open_files count is taken over
+ *                     by the new descriptor
+ * @param[in]  path    absolute path
+ * @param[in]  flags   flags for opening, read-only
+ *
+ * @return fd number on success
+ * @return <0 if the file is not cached, or on error
+ */
+static int _fcache_open(vfs_mount_t *mountp, const char *path, int flags);
+
+/**
+ * @internal
+ * @brief Drop the cached copy of a file that is opened for writing
+ *
+ * @param[in]  mountp   mount of the file
+ * @param[in]  file_id  vfs_file_t::file_id of the file, 0 drops the copies
+ *                      of the whole mount
+ */
+static void _fcache_invalidate(const vfs_mount_t *mountp, uint64_t file_id);
+
+/**
+ * @internal
+ * @brief Drop the cached copy of the file written through @p filp
+ */
+static inline void _fcache_written(const vfs_file_t *filp)
+{
+    if ((filp->mp != NULL) && (_fcache_numof > 0)) {
+        _fcache_invalidate(filp->mp, filp->file_id);
+    }
+}
+
+/**
+ * @internal
+ * @brief Unpin the files of an unmounted file system
+ *
+ * @param[in]  mountp  mount that is unmounted
+ */
+static void _fcache_forget(const vfs_mount_t *mountp);
+
+/**
+ * @internal
+ * @brief Operations of the descriptors reading a file from the file cache
+ */
+static const vfs_file_ops_t _fcache_file_ops;
+
+/**
+ * @internal
+ * @brief Initialize a file slab, its memory is allocated on demand
+ *
+ * @param[out] slab      slab to initialize
+ * @param[in]  obj_size  size of an object
+ * @param[in]  numof     maximum number of objects
+ */
+static void _slab_init(vfs_slab_t *slab, size_t obj_size, unsigned numof);
+
+/**
+ * @internal
+ * @brief Free the memory of a file slab, none of its objects may be in use
+ *
+ * @param[in]  slab  slab to free
+ */
+static void _slab_deinit(vfs_slab_t *slab);
+
+/**
+ * @internal
+ * @brief Allocate a zeroed object from a file slab
+ *
+ * @param[in]  slab  slab to allocate from
+ *
+ * @return pointer to the object
+ * @return NULL if all the objects are in use or the slab can not grow
+ */
+static void *_slab_alloc(vfs_slab_t *slab);
+
+/**
+ * @internal
+ * @brief Return an object to its file slab
+ *
+ * @param[in]  slab  slab of the object
+ * @param[in]  obj   object to free
+ */
+static void _slab_free(vfs_slab_t *slab, void *obj);
+
 static SemaphoreHandle_t _mount_mutex = NULL;
 static StaticSemaphore_t _mount_mutex_storage;
 static SemaphoreHandle_t _open_mutex = NULL;
 static StaticSemaphore_t _open_mutex_storage;
+static SemaphoreHandle_t _fcache_mutex = NULL;
+static StaticSemaphore_t _fcache_mutex_storage;
 
 void vfs_init(void)
 {
@@ -162,14 +497,18 @@ void vfs_init(void)
     assert(_mount_mutex);
     _open_mutex = xSemaphoreCreateMutexStatic(&_open_mutex_storage);
     assert(_open_mutex);
+    _fcache_mutex = xSemaphoreCreateMutexStatic(&_fcache_mutex_storage);
+    assert(_fcache_mutex);
 }
 
 void vfs_deinit(void)
 {
     vSemaphoreDelete(_mount_mutex);
     vSemaphoreDelete(_open_mutex);
+    vSemaphoreDelete(_fcache_mutex);
     _mount_mutex = NULL;
     _open_mutex = NULL;
+    _fcache_mutex = NULL;
 }
 
 int vfs_close(int fd)
@@ -179,12 +518,19 @@ int vfs_close(int fd)
     if (res < 0) {
         return res;
     }
-    vfs_file_t *filp = &_vfs_open_files[fd];
+    /* the fd may be reused as soon as it is freed */
+    vfs_aio_cancel_fd(fd);
+    vfs_file_t *filp = _filp(fd);
     if (filp->f_op->close != NULL) {
         /* We will invalidate the fd regardless of the outcome of the file
          * system driver close() call below */
         res = filp->f_op->close(filp);
     }
+    if ((filp->mp != NULL) && ((filp->flags & O_ACCMODE) != O_RDONLY)) {
+        /* the file system may update the directory entry on close */
+        _dcache_invalidate(filp->mp);
+        _fcache_written(filp);
+    }
     _free_fd(fd);
     return res;
 }
@@ -196,7 +542,7 @@ int vfs_fcntl(int fd, int cmd, int arg)
     if (res < 0) {
         return res;
     }
-    vfs_file_t *filp = &_vfs_open_files[fd];
+    vfs_file_t *filp = _filp(fd);
     /* The default fcntl implementation below only allows querying flags,
      * any other command requires insight into the file system driver */
     switch (cmd) {
@@ -224,7 +570,7 @@ int vfs_fstat(int fd, struct stat *buf)
     if (res < 0) {
         return res;
     }
-    vfs_file_t *filp = &_vfs_open_files[fd];
+    vfs_file_t *filp = _filp(fd);
     if (filp->f_op->fstat == NULL) {
         /* driver does not implement fstat() */
         return -EINVAL;
@@ -243,7 +589,7 @@ int vfs_fstatvfs(int fd, struct statvfs *buf)
     if (res < 0) {
         return res;
     }
-    vfs_file_t *filp = &_vfs_open_files[fd];
+    vfs_file_t *filp = _filp(fd);
     memset(buf, 0, sizeof(*buf));
     if (filp->mp->fs->fs_op->statvfs == NULL) {
         /* file system driver does not implement statvfs() */
@@ -273,7 +619,7 @@ off_t vfs_lseek(int fd, off_t off, int whence)
     if (res < 0) {
         return res;
     }
-    vfs_file_t *filp = &_vfs_open_files[fd];
+    vfs_file_t *filp = _filp(fd);
     if (filp->f_op->lseek == NULL) {
         /* driver does not implement lseek() */
         /* default seek functionality is naive */
@@ -316,26 +662,24 @@ int vfs_open(const char *name, int flags, mode_t mode)
         DEBUG("vfs_open: no matching mount\n");
         return res;
     }
-
-    xSemaphoreTake(_open_mutex, portMAX_DELAY);
-    int fd = _init_fd(VFS_ANY_FD, mountp->fs->f_op, mountp, flags, NULL);
-    xSemaphoreGive(_open_mutex);
-
+    int fd;
+    if (((flags & (O_ACCMODE | O_CREAT | O_TRUNC | O_DIRECT)) == O_RDONLY) &&
+        (_fcache_numof > 0)) {
+        fd = _fcache_open(mountp, name, flags);
+        if (fd >= 0) {
+            DEBUG("vfs_open: opened %d from the file cache\n", fd);
+            return fd;
+        }
+    }
+    fd = _open_fs(mountp, rel_path, flags, mode);
     if (fd < 0) {
-        DEBUG("vfs_open: _init_fd: ERR %d!\n", fd);
-        /* remember to decrement the open_files count */
-        atomic_fetch_sub(&mountp->open_files, 1);
         return fd;
     }
-    vfs_file_t *filp = &_vfs_open_files[fd];
-    if (filp->f_op->open != NULL) {
-        res = filp->f_op->open(filp, rel_path, flags, mode);
-        if (res < 0) {
-            /* something went wrong during open */
-            DEBUG("vfs_open: open: ERR %d!\n", res);
-            /* clean up */
-            _free_fd(fd);
-            return res;
+    if ((flags & (O_ACCMODE | O_CREAT | O_TRUNC)) != O_RDONLY) {
+        /* the file may have been created or truncated */
+        _dcache_invalidate(mountp);
+        if (_fcache_numof > 0) {
+            _fcache_invalidate(mountp, _filp(fd)->file_id);
         }
     }
     DEBUG("vfs_open: opened %d\n", fd);
@@ -352,7 +696,7 @@ ssize_t vfs_read(int fd, void *dest, size_t count)
     if (res < 0) {
         return res;
     }
-    vfs_file_t *filp = &_vfs_open_files[fd];
+    vfs_file_t *filp = _filp(fd);
     if (((filp->flags & O_ACCMODE) != O_RDONLY) & ((filp->flags & O_ACCMODE) != O_RDWR)) {
         /* File not open for reading */
         return -EBADF;
@@ -374,7 +718,7 @@ ssize_t vfs_write(int fd, const void *src, size_t count)
     if (res < 0) {
         return res;
     }
-    vfs_file_t *filp = &_vfs_open_files[fd];
+    vfs_file_t *filp = _filp(fd);
     if (((filp->flags & O_ACCMODE) != O_WRONLY) & ((filp->flags & O_ACCMODE) != O_RDWR)) {
         /* File not open for writing */
         return -EBADF;
@@ -383,20 +727,118 @@ ssize_t vfs_write(int fd, const void *src, size_t count)
         /* driver does not implement write() */
         return -EINVAL;
     }
-    return filp->f_op->write(filp, src, count);
+    res = filp->f_op->write(filp, src, count);
+    if (filp->mp != NULL) {
+        _dcache_invalidate(filp->mp);
+    }
+    _fcache_written(filp);
+    return res;
+}
+
+ssize_t vfs_readv(int fd, const struct iovec *iov, int iovcnt)
+{
+    DEBUG("vfs_readv: %d, %p, %d\n", fd, (void *)iov, iovcnt);
+    if ((iov == NULL) || (iovcnt < 0)) {
+        return -EINVAL;
+    }
+    int res = _fd_is_valid(fd);
+    if (res < 0) {
+        return res;
+    }
+    vfs_file_t *filp = _filp(fd);
+    if (((filp->flags & O_ACCMODE) != O_RDONLY) & ((filp->flags & O_ACCMODE) != O_RDWR)) {
+        /* File not open for reading */
+        return -EBADF;
+    }
+    if (filp->f_op->readv != NULL) {
+        return filp->f_op->readv(filp, iov, iovcnt);
+    }
+    if (filp->f_op->read == NULL) {
+        /* driver does not implement read() */
+        return -EINVAL;
+    }
+    ssize_t sum = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        ssize_t n = filp->f_op->read(filp, iov[i].iov_base, iov[i].iov_len);
+        if (n < 0) {
+            return (sum > 0) ? sum : n;
+        }
+        sum += n;
+        if ((size_t)n < iov[i].iov_len) {
+            /* end of file */
+            break;
+        }
+    }
+    return sum;
+}
+
+ssize_t vfs_writev(int fd, const struct iovec *iov, int iovcnt)
+{
+    DEBUG_NOT_STDOUT(fd, "vfs_writev: %d, %p, %d\n", fd, (void *)iov, iovcnt);
+    if ((iov == NULL) || (iovcnt < 0)) {
+        return -EINVAL;
+    }
+    int res = _fd_is_valid(fd);
+    if (res < 0) {
+        return res;
+    }
+    vfs_file_t *filp = _filp(fd);
+    if (((filp->flags & O_ACCMODE) != O_WRONLY) & ((filp->flags & O_ACCMODE) != O_RDWR)) {
+        /* File not open for writing */
+        return -EBADF;
+    }
+    ssize_t sum = 0;
+    if (filp->f_op->writev != NULL) {
+        sum = filp->f_op->writev(filp, iov, iovcnt);
+    }
+    else if (filp->f_op->write != NULL) {
+        for (int i = 0; i < iovcnt; i++) {
+            ssize_t n = filp->f_op->write(filp, iov[i].iov_base, iov[i].iov_len);
+            if (n < 0) {
+                sum = (sum > 0) ? sum : n;
+                break;
+            }
+            sum += n;
+            if ((size_t)n < iov[i].iov_len) {
+                /* e.g. the disk is full */
+                break;
+            }
+        }
+    }
+    else {
+        /* driver does not implement write() */
+        return -EINVAL;
+    }
+    if (filp->mp != NULL) {
+        _dcache_invalidate(filp->mp);
+    }
+    _fcache_written(filp);
+    return sum;
 }
 
 ssize_t vfs_write_iol(int fd, const iolist_t *snips)
 {
-    int res, sum = 0;
+    struct iovec iov[VFS_WRITE_IOL_BATCH];
+    ssize_t res, sum = 0;
 
     while (snips) {
-        res = vfs_write(fd, snips->iol_base, snips->iol_len);
+        int iovcnt = 0;
+        size_t len = 0;
+        while (snips && (iovcnt < VFS_WRITE_IOL_BATCH)) {
+            iov[iovcnt].iov_base = snips->iol_base;
+            iov[iovcnt].iov_len = snips->iol_len;
+            len += snips->iol_len;
+            iovcnt++;
+            snips = snips->iol_next;
+        }
+        res = vfs_writev(fd, iov, iovcnt);
         if (res < 0) {
             return res;
         }
         sum += res;
-        snips = snips->iol_next;
+        if ((size_t)res < len) {
+            break;
+        }
     }
 
     return sum;
@@ -409,7 +851,7 @@ int vfs_fsync(int fd)
     if (res < 0) {
         return res;
     }
-    vfs_file_t *filp = &_vfs_open_files[fd];
+    vfs_file_t *filp = _filp(fd);
     if (((filp->flags & O_ACCMODE) != O_WRONLY) & ((filp->flags & O_ACCMODE) != O_RDWR)) {
         /* File not open for writing */
         return -EBADF;
@@ -418,7 +860,39 @@ int vfs_fsync(int fd)
         /* driver does not implement fsync() */
         return -EINVAL;
     }
-    return filp->f_op->fsync(filp);
+    res = filp->f_op->fsync(filp);
+    if (filp->mp != NULL) {
+        _dcache_invalidate(filp->mp);
+    }
+    _fcache_written(filp);
+    return res;
+}
+
+int vfs_fallocate(int fd, off_t offset, off_t len)
+{
+    DEBUG("vfs_fallocate: %d, %ld, %ld\n", fd, (long)offset, (long)len);
+    int res = _fd_is_valid(fd);
+    if (res < 0) {
+        return res;
+    }
+    vfs_file_t *filp = _filp(fd);
+    if (((filp->flags & O_ACCMODE) != O_WRONLY) && ((filp->flags & O_ACCMODE) != O_RDWR)) {
+        /* File not open for writing */
+        return -EBADF;
+    }
+    if ((offset < 0) || (len <= 0)) {
+        return -EINVAL;
+    }
+    if (filp->f_op->fallocate == NULL) {
+        /* driver does not implement fallocate() */
+        return -ENOTSUP;
+    }
+    res = filp->f_op->fallocate(filp, offset, len);
+    if (filp->mp != NULL) {
+        _dcache_invalidate(filp->mp);
+    }
+    _fcache_written(filp);
+    return res;
 }
 
 int vfs_opendir(vfs_DIR *dirp, const char *dirname)
@@ -446,6 +920,16 @@ int vfs_opendir(vfs_DIR *dirp, const char *dirname)
         /* file system driver does not support directories */
         return -EINVAL;
     }
+    uint32_t hash;
+    if (_dcache_key(mountp, dirname, &hash)) {
+        struct stat buf;
+        if (_dcache_lookup(mountp, dirname, hash, atomic_load(&mountp->dcache_gen), &buf, &res) &&
+            (res < 0)) {
+            /* known to be missing */
+            atomic_fetch_sub(&mountp->open_files, 1);
+            return res;
+        }
+    }
     /* initialize dirp */
     memset(dirp, 0, sizeof(*dirp));
     dirp->mp = mountp;
@@ -475,13 +959,47 @@ int vfs_readdir(vfs_DIR *dirp, vfs_dirent_t *entry)
     return -EINVAL;
 }
 
-int vfs_closedir(vfs_DIR *dirp)
+ssize_t vfs_readdir_batch(vfs_DIR *dirp, vfs_dirent_stat_t *entries, size_t n)
 {
-    DEBUG("vfs_closedir: %p\n", (void *)dirp);
-    if (dirp == NULL) {
+    DEBUG("vfs_readdir_batch: %p, %p, %u\n", (void *)dirp, (void *)entries, (unsigned)n);
+    if ((dirp == NULL) || (entries == NULL)) {
         return -EINVAL;
     }
-    vfs_mount_t *mountp = dirp->mp;
+    if (dirp->d_op == NULL) {
+        return -EINVAL;
+    }
+    if (dirp->d_op->readdir_batch != NULL) {
+        return dirp->d_op->readdir_batch(dirp, entries, n);
+    }
+    if (dirp->d_op->readdir == NULL) {
+        return -EINVAL;
+    }
+    /* names only, the file system does not keep the status in the directory */
+    size_t count = 0;
+    while (count < n) {
+        vfs_dirent_t entry;
+        int res = dirp->d_op->readdir(dirp, &entry);
+        if (res < 0) {
+            return (count > 0) ? (ssize_t)count : res;
+        }
+        if (res == 0) {
+            break;
+        }
+        memset(&entries[count], 0, sizeof(entries[count]));
+        entries[count].d_ino = entry.d_ino;
+        memcpy(entries[count].d_name, entry.d_name, sizeof(entries[count].d_name));
+        count++;
+    }
+    return count;
+}
+
+int vfs_closedir(vfs_DIR *dirp)
+{
+    DEBUG("vfs_closedir: %p\n", (void *)dirp);
+    if (dirp == NULL) {
+        return -EINVAL;
+    }
+    vfs_mount_t *mountp = dirp->mp;
     if (mountp == NULL) {
         return -EBADF;
     }
@@ -558,19 +1076,41 @@ int vfs_mount(vfs_mount_t *mountp)
         return ret;
     }
 
+    if (clist_count(&_vfs_mounts_list) >= VFS_MAX_MOUNTS) {
+        DEBUG("vfs_mount: too many mounts\n");
+        xSemaphoreGive(_mount_mutex);
+        return -ENOMEM;
+    }
+
+    /* A slab kept by a forced unmount is reused, the files left open by
+     * it may still own objects of the slab */
+    bool slab_init = false;
+    if ((mountp->fs->file_data_size > 0) && (mountp->file_slab.obj_size == 0)) {
+        unsigned numof = (mountp->max_open_files > 0) ? mountp->max_open_files
+                                                      : VFS_MOUNT_MAX_OPEN_FILES;
+        _slab_init(&mountp->file_slab, mountp->fs->file_data_size, numof);
+        slab_init = true;
+    }
+
     if (mountp->fs->fs_op != NULL) {
         if (mountp->fs->fs_op->mount != NULL) {
             /* yes, a file system driver does not need to implement mount/umount */
             int res = mountp->fs->fs_op->mount(mountp);
             if (res < 0) {
                 DEBUG("vfs_mount: error %d\n", res);
+                if (slab_init) {
+                    _slab_deinit(&mountp->file_slab);
+                }
                 xSemaphoreGive(_mount_mutex);
                 return res;
             }
         }
     }
     /* Insert last in list. This property is relied on by vfs_iterate_mount_dirs. */
+    /* the mount may have been used with another device before */
+    _dcache_invalidate(mountp);
     clist_rpush(&_vfs_mounts_list, &mountp->list_entry);
+    _mount_snapshot_publish(NULL);
     xSemaphoreGive(_mount_mutex);
     DEBUG("vfs_mount: mount done\n");
     return 0;
@@ -592,8 +1132,12 @@ int vfs_umount(vfs_mount_t *mountp, bool force)
         DEBUG("vfs_umount: invalid fs\n");
         return -EINVAL;
     }
+    /* Hide the mount from lookups first, so that open_files can not be
+     * incremented anymore once it has been checked */
+    _mount_snapshot_publish(mountp);
     DEBUG("vfs_umount: -> \"%s\" open=%d\n", mountp->mount_point, atomic_load(&mountp->open_files));
     if (atomic_load(&mountp->open_files) > 0 && !force) {
+        _mount_snapshot_publish(NULL);
         xSemaphoreGive(_mount_mutex);
         return -EBUSY;
     }
@@ -603,6 +1147,7 @@ int vfs_umount(vfs_mount_t *mountp, bool force)
             if (res < 0) {
                 /* umount failed */
                 DEBUG("vfs_umount: ERR %d!\n", res);
+                _mount_snapshot_publish(NULL);
                 xSemaphoreGive(_mount_mutex);
                 return res;
             }
@@ -616,6 +1161,12 @@ int vfs_umount(vfs_mount_t *mountp, bool force)
         xSemaphoreGive(_mount_mutex);
         return -EINVAL;
     }
+    _dcache_forget(mountp);
+    _fcache_forget(mountp);
+    /* The files left open by a forced unmount still own their private data */
+    if (mountp->file_slab.used == 0) {
+        _slab_deinit(&mountp->file_slab);
+    }
     xSemaphoreGive(_mount_mutex);
     return 0;
 }
@@ -662,6 +1213,10 @@ int vfs_rename(const char *from_path, const char *to_path)
         return -EXDEV;
     }
     res = mountp->fs->fs_op->rename(mountp, rel_from, rel_to);
+    _dcache_invalidate(mountp);
+    if (_fcache_numof > 0) {
+        _fcache_invalidate(mountp, 0);
+    }
     DEBUG("vfs_rename: rename %p, \"%s\" -> \"%s\"", (void *)mountp, rel_from, rel_to);
     if (res < 0) {
         /* something went wrong during rename */
@@ -702,6 +1257,10 @@ int vfs_unlink(const char *name)
         return -EROFS;
     }
     res = mountp->fs->fs_op->unlink(mountp, rel_path);
+    _dcache_invalidate(mountp);
+    if (_fcache_numof > 0) {
+        _fcache_invalidate(mountp, 0);
+    }
     DEBUG("vfs_unlink: unlink %p, \"%s\"", (void *)mountp, rel_path);
     if (res < 0) {
         /* something went wrong during unlink */
@@ -739,6 +1298,7 @@ int vfs_mkdir(const char *name, mode_t mode)
         return -EROFS;
     }
     res = mountp->fs->fs_op->mkdir(mountp, rel_path, mode);
+    _dcache_invalidate(mountp);
     DEBUG("vfs_mkdir: mkdir %p, \"%s\"", (void *)mountp, rel_path);
     if (res < 0) {
         /* something went wrong during mkdir */
@@ -776,6 +1336,7 @@ int vfs_rmdir(const char *name)
         return -EROFS;
     }
     res = mountp->fs->fs_op->rmdir(mountp, rel_path);
+    _dcache_invalidate(mountp);
     DEBUG("vfs_rmdir: rmdir %p, \"%s\"", (void *)mountp, rel_path);
     if (res < 0) {
         /* something went wrong during rmdir */
@@ -812,8 +1373,19 @@ int vfs_stat(const char *restrict path, struct stat *restrict buf)
         atomic_fetch_sub(&mountp->open_files, 1);
         return -EPERM;
     }
+    uint32_t hash;
+    bool cacheable = _dcache_key(mountp, path, &hash);
+    unsigned gen = atomic_load(&mountp->dcache_gen);
+    if (cacheable && _dcache_lookup(mountp, path, hash, gen, buf, &res)) {
+        /* remember to decrement the open_files count */
+        atomic_fetch_sub(&mountp->open_files, 1);
+        return res;
+    }
     memset(buf, 0, sizeof(*buf));
     res = mountp->fs->fs_op->stat(mountp, rel_path, buf);
+    if (cacheable) {
+        _dcache_insert(mountp, path, hash, gen, res, buf);
+    }
     /* remember to decrement the open_files count */
     atomic_fetch_sub(&mountp->open_files, 1);
     return res;
@@ -1002,16 +1574,22 @@ bool vfs_iterate_mount_dirs(vfs_DIR *dir)
 const vfs_file_t *vfs_file_get(int fd)
 {
     if (_fd_is_valid(fd) == 0) {
-        return &_vfs_open_files[fd];
+        return _filp(fd);
     }
     else {
         return NULL;
     }
 }
 
+static inline vfs_file_t *_filp(int fd)
+{
+    return &_vfs_open_files[fd / VFS_FD_TABLE_CHUNK][fd % VFS_FD_TABLE_CHUNK];
+}
+
 static inline int _allocate_fd(int fd)
 {
     if (fd < 0) {
+        int unallocated = -1;
         for (fd = 0; fd < VFS_MAX_OPEN_FILES; ++fd) {
             if ((fd == STDIN_FILENO) || (fd == STDOUT_FILENO) || (fd == STDERR_FILENO)) {
                 /* Do not auto-allocate the stdio file descriptor numbers to
@@ -1020,16 +1598,36 @@ static inline int _allocate_fd(int fd)
                  * to bind to these specific file descriptor numbers. */
                 continue;
             }
-            if (_vfs_open_files[fd].task_id == (UBaseType_t)0U) {
+            if (_vfs_open_files[fd / VFS_FD_TABLE_CHUNK] == NULL) {
+                /* Only grow the table when the allocated chunks are full */
+                if (unallocated < 0) {
+                    unallocated = fd;
+                }
+                fd = (fd / VFS_FD_TABLE_CHUNK + 1) * VFS_FD_TABLE_CHUNK - 1;
+                continue;
+            }
+            if (_filp(fd)->task_id == (UBaseType_t)0U) {
                 break;
             }
         }
+        if ((fd >= VFS_MAX_OPEN_FILES) && (unallocated >= 0)) {
+            fd = unallocated;
+        }
     }
     if (fd >= VFS_MAX_OPEN_FILES) {
-        /* The _vfs_open_files array is full */
+        /* The _vfs_open_files table is full */
         return -ENFILE;
     }
-    else if (_vfs_open_files[fd].task_id != (UBaseType_t)0U) {
+    else if (_vfs_open_files[fd / VFS_FD_TABLE_CHUNK] == NULL) {
+        vfs_file_t *chunk = pvPortMalloc(VFS_FD_TABLE_CHUNK * sizeof(vfs_file_t));
+        if (chunk == NULL) {
+            return -ENOMEM;
+        }
+        memset(chunk, 0, VFS_FD_TABLE_CHUNK * sizeof(vfs_file_t));
+        _vfs_open_files[fd / VFS_FD_TABLE_CHUNK] = chunk;
+        DEBUG("_allocate_fd: chunk %d allocated\n", fd / VFS_FD_TABLE_CHUNK);
+    }
+    else if (_filp(fd)->task_id != (UBaseType_t)0U) {
         /* The desired fd is already in use */
         return -EEXIST;
     }
@@ -1042,17 +1640,24 @@ static inline int _allocate_fd(int fd)
          * been started. */
         task_id = -1;
     }
-    _vfs_open_files[fd].task_id = task_id;
+    _filp(fd)->task_id = task_id;
     return fd;
 }
 
 static inline void _free_fd(int fd)
 {
-    DEBUG("_free_fd: %d, pid=%lu\n", fd, _vfs_open_files[fd].task_id);
-    if (_vfs_open_files[fd].mp != NULL) {
-        atomic_fetch_sub(&_vfs_open_files[fd].mp->open_files, 1);
+    vfs_file_t *filp = _filp(fd);
+    DEBUG("_free_fd: %d, pid=%lu\n", fd, (unsigned long)filp->task_id);
+    if (filp->mp != NULL) {
+        /* the descriptors of the file cache do not use the slab */
+        if ((filp->mp->fs->file_data_size > 0) && (filp->f_op == filp->mp->fs->f_op) &&
+            (filp->private_data.ptr != NULL)) {
+            _slab_free(&filp->mp->file_slab, filp->private_data.ptr);
+            filp->private_data.ptr = NULL;
+        }
+        atomic_fetch_sub(&filp->mp->open_files, 1);
     }
-    _vfs_open_files[fd].task_id = (UBaseType_t)0U;
+    filp->task_id = (UBaseType_t)0U;
 }
 
 static inline int _init_fd(int fd, const vfs_file_ops_t *f_op, vfs_mount_t *mountp, int flags, void *private_data)
@@ -1061,36 +1666,59 @@ static inline int _init_fd(int fd, const vfs_file_ops_t *f_op, vfs_mount_t *moun
     if (fd < 0) {
         return fd;
     }
-    vfs_file_t *filp = &_vfs_open_files[fd];
+    vfs_file_t *filp = _filp(fd);
     filp->mp = mountp;
     filp->f_op = f_op;
     filp->flags = flags;
     filp->pos = 0;
+    filp->file_id = 0;
     filp->private_data.ptr = private_data;
     return fd;
 }
 
+static int _open_fs(vfs_mount_t *mountp, const char *rel_path, int flags, mode_t mode)
+{
+    xSemaphoreTake(_open_mutex, portMAX_DELAY);
+    int fd = _init_fd(VFS_ANY_FD, mountp->fs->f_op, mountp, flags, NULL);
+    xSemaphoreGive(_open_mutex);
+
+    if (fd < 0) {
+        DEBUG("vfs_open: _init_fd: ERR %d!\n", fd);
+        /* remember to decrement the open_files count */
+        atomic_fetch_sub(&mountp->open_files, 1);
+        return fd;
+    }
+    vfs_file_t *filp = _filp(fd);
+    if (mountp->fs->file_data_size > 0) {
+        filp->private_data.ptr = _slab_alloc(&mountp->file_slab);
+        if (filp->private_data.ptr == NULL) {
+            DEBUG("vfs_open: file slab full\n");
+            _free_fd(fd);
+            return -ENFILE;
+        }
+    }
+    if (filp->f_op->open != NULL) {
+        int res = filp->f_op->open(filp, rel_path, flags, mode);
+        if (res < 0) {
+            /* something went wrong during open */
+            DEBUG("vfs_open: open: ERR %d!\n", res);
+            /* clean up */
+            _free_fd(fd);
+            return res;
+        }
+    }
+    return fd;
+}
+
 static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const char **rel_path)
 {
-    size_t longest_match = 0;
     size_t name_len = strlen(name);
-    xSemaphoreTake(_mount_mutex, portMAX_DELAY);
+    vfs_mount_snapshot_t *snap = _mount_snapshot_get();
 
-    clist_node_t *node = _vfs_mounts_list.next;
-    if (node == NULL) {
-        /* list empty */
-        xSemaphoreGive(_mount_mutex);
-        return -ENOENT;
-    }
     vfs_mount_t *mountp = NULL;
-    do {
-        node = node->next;
-        vfs_mount_t *it = container_of(node, vfs_mount_t, list_entry);
+    for (unsigned i = 0; i < snap->numof; i++) {
+        vfs_mount_t *it = snap->mounts[i];
         size_t len = it->mount_point_len;
-        if (len < longest_match) {
-            /* Already found a longer prefix */
-            continue;
-        }
         if (len > name_len) {
             /* path name is shorter than the mount point name */
             continue;
@@ -1100,40 +1728,106 @@ static inline int _find_mount(vfs_mount_t **mountpp, const char *name, const cha
             continue;
         }
         if (strncmp(name, it->mount_point, len) == 0) {
-            /* mount_point is a prefix of name */
-            /* special check for mount_point == "/" */
-            if (len > 1) {
-                longest_match = len;
-            }
+            /* mount_point is a prefix of name, the mounts are sorted by the
+             * length of their mount point so this is the longest match */
             mountp = it;
+            break;
         }
-    } while (node != _vfs_mounts_list.next);
+    }
     if (mountp == NULL) {
         /* not found */
-        xSemaphoreGive(_mount_mutex);
+        _mount_snapshot_put(snap);
         return -ENOENT;
     }
-    /* Increment open files counter for this mount */
+    /* Increment open files counter for this mount while the snapshot still
+     * keeps vfs_umount from checking it */
     atomic_fetch_add(&mountp->open_files, 1);
-    xSemaphoreGive(_mount_mutex);
+    _mount_snapshot_put(snap);
     *mountpp = mountp;
 
     if (rel_path != NULL) {
         if (mountp->fs->flags & VFS_FS_FLAG_WANT_ABS_PATH) {
             *rel_path = name;
+        } else if (mountp->mount_point_len > 1) {
+            *rel_path = name + mountp->mount_point_len;
         } else {
-            *rel_path = name + longest_match;
+            /* special case for mount_point == "/" */
+            *rel_path = name;
         }
     }
     return 0;
 }
 
+static inline vfs_mount_snapshot_t *_mount_snapshot_get(void)
+{
+    vfs_mount_snapshot_t *snap = atomic_load(&_mount_snapshot);
+    for (;;) {
+        atomic_fetch_add(&snap->readers, 1);
+        vfs_mount_snapshot_t *cur = atomic_load(&_mount_snapshot);
+        if (cur == snap) {
+            /* the snapshot can not be refilled until it is released */
+            return snap;
+        }
+        /* swapped in the meantime, the writer may be refilling it */
+        atomic_fetch_sub(&snap->readers, 1);
+        snap = cur;
+    }
+}
+
+static inline void _mount_snapshot_put(vfs_mount_snapshot_t *snap)
+{
+    atomic_fetch_sub(&snap->readers, 1);
+}
+
+static void _mount_snapshot_wait(vfs_mount_snapshot_t *snap)
+{
+    while (atomic_load(&snap->readers) > 0) {
+        vTaskDelay(1);
+    }
+}
+
+static void _mount_snapshot_publish(const vfs_mount_t *exclude)
+{
+    vfs_mount_snapshot_t *prev = atomic_load(&_mount_snapshot);
+    vfs_mount_snapshot_t *next = (prev == &_mount_snapshots[0]) ? &_mount_snapshots[1]
+                                                                 : &_mount_snapshots[0];
+    /* lookups started before the previous swap may still read it */
+    _mount_snapshot_wait(next);
+
+    unsigned numof = 0;
+    clist_node_t *node = _vfs_mounts_list.next;
+    if (node != NULL) {
+        do {
+            node = node->next;
+            vfs_mount_t *it = container_of(node, vfs_mount_t, list_entry);
+            if (it == exclude) {
+                continue;
+            }
+            /* insertion sort, the longest mount point first, the later mount
+             * first among the ones of the same length */
+            unsigned i = numof++;
+            while ((i > 0) && (next->mounts[i - 1]->mount_point_len <= it->mount_point_len)) {
+                next->mounts[i] = next->mounts[i - 1];
+                i--;
+            }
+            next->mounts[i] = it;
+        } while (node != _vfs_mounts_list.next);
+    }
+    next->numof = numof;
+
+    atomic_store(&_mount_snapshot, next);
+    _mount_snapshot_wait(prev);
+}
+
 static inline int _fd_is_valid(int fd)
 {
     if ((unsigned int)fd >= VFS_MAX_OPEN_FILES) {
         return -EBADF;
     }
-    vfs_file_t *filp = &_vfs_open_files[fd];
+    if (_vfs_open_files[fd / VFS_FD_TABLE_CHUNK] == NULL) {
+        return -EBADF;
+    }
+    vfs_file_t *filp = _filp(fd);
     if (filp->task_id == (UBaseType_t)0U) {
         return -EBADF;
     }
@@ -1166,6 +1860,17 @@ int vfs_sysop_stat_from_fstat(vfs_mount_t *mountp, const char *restrict path, st
 {
     const vfs_file_ops_t * f_op = mountp->fs->f_op;
 
+    /* the file is only open for this call, it does not take an object of
+     * the file slab that an open file may need */
+    void *file_data = NULL;
+    if (mountp->fs->file_data_size > 0) {
+        file_data = pvPortMalloc(mountp->fs->file_data_size);
+        if (file_data == NULL) {
+            return -ENOMEM;
+        }
+        memset(file_data, 0, mountp->fs->file_data_size);
+    }
+
     union {
         vfs_file_t file;
         vfs_DIR dir;
@@ -1174,7 +1879,7 @@ int vfs_sysop_stat_from_fstat(vfs_mount_t *mountp, const char *restrict path, st
             .mp = mountp,
             /* As per definition of the `vfsfile_ops::open` field */
             .f_op = f_op,
-            .private_data = { .ptr = NULL },
+            .private_data = { .ptr = file_data },
             .pos = 0,
         },
     };
@@ -1183,15 +1888,595 @@ int vfs_sysop_stat_from_fstat(vfs_mount_t *mountp, const char *restrict path, st
     if (err < 0) {
         if (_is_dir(mountp, &filedir.dir, path)) {
             buf->st_mode = S_IFDIR;
-            return 0;
+            err = 0;
         }
-        return err;
     }
-    err = f_op->fstat(&filedir.file, buf);
-    f_op->close(&filedir.file);
+    else {
+        err = f_op->fstat(&filedir.file, buf);
+        f_op->close(&filedir.file);
+    }
+    vPortFree(file_data);
     return err;
 }
 
+void vfs_dcache_stats_get(vfs_dcache_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = _dcache_stats;
+    taskEXIT_CRITICAL();
+}
+
+void vfs_dcache_stats_reset(void)
+{
+    taskENTER_CRITICAL();
+    memset(&_dcache_stats, 0, sizeof(_dcache_stats));
+    taskEXIT_CRITICAL();
+}
+
+static bool _dcache_key(const vfs_mount_t *mountp, const char *path, uint32_t *hash)
+{
+    if ((mountp->fs->flags & VFS_FS_FLAG_DCACHE) == 0) {
+        return false;
+    }
+    char normalized[VFS_DCACHE_PATH_MAX + 1];
+    if ((vfs_normalize_path(normalized, path, sizeof(normalized)) < 0) ||
+        (strcmp(normalized, path) != 0)) {
+        /* too long, or e.g. "/a/../b" which may not even be on this mount */
+        return false;
+    }
+    /* FNV-1a */
+    uint32_t h = 2166136261ul ^ (uint32_t)(uintptr_t)mountp;
+    for (const char *c = path; *c != '\0'; c++) {
+        h = (h ^ (uint8_t)*c) * 16777619ul;
+    }
+    *hash = h;
+    return true;
+}
+
+static bool _dcache_lookup(const vfs_mount_t *mountp, const char *path, uint32_t hash,
+                           unsigned gen, struct stat *buf, int *res)
+{
+    vfs_dentry_t *set = _dcache[hash % VFS_DCACHE_SETS];
+    bool hit = false;
+
+    taskENTER_CRITICAL();
+    for (unsigned i = 0; i < VFS_DCACHE_WAYS; i++) {
+        vfs_dentry_t *e = &set[i];
+        if ((e->mp != mountp) || (e->gen != gen) || (e->hash != hash) ||
+            (strcmp(e->path, path) != 0)) {
+            continue;
+        }
+        e->last_use = ++_dcache_clock;
+        *res = e->res;
+        if (e->res == 0) {
+            memset(buf, 0, sizeof(*buf));
+            buf->st_mode = e->mode;
+            buf->st_size = e->size;
+            buf->st_mtim = e->mtim;
+            _dcache_stats.hits++;
+        }
+        else {
+            _dcache_stats.negative_hits++;
+        }
+        hit = true;
+        break;
+    }
+    if (!hit) {
+        _dcache_stats.misses++;
+    }
+    taskEXIT_CRITICAL();
+
+    return hit;
+}
+
+static void _dcache_insert(const vfs_mount_t *mountp, const char *path, uint32_t hash,
+                           unsigned gen, int res, const struct stat *buf)
+{
+    if ((res != 0) && (res != -ENOENT)) {
+        /* e.g. an I/O error, ask the file system again next time */
+        return;
+    }
+    vfs_dentry_t *set = _dcache[hash % VFS_DCACHE_SETS];
+
+    taskENTER_CRITICAL();
+    /* replace an unused or stale entry, or the least recently used one */
+    vfs_dentry_t *victim = &set[0];
+    for (unsigned i = 0; i < VFS_DCACHE_WAYS; i++) {
+        vfs_dentry_t *e = &set[i];
+        if ((e->mp == NULL) || (e->gen != atomic_load(&e->mp->dcache_gen))) {
+            victim = e;
+            break;
+        }
+        if ((int32_t)(e->last_use - victim->last_use) < 0) {
+            victim = e;
+        }
+    }
+    if ((victim->mp != NULL) && (victim->gen == atomic_load(&victim->mp->dcache_gen))) {
+        _dcache_stats.evictions++;
+    }
+    victim->mp = mountp;
+    victim->gen = gen;
+    victim->hash = hash;
+    victim->last_use = ++_dcache_clock;
+    victim->res = res;
+    victim->mode = buf->st_mode;
+    victim->size = buf->st_size;
+    victim->mtim = buf->st_mtim;
+    strcpy(victim->path, path);
+    taskEXIT_CRITICAL();
+}
+
+static inline void _dcache_invalidate(vfs_mount_t *mountp)
+{
+    atomic_fetch_add(&mountp->dcache_gen, 1);
+    taskENTER_CRITICAL();
+    _dcache_stats.invalidations++;
+    taskEXIT_CRITICAL();
+}
+
+static void _dcache_forget(const vfs_mount_t *mountp)
+{
+    taskENTER_CRITICAL();
+    for (unsigned i = 0; i < VFS_DCACHE_SETS; i++) {
+        for (unsigned j = 0; j < VFS_DCACHE_WAYS; j++) {
+            if (_dcache[i][j].mp == mountp) {
+                _dcache[i][j].mp = NULL;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+static void _fcache_blob_put(vfs_fcache_blob_t *blob)
+{
+    if (--blob->refs == 0) {
+        vPortFree(blob);
+    }
+}
+
+static void _fcache_drop(vfs_fcache_entry_t *e)
+{
+    if (e->blob != NULL) {
+        _fcache_stats.bytes -= e->blob->size;
+        _fcache_blob_put(e->blob);
+        e->blob = NULL;
+    }
+}
+
+/* drop the contents of the least recently opened files until size bytes fit */
+static void _fcache_make_room(const vfs_fcache_entry_t *keep, size_t size)
+{
+    while (_fcache_stats.bytes + size > VFS_FCACHE_BUDGET) {
+        vfs_fcache_entry_t *victim = NULL;
+        for (unsigned i = 0; i < VFS_FCACHE_ENTRIES; i++) {
+            vfs_fcache_entry_t *e = &_fcache[i];
+            if ((e == keep) || (e->blob == NULL)) {
+                continue;
+            }
+            if ((victim == NULL) || ((int32_t)(e->last_use - victim->last_use) < 0)) {
+                victim = e;
+            }
+        }
+        if (victim == NULL) {
+            return;
+        }
+        DEBUG("vfs_fcache: evict \"%s\"\n", victim->path);
+        _fcache_drop(victim);
+        _fcache_stats.evictions++;
+    }
+}
+
+/* a file with an unknown id may be any file of the mount */
+static bool _fcache_writer_open(const vfs_mount_t *mountp, uint64_t file_id, int except)
+{
+    bool found = false;
+
+    xSemaphoreTake(_open_mutex, portMAX_DELAY);
+    for (int fd = 0; (fd < VFS_MAX_OPEN_FILES) && !found; fd++) {
+        if (_vfs_open_files[fd / VFS_FD_TABLE_CHUNK] == NULL) {
+            fd = (fd / VFS_FD_TABLE_CHUNK + 1) * VFS_FD_TABLE_CHUNK - 1;
+            continue;
+        }
+        const vfs_file_t *filp = _filp(fd);
+        found = (fd != except) && (filp->task_id != (UBaseType_t)0U) &&
+                (filp->mp == mountp) && ((filp->flags & O_ACCMODE) != O_RDONLY) &&
+                ((file_id == 0) || (filp->file_id == 0) || (filp->file_id == file_id));
+    }
+    xSemaphoreGive(_open_mutex);
+
+    return found;
+}
+
+/* read the contents of a pinned file, called with _fcache_mutex held */
+static int _fcache_load(vfs_fcache_entry_t *e)
+{
+    /* the descriptor used for reading holds its own reference to the mount */
+    atomic_fetch_add(&e->mp->open_files, 1);
+    int fd = _open_fs(e->mp, e->rel_path, O_RDONLY, 0);
+    if (fd < 0) {
+        return fd;
+    }
+
+    vfs_fcache_blob_t *blob = NULL;
+    struct stat st;
+    int res = vfs_fstat(fd, &st);
+    if ((res == 0) && _fcache_writer_open(e->mp, _filp(fd)->file_id, fd)) {
+        /* the copy would be stale as soon as it is written */
+        res = -EBUSY;
+    }
+    if ((res == 0) && (st.st_size > VFS_FCACHE_BUDGET)) {
+        res = -EFBIG;
+    }
+    if (res == 0) {
+        _fcache_make_room(e, st.st_size);
+        blob = pvPortMalloc(sizeof(*blob) + st.st_size);
+        if (blob == NULL) {
+            res = -ENOMEM;
+        }
+    }
+    size_t total = 0;
+    while ((res == 0) && (total < (size_t)st.st_size)) {
+        ssize_t n = vfs_read(fd, blob->data + total, st.st_size - total);
+        if (n <= 0) {
+            /* the file can not shrink while it is open */
+            res = (n < 0) ? n : -EIO;
+            break;
+        }
+        total += n;
+    }
+    uint64_t file_id = _filp(fd)->file_id;
+    vfs_close(fd);
+
+    if (res < 0) {
+        if (blob != NULL) {
+            vPortFree(blob);
+        }
+        return res;
+    }
+
+    DEBUG("vfs_fcache: loaded \"%s\", %u bytes\n", e->path, (unsigned)total);
+    blob->refs = 1;
+    blob->size = total;
+    blob->mtim = st.st_mtim;
+    e->blob = blob;
+    e->file_id = file_id;
+    _fcache_stats.bytes += total;
+    _fcache_stats.loads++;
+    return 0;
+}
+
+static vfs_fcache_entry_t *_fcache_find(const char *path)
+{
+    for (unsigned i = 0; i < VFS_FCACHE_ENTRIES; i++) {
+        if ((_fcache[i].mp != NULL) && (strcmp(_fcache[i].path, path) == 0)) {
+            return &_fcache[i];
+        }
+    }
+    return NULL;
+}
+
+static int _fcache_open(vfs_mount_t *mountp, const char *path, int flags)
+{
+    int fd = -ENOENT;
+
+    xSemaphoreTake(_fcache_mutex, portMAX_DELAY);
+    vfs_fcache_entry_t *e = _fcache_find(path);
+    if ((e != NULL) && (e->mp == mountp) &&
+        ((e->blob != NULL) || (_fcache_load(e) == 0))) {
+        xSemaphoreTake(_open_mutex, portMAX_DELAY);
+        fd = _init_fd(VFS_ANY_FD, &_fcache_file_ops, mountp, flags, e->blob);
+        xSemaphoreGive(_open_mutex);
+        if (fd >= 0) {
+            e->blob->refs++;
+            e->last_use = ++_fcache_clock;
+            _fcache_stats.hits++;
+        }
+    }
+    xSemaphoreGive(_fcache_mutex);
+
+    return fd;
+}
+
+static void _fcache_invalidate(const vfs_mount_t *mountp, uint64_t file_id)
+{
+    xSemaphoreTake(_fcache_mutex, portMAX_DELAY);
+    for (unsigned i = 0; i < VFS_FCACHE_ENTRIES; i++) {
+        vfs_fcache_entry_t *e = &_fcache[i];
+        if ((e->mp == mountp) && (e->blob != NULL) &&
+            ((file_id == 0) || (e->file_id == file_id))) {
+            DEBUG("vfs_fcache: invalidate \"%s\"\n", e->path);
+            _fcache_drop(e);
+            _fcache_stats.invalidations++;
+        }
+    }
+    xSemaphoreGive(_fcache_mutex);
+}
+
+static void _fcache_forget(const vfs_mount_t *mountp)
+{
+    xSemaphoreTake(_fcache_mutex, portMAX_DELAY);
+    for (unsigned i = 0; i < VFS_FCACHE_ENTRIES; i++) {
+        vfs_fcache_entry_t *e = &_fcache[i];
+        if (e->mp == mountp) {
+            _fcache_drop(e);
+            e->mp = NULL;
+            _fcache_numof--;
+        }
+    }
+    xSemaphoreGive(_fcache_mutex);
+}
+
+static ssize_t _fcache_read(vfs_file_t *filp, void *dest, size_t nbytes)
+{
+    const vfs_fcache_blob_t *blob = filp->private_data.ptr;
+    if (filp->pos >= (off_t)blob->size) {
+        return 0;
+    }
+    if (nbytes > blob->size - filp->pos) {
+        nbytes = blob->size - filp->pos;
+    }
+    memcpy(dest, blob->data + filp->pos, nbytes);
+    filp->pos += nbytes;
+    return nbytes;
+}
+
+static off_t _fcache_lseek(vfs_file_t *filp, off_t off, int whence)
+{
+    const vfs_fcache_blob_t *blob = filp->private_data.ptr;
+    switch (whence) {
+        case SEEK_SET:
+            break;
+        case SEEK_CUR:
+            off += filp->pos;
+            break;
+        case SEEK_END:
+            off += blob->size;
+            break;
+        default:
+            return -EINVAL;
+    }
+    if (off < 0) {
+        /* the resulting file offset would be negative */
+        return -EINVAL;
+    }
+    filp->pos = off;
+    return off;
+}
+
+static int _fcache_fstat(vfs_file_t *filp, struct stat *buf)
+{
+    const vfs_fcache_blob_t *blob = filp->private_data.ptr;
+    buf->st_mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
+    buf->st_size = blob->size;
+    buf->st_mtim = blob->mtim;
+    return 0;
+}
+
+static int _fcache_close(vfs_file_t *filp)
+{
+    xSemaphoreTake(_fcache_mutex, portMAX_DELAY);
+    _fcache_blob_put(filp->private_data.ptr);
+    xSemaphoreGive(_fcache_mutex);
+    filp->private_data.ptr = NULL;
+    return 0;
+}
+
+static const vfs_file_ops_t _fcache_file_ops = {
+    .close = _fcache_close,
+    .fstat = _fcache_fstat,
+    .lseek = _fcache_lseek,
+    .read = _fcache_read,
+};
+
+int vfs_fcache_pin(const char *path)
+{
+    DEBUG("vfs_fcache_pin: \"%s\"\n", path);
+    if (path == NULL) {
+        return -EINVAL;
+    }
+    char normalized[VFS_FCACHE_PATH_MAX + 1];
+    int res = vfs_normalize_path(normalized, path, sizeof(normalized));
+    if (res < 0) {
+        return res;
+    }
+    const char *rel_path;
+    vfs_mount_t *mountp;
+    res = _find_mount(&mountp, normalized, &rel_path);
+    /* _find_mount implicitly increments the open_files count on success */
+    if (res < 0) {
+        return res;
+    }
+    if ((mountp->fs->flags & VFS_FS_FLAG_DCACHE) == 0) {
+        /* the files may change behind the back of the VFS */
+        atomic_fetch_sub(&mountp->open_files, 1);
+        return -ENOTSUP;
+    }
+
+    xSemaphoreTake(_fcache_mutex, portMAX_DELAY);
+    vfs_fcache_entry_t *e = _fcache_find(normalized);
+    if (e == NULL) {
+        for (unsigned i = 0; i < VFS_FCACHE_ENTRIES; i++) {
+            if (_fcache[i].mp == NULL) {
+                e = &_fcache[i];
+                break;
+            }
+        }
+        if (e == NULL) {
+            res = -ENOSPC;
+        }
+        else {
+            strcpy(e->path, normalized);
+            e->rel_path = e->path + (rel_path - normalized);
+            e->mp = mountp;
+            e->blob = NULL;
+            e->pins = 0;
+            e->last_use = ++_fcache_clock;
+            res = _fcache_load(e);
+            if (res < 0) {
+                e->mp = NULL;
+            }
+            else {
+                _fcache_numof++;
+            }
+        }
+    }
+    else if (e->blob == NULL) {
+        res = _fcache_load(e);
+    }
+    if (res == 0) {
+        e->pins++;
+    }
+    xSemaphoreGive(_fcache_mutex);
+
+    atomic_fetch_sub(&mountp->open_files, 1);
+    return res;
+}
+
+int vfs_fcache_unpin(const char *path)
+{
+    DEBUG("vfs_fcache_unpin: \"%s\"\n", path);
+    if (path == NULL) {
+        return -EINVAL;
+    }
+    char normalized[VFS_FCACHE_PATH_MAX + 1];
+    int res = vfs_normalize_path(normalized, path, sizeof(normalized));
+    if (res < 0) {
+        return -ENOENT;
+    }
+
+    xSemaphoreTake(_fcache_mutex, portMAX_DELAY);
+    vfs_fcache_entry_t *e = _fcache_find(normalized);
+    if (e == NULL) {
+        res = -ENOENT;
+    }
+    else {
+        res = 0;
+        if (--e->pins == 0) {
+            _fcache_drop(e);
+            e->mp = NULL;
+            _fcache_numof--;
+        }
+    }
+    xSemaphoreGive(_fcache_mutex);
+
+    return res;
+}
+
+void vfs_fcache_stats_get(vfs_fcache_stats_t *stats)
+{
+    xSemaphoreTake(_fcache_mutex, portMAX_DELAY);
+    *stats = _fcache_stats;
+    xSemaphoreGive(_fcache_mutex);
+}
+
+void vfs_fcache_stats_reset(void)
+{
+    xSemaphoreTake(_fcache_mutex, portMAX_DELAY);
+    uint32_t bytes = _fcache_stats.bytes;
+    memset(&_fcache_stats, 0, sizeof(_fcache_stats));
+    _fcache_stats.bytes = bytes;
+    xSemaphoreGive(_fcache_mutex);
+}
+
+/* keep every object aligned like the memory returned by the heap */
+#define _SLAB_ALIGN(size) (((size) + portBYTE_ALIGNMENT - 1) & ~((size_t)portBYTE_ALIGNMENT - 1))
+
+static void _slab_init(vfs_slab_t *slab, size_t obj_size, unsigned numof)
+{
+    slab->chunks = NULL;
+    slab->free_list = NULL;
+    slab->obj_size = _SLAB_ALIGN(obj_size);
+    slab->numof = numof;
+    slab->capacity = 0;
+    slab->used = 0;
+}
+
+static void _slab_deinit(vfs_slab_t *slab)
+{
+    void *chunk = slab->chunks;
+    while (chunk != NULL) {
+        void *next = *(void **)chunk;
+        vPortFree(chunk);
+        chunk = next;
+    }
+    memset(slab, 0, sizeof(*slab));
+}
+
+/**
+ * @internal
+ * @brief Allocate the next chunk of a file slab and add its objects to the
+ *        free list
+ *
+ * @return true if the slab has grown, false if it is full or out of memory
+ */
+static bool _slab_grow(vfs_slab_t *slab)
+{
+    /* reserve the objects first, another task may be growing the slab too */
+    taskENTER_CRITICAL();
+    unsigned n = slab->numof - slab->capacity;
+    if (n > VFS_FILE_SLAB_CHUNK) {
+        n = VFS_FILE_SLAB_CHUNK;
+    }
+    slab->capacity += n;
+    taskEXIT_CRITICAL();
+
+    if (n == 0) {
+        return false;
+    }
+
+    /* the chunks are linked through their first word, before the objects */
+    const size_t header = _SLAB_ALIGN(sizeof(void *));
+    uint8_t *chunk = pvPortMalloc(header + n * slab->obj_size);
+    if (chunk == NULL) {
+        taskENTER_CRITICAL();
+        slab->capacity -= n;
+        taskEXIT_CRITICAL();
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    *(void **)(uintptr_t)chunk = slab->chunks;
+    slab->chunks = chunk;
+    /* link the free objects through their first word */
+    for (unsigned i = n; i > 0; i--) {
+        void **obj = (void **)(uintptr_t)&chunk[header + (i - 1) * slab->obj_size];
+        *obj = slab->free_list;
+        slab->free_list = obj;
+    }
+    taskEXIT_CRITICAL();
+
+    return true;
+}
+
+static void *_slab_alloc(vfs_slab_t *slab)
+{
+    void **obj;
+
+    do {
+        taskENTER_CRITICAL();
+        obj = slab->free_list;
+        if (obj != NULL) {
+            slab->free_list = *obj;
+            slab->used++;
+        }
+        taskEXIT_CRITICAL();
+    } while ((obj == NULL) && _slab_grow(slab));
+
+    if (obj != NULL) {
+        memset(obj, 0, slab->obj_size);
+    }
+    return obj;
+}
+
+static void _slab_free(vfs_slab_t *slab, void *obj)
+{
+    taskENTER_CRITICAL();
+    *(void **)obj = slab->free_list;
+    slab->free_list = obj;
+    slab->used--;
+    taskEXIT_CRITICAL();
+}
+
 static int _auto_mount(vfs_mount_t *mountp, unsigned i)
 {
     (void) i;
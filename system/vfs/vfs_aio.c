@@ -0,0 +1,433 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Balint Kardos
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/**
+ * @ingroup     system_vfs_aio
+ * @{
+ *
+ * @file        vfs_aio.c
+ * @brief       Asynchronous file I/O serviced by a pool of worker tasks
+ * @}
+ */
+#define ENABLE_DEBUG 0
+#include "debug.h"
+#include "vfs.h"
+#include "vfs_aio.h"
+#include "vfs_aio_config.h"
+#include "cli_config.h"
+#include "sdcard_config.h"
+#include "stdio_rx_config.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+static_assert(VFS_AIO_NOTIFY_INDEX < configTASK_NOTIFICATION_ARRAY_ENTRIES,
+              "VFS_AIO_NOTIFY_INDEX is not a valid task notification index");
+static_assert((VFS_AIO_NOTIFY_INDEX != CLI_RX_NOTIFY_INDEX) &&
+              (VFS_AIO_NOTIFY_INDEX != SDCARD_TASK_NOTIFICATION_INDEX) &&
+              (VFS_AIO_NOTIFY_INDEX != STDIO_RX_NOTIFY_INDEX) &&
+              (SDCARD_TASK_NOTIFICATION_INDEX != CLI_RX_NOTIFY_INDEX) &&
+              (SDCARD_TASK_NOTIFICATION_INDEX != STDIO_RX_NOTIFY_INDEX) &&
+              (STDIO_RX_NOTIFY_INDEX != CLI_RX_NOTIFY_INDEX),
+              "the task notification indexes must be distinct");
+
+enum {
+    VFS_AIO_STATE_IDLE = 0,
+    VFS_AIO_STATE_QUEUED,
+    VFS_AIO_STATE_RUNNING,
+    VFS_AIO_STATE_DONE,
+};
+
+static StackType_t _aio_task_stack[VFS_AIO_WORKERS_NUMOF][VFS_AIO_TASK_STACKSIZE];
+static StaticTask_t _aio_task_tcb[VFS_AIO_WORKERS_NUMOF];
+static TaskHandle_t h_aio_task[VFS_AIO_WORKERS_NUMOF];
+
+/* file descriptor being serviced by each worker, -1 if idle */
+static int _busy_fd[VFS_AIO_WORKERS_NUMOF];
+
+/* the worker found nothing to service and waits for a notification */
+static bool _idle[VFS_AIO_WORKERS_NUMOF];
+
+/* FIFO of queued requests, protected by critical sections */
+static vfs_aiocb_t *_queue_head;
+static vfs_aiocb_t *_queue_tail;
+static unsigned _queue_len;
+
+static void _aio_task(void *params);
+
+void vfs_aio_init(void)
+{
+    for (unsigned i = 0; i < VFS_AIO_WORKERS_NUMOF; i++) {
+        _busy_fd[i] = -1;
+        h_aio_task[i] = xTaskCreateStatic(_aio_task,
+                                          "VFS AIO",
+                                          VFS_AIO_TASK_STACKSIZE,
+                                          (void *)(uintptr_t)i,
+                                          VFS_AIO_TASK_PRIORITY,
+                                          _aio_task_stack[i],
+                                          &_aio_task_tcb[i]);
+        assert(h_aio_task[i]);
+    }
+}
+
+/* must be called in a critical section */
+static void _wake_worker(void)
+{
+    for (unsigned i = 0; i < VFS_AIO_WORKERS_NUMOF; i++) {
+        if (_idle[i]) {
+            _idle[i] = false;
+            xTaskNotifyGive(h_aio_task[i]);
+            return;
+        }
+    }
+}
+
+static bool _fd_is_busy(int fd)
+{
+    for (unsigned i = 0; i < VFS_AIO_WORKERS_NUMOF; i++) {
+        if (_busy_fd[i] == fd) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* must be called in a critical section */
+static bool _has_ready(void)
+{
+    for (vfs_aiocb_t *cb = _queue_head; cb != NULL; cb = cb->next) {
+        if (!_fd_is_busy(cb->fd)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* must be called in a critical section */
+static void _unlink(vfs_aiocb_t *cb, vfs_aiocb_t *prev)
+{
+    if (prev == NULL) {
+        _queue_head = cb->next;
+    }
+    else {
+        prev->next = cb->next;
+    }
+    if (_queue_tail == cb) {
+        _queue_tail = prev;
+    }
+    cb->next = NULL;
+    _queue_len--;
+}
+
+/**
+ * @brief   Takes the oldest request whose file descriptor is not serviced by
+ *          another worker, the earlier requests on the same file descriptor
+ *          are ahead of it in the queue, so the order per file is kept.
+ *          Must be called in a critical section.
+ */
+static vfs_aiocb_t *_dequeue(void)
+{
+    vfs_aiocb_t *prev = NULL;
+
+    for (vfs_aiocb_t *cb = _queue_head; cb != NULL; prev = cb, cb = cb->next) {
+        if (!_fd_is_busy(cb->fd)) {
+            _unlink(cb, prev);
+            return cb;
+        }
+    }
+    return NULL;
+}
+
+static int _submit(vfs_aiocb_t *cb, vfs_aio_op_t op)
+{
+    if (cb == NULL) {
+        return -EINVAL;
+    }
+    if ((op != VFS_AIO_OP_FSYNC) && (cb->buf == NULL) && (cb->nbytes > 0)) {
+        return -EINVAL;
+    }
+    assert(h_aio_task[0]);
+
+    taskENTER_CRITICAL();
+    if ((cb->state == VFS_AIO_STATE_QUEUED) || (cb->state == VFS_AIO_STATE_RUNNING)) {
+        taskEXIT_CRITICAL();
+        return -EBUSY;
+    }
+    if (_queue_len >= VFS_AIO_QUEUE_LENGTH) {
+        taskEXIT_CRITICAL();
+        return -EAGAIN;
+    }
+    taskEXIT_CRITICAL();
+
+    /* nobody else uses the control block until it is queued */
+    cb->op = op;
+    cb->next = NULL;
+    cb->result = -EINPROGRESS;
+    if (cb->state == VFS_AIO_STATE_IDLE) {
+        cb->done = xSemaphoreCreateBinaryStatic(&cb->done_storage);
+        assert(cb->done);
+    }
+    else {
+        /* done before, the previous completion may still be given */
+        xSemaphoreTake(cb->done, 0);
+    }
+
+    taskENTER_CRITICAL();
+    if (_queue_len >= VFS_AIO_QUEUE_LENGTH) {
+        taskEXIT_CRITICAL();
+        return -EAGAIN;
+    }
+    cb->state = VFS_AIO_STATE_QUEUED;
+    if (_queue_tail == NULL) {
+        _queue_head = cb;
+    }
+    else {
+        _queue_tail->next = cb;
+    }
+    _queue_tail = cb;
+    _queue_len++;
+    if (!_fd_is_busy(cb->fd)) {
+        _wake_worker();
+    }
+    taskEXIT_CRITICAL();
+
+    DEBUG("vfs_aio: queued %p op %d fd %d\n", (void *)cb, (int)op, cb->fd);
+
+    return 0;
+}
+
+int vfs_aio_read(vfs_aiocb_t *cb)
+{
+    return _submit(cb, VFS_AIO_OP_READ);
+}
+
+int vfs_aio_write(vfs_aiocb_t *cb)
+{
+    return _submit(cb, VFS_AIO_OP_WRITE);
+}
+
+int vfs_aio_fsync(vfs_aiocb_t *cb)
+{
+    return _submit(cb, VFS_AIO_OP_FSYNC);
+}
+
+static ssize_t _execute(vfs_aiocb_t *cb)
+{
+    if (cb->op == VFS_AIO_OP_FSYNC) {
+        return vfs_fsync(cb->fd);
+    }
+
+    if (cb->offset != VFS_AIO_OFFSET_CURRENT) {
+        off_t pos = vfs_lseek(cb->fd, cb->offset, SEEK_SET);
+        if (pos < 0) {
+            return pos;
+        }
+    }
+
+    uint8_t *buf = cb->buf;
+    size_t total = 0;
+
+    while (total < cb->nbytes) {
+        ssize_t res;
+        if (cb->op == VFS_AIO_OP_READ) {
+            res = vfs_read(cb->fd, buf + total, cb->nbytes - total);
+        }
+        else {
+            res = vfs_write(cb->fd, buf + total, cb->nbytes - total);
+        }
+        if (res < 0) {
+            return (total > 0) ? (ssize_t)total : res;
+        }
+        if (res == 0) {
+            /* end of file or no space left */
+            break;
+        }
+        total += res;
+    }
+
+    return total;
+}
+
+/**
+ * @brief   Stores the result and reports the completion, nothing touches
+ *          the control block once it is marked done
+ */
+static void _complete(vfs_aiocb_t *cb, ssize_t result)
+{
+    cb->result = result;
+
+    if (cb->callback != NULL) {
+        cb->callback(cb);
+    }
+
+    taskENTER_CRITICAL();
+    TaskHandle_t notify = cb->notify;
+    cb->state = VFS_AIO_STATE_DONE;
+    xSemaphoreGive(cb->done);
+    if (notify != NULL) {
+        xTaskNotifyGiveIndexed(notify, VFS_AIO_NOTIFY_INDEX);
+    }
+    taskEXIT_CRITICAL();
+}
+
+static void _aio_task(void *params)
+{
+    const unsigned id = (unsigned)(uintptr_t)params;
+
+    for ( ;; ) {
+        taskENTER_CRITICAL();
+        vfs_aiocb_t *cb = _dequeue();
+        if (cb != NULL) {
+            cb->state = VFS_AIO_STATE_RUNNING;
+            _busy_fd[id] = cb->fd;
+            /* the request that just finished may have unblocked another */
+            if (_has_ready()) {
+                _wake_worker();
+            }
+        }
+        else {
+            _idle[id] = true;
+        }
+        taskEXIT_CRITICAL();
+
+        if (cb == NULL) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        DEBUG("vfs_aio: worker %u runs %p\n", id, (void *)cb);
+
+        _complete(cb, _execute(cb));
+
+        taskENTER_CRITICAL();
+        _busy_fd[id] = -1;
+        taskEXIT_CRITICAL();
+    }
+}
+
+ssize_t vfs_aio_return(const vfs_aiocb_t *cb)
+{
+    if ((cb == NULL) || (cb->state == VFS_AIO_STATE_IDLE)) {
+        return -EINVAL;
+    }
+    if (cb->state != VFS_AIO_STATE_DONE) {
+        return -EINPROGRESS;
+    }
+    return cb->result;
+}
+
+ssize_t vfs_aio_wait(vfs_aiocb_t *cb, TickType_t timeout)
+{
+    if ((cb == NULL) || (cb->state == VFS_AIO_STATE_IDLE)) {
+        return -EINVAL;
+    }
+    if (xSemaphoreTake(cb->done, timeout) != pdTRUE) {
+        return -ETIMEDOUT;
+    }
+    /* let a later wait on the same request return at once */
+    xSemaphoreGive(cb->done);
+    return cb->result;
+}
+
+int vfs_aio_cancel(vfs_aiocb_t *cb)
+{
+    if (cb == NULL) {
+        return -EINVAL;
+    }
+
+    taskENTER_CRITICAL();
+    if (cb->state != VFS_AIO_STATE_QUEUED) {
+        int res = (cb->state == VFS_AIO_STATE_RUNNING) ? -EINPROGRESS : -EALREADY;
+        taskEXIT_CRITICAL();
+        return res;
+    }
+    vfs_aiocb_t *prev = NULL;
+    for (vfs_aiocb_t *it = _queue_head; it != cb; it = it->next) {
+        prev = it;
+    }
+    _unlink(cb, prev);
+    cb->state = VFS_AIO_STATE_RUNNING;
+    taskEXIT_CRITICAL();
+
+    _complete(cb, -ECANCELED);
+
+    return 0;
+}
+
+static bool _is_worker(TaskHandle_t task)
+{
+    for (unsigned i = 0; i < VFS_AIO_WORKERS_NUMOF; i++) {
+        if (h_aio_task[i] == task) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int vfs_aio_cancel_fd(int fd)
+{
+    int count = 0;
+
+    for ( ;; ) {
+        taskENTER_CRITICAL();
+        vfs_aiocb_t *prev = NULL;
+        vfs_aiocb_t *cb = _queue_head;
+        while ((cb != NULL) && (cb->fd != fd)) {
+            prev = cb;
+            cb = cb->next;
+        }
+        if (cb != NULL) {
+            _unlink(cb, prev);
+            cb->state = VFS_AIO_STATE_RUNNING;
+        }
+        taskEXIT_CRITICAL();
+
+        if (cb == NULL) {
+            break;
+        }
+
+        _complete(cb, -ECANCELED);
+        count++;
+    }
+
+    /* a callback runs in a worker, it would wait for itself */
+    if (!_is_worker(xTaskGetCurrentTaskHandle())) {
+        for ( ;; ) {
+            taskENTER_CRITICAL();
+            bool busy = _fd_is_busy(fd);
+            taskEXIT_CRITICAL();
+            if (!busy) {
+                break;
+            }
+            vTaskDelay(1);
+        }
+    }
+
+    return count;
+}
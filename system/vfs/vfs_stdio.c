@@ -32,6 +32,7 @@
 
 #include "assert.h"
 #include "stdio_base.h"
+#include "stdio_rx.h"
 #include "vfs.h"
 
 static ssize_t _stdio_read(vfs_file_t *filp, void *dest, size_t nbytes)
@@ -40,7 +41,7 @@ static ssize_t _stdio_read(vfs_file_t *filp, void *dest, size_t nbytes)
     if (fd != STDIN_FILENO) {
         return -EBADF;
     }
-    return stdio_read(dest, nbytes);
+    return stdio_rx_read(dest, nbytes, (filp->flags & O_NONBLOCK) != 0);
 }
 
 static ssize_t _stdio_write(vfs_file_t *filp, const void *src, size_t nbytes)
@@ -52,10 +53,25 @@ static ssize_t _stdio_write(vfs_file_t *filp, const void *src, size_t nbytes)
     return stdio_write(src, nbytes);
 }
 
+static int _stdio_fcntl(vfs_file_t *filp, int cmd, int arg)
+{
+    int fd = filp->private_data.value;
+    if (cmd != F_SETFL) {
+        return -EINVAL;
+    }
+    /* only the blocking mode can be changed */
+    filp->flags = (filp->flags & ~O_NONBLOCK) | (arg & O_NONBLOCK);
+    if (fd == STDIN_FILENO) {
+        stdio_rx_set_nonblock((arg & O_NONBLOCK) != 0);
+    }
+    return 0;
+}
+
 /**
  * @brief   VFS file operation table for stdin/stdout/stderr
  */
 static vfs_file_ops_t _stdio_ops = {
+    .fcntl = _stdio_fcntl,
     .read = _stdio_read,
     .write = _stdio_write,
 };